@@ -73,6 +73,16 @@ win32 {
         windows/mainicon.ico
 }
 
+# protocol parser fuzzing target (libFuzzer, AFL with its libFuzzer driver),
+# use: qmake "CONFIG+=protocol_fuzzer" with clang
+contains(CONFIG, "protocol_fuzzer") {
+    message(Protocol parser fuzzing target.)
+
+    DEFINES += PROTOCOL_FUZZER
+    QMAKE_CXXFLAGS += -fsanitize=fuzzer,address
+    QMAKE_LFLAGS += -fsanitize=fuzzer,address
+}
+
 RCC_DIR = src/res
 RESOURCES += src/resources.qrc
 
@@ -89,8 +99,10 @@ HEADERS += src/audiomixerboard.h \
     src/chatdlg.h \
     src/client.h \
     src/clientsettingsdlg.h \
+    src/headlessclient.h \
     src/connectdlg.h \
     src/global.h \
+    src/loadgenerator.h \
     src/clientdlg.h \
     src/serverdlg.h \
     src/multicolorled.h \
@@ -102,6 +114,7 @@ HEADERS += src/audiomixerboard.h \
     src/settings.h \
     src/socket.h \
     src/soundbase.h \
+    src/soundfile.h \
     src/testbench.h \
     src/util.h \
     src/analyzerconsole.h \
@@ -199,9 +212,11 @@ SOURCES += src/audiomixerboard.cpp \
     src/chatdlg.cpp \
     src/client.cpp \
     src/clientsettingsdlg.cpp \
+    src/headlessclient.cpp \
     src/connectdlg.cpp \
     src/clientdlg.cpp \
     src/serverdlg.cpp \
+    src/loadgenerator.cpp \
     src/main.cpp \
     src/multicolorled.cpp \
     src/multicolorledbar.cpp \
@@ -212,6 +227,7 @@ SOURCES += src/audiomixerboard.cpp \
     src/settings.cpp \
     src/socket.cpp \
     src/soundbase.cpp \
+    src/soundfile.cpp \
     src/util.cpp \
     src/analyzerconsole.cpp \
     libs/celt/cc6_bands.c \
@@ -207,7 +207,7 @@ int CSound::Init ( const int /* iNewPrefMonoBufferSize */ )
     iJACKBufferSizeStero = 2 * iJACKBufferSizeMono;
 
     // create memory for intermediate audio buffer
-    vecsTmpAudioSndCrdStereo.Init ( iJACKBufferSizeStero );
+    vecfTmpAudioSndCrdStereo.Init ( iJACKBufferSizeStero );
 
     return iJACKBufferSizeMono;
 }
@@ -230,18 +230,15 @@ int CSound::process ( jack_nframes_t nframes, void* arg )
             (jack_default_audio_sample_t*) jack_port_get_buffer (
             pSound->input_port_right, nframes );
 
-        // copy input data
+        // copy input data (JACK uses float samples, no conversion required)
         for ( i = 0; i < pSound->iJACKBufferSizeMono; i++ )
         {
-            pSound->vecsTmpAudioSndCrdStereo[2 * i] =
-                (short) ( in_left[i] * _MAXSHORT );
-
-            pSound->vecsTmpAudioSndCrdStereo[2 * i + 1] =
-                (short) ( in_right[i] * _MAXSHORT );
+            pSound->vecfTmpAudioSndCrdStereo[2 * i]     = in_left[i];
+            pSound->vecfTmpAudioSndCrdStereo[2 * i + 1] = in_right[i];
         }
 
         // call processing callback function
-        pSound->ProcessCallback ( pSound->vecsTmpAudioSndCrdStereo );
+        pSound->ProcessCallback ( pSound->vecfTmpAudioSndCrdStereo );
 
         // get output data pointer
         jack_default_audio_sample_t* out_left =
@@ -255,11 +252,8 @@ int CSound::process ( jack_nframes_t nframes, void* arg )
         // copy output data
         for ( i = 0; i < pSound->iJACKBufferSizeMono; i++ )
         {
-            out_left[i] = (jack_default_audio_sample_t)
-                pSound->vecsTmpAudioSndCrdStereo[2 * i] / _MAXSHORT;
-
-            out_right[i] = (jack_default_audio_sample_t)
-                pSound->vecsTmpAudioSndCrdStereo[2 * i + 1] / _MAXSHORT;
+            out_left[i]  = pSound->vecfTmpAudioSndCrdStereo[2 * i];
+            out_right[i] = pSound->vecfTmpAudioSndCrdStereo[2 * i + 1];
         }
     }
     else
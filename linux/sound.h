@@ -58,7 +58,7 @@
 class CSound : public CSoundBase
 {
 public:
-    CSound ( void (*fpNewProcessCallback) ( CVector<short>& psData, void* arg ), void* arg ) :
+    CSound ( void (*fpNewProcessCallback) ( CVector<float>& vecfData, void* arg ), void* arg ) :
         CSoundBase ( "Jack", true, fpNewProcessCallback, arg ), iJACKBufferSizeMono ( 0 ),
         iJACKBufferSizeStero ( 0 ) { OpenJack(); }
     virtual ~CSound() { CloseJack(); }
@@ -69,7 +69,7 @@ public:
 
     // these variables should be protected but cannot since we want
     // to access them from the callback function
-    CVector<short> vecsTmpAudioSndCrdStereo;
+    CVector<float> vecfTmpAudioSndCrdStereo;
     int            iJACKBufferSizeMono;
     int            iJACKBufferSizeStero;
 
@@ -93,7 +93,7 @@ protected:
 class CSound : public CSoundBase
 {
 public:
-    CSound ( void (*fpNewProcessCallback) ( CVector<short>& psData, void* pParg ), void* pParg ) :
+    CSound ( void (*fpNewProcessCallback) ( CVector<float>& vecfData, void* pParg ), void* pParg ) :
         CSoundBase ( "nosound", false, fpNewProcessCallback, pParg ) {}
     virtual ~CSound() {}
 };
@@ -26,18 +26,19 @@
 
 
 /* Implementation *************************************************************/
-CSound::CSound ( void (*fpNewProcessCallback) ( CVector<short>& psData, void* arg ), void* arg ) :
+CSound::CSound ( void (*fpNewProcessCallback) ( CVector<float>& vecfData, void* arg ), void* arg ) :
     CSoundBase ( "CoreAudio", true, fpNewProcessCallback, arg )
 {
-    // set up stream format
+    // set up stream format (interleaved float samples as used by the audio
+    // processing so that no conversion is required in the callbacks)
     streamFormat.mSampleRate       = SYSTEM_SAMPLE_RATE_HZ;
     streamFormat.mFormatID         = kAudioFormatLinearPCM;
-    streamFormat.mFormatFlags      = kAudioFormatFlagIsSignedInteger;
+    streamFormat.mFormatFlags      = kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked;
     streamFormat.mFramesPerPacket  = 1;
-    streamFormat.mBytesPerFrame    = 4;
-    streamFormat.mBytesPerPacket   = 4;
+    streamFormat.mBytesPerFrame    = 8;
+    streamFormat.mBytesPerPacket   = 8;
     streamFormat.mChannelsPerFrame = 2; // stereo
-    streamFormat.mBitsPerChannel   = 16;
+    streamFormat.mBitsPerChannel   = 32;
 
     // set up a callback struct for new input data
     inputCallbackStruct.inputProc       = processInput;
@@ -437,13 +438,13 @@ int CSound::Init ( const int iNewPrefMonoBufferSize )
     iCoreAudioBufferSizeStero = 2 * iCoreAudioBufferSizeMono;
 
     // create memory for intermediate audio buffer
-    vecsTmpAudioSndCrdStereo.Init ( iCoreAudioBufferSizeStero );
+    vecfTmpAudioSndCrdStereo.Init ( iCoreAudioBufferSizeStero );
 
     // fill audio unit buffer struct
     pBufferList->mNumberBuffers              = 1;
     pBufferList->mBuffers[0].mNumberChannels = 2; // stereo
-    pBufferList->mBuffers[0].mDataByteSize   = iCoreAudioBufferSizeMono * 4; // 2 bytes, 2 channels
-    pBufferList->mBuffers[0].mData           = &vecsTmpAudioSndCrdStereo[0];
+    pBufferList->mBuffers[0].mDataByteSize   = iCoreAudioBufferSizeMono * 8; // 4 bytes, 2 channels
+    pBufferList->mBuffers[0].mData           = &vecfTmpAudioSndCrdStereo[0];
 
     // initialize units
     if ( AudioUnitInitialize ( audioInputUnit ) )
@@ -524,7 +525,7 @@ OSStatus CSound::processInput ( void*                       inRefCon,
                       pSound->pBufferList );
 
     // call processing callback function
-    pSound->ProcessCallback ( pSound->vecsTmpAudioSndCrdStereo );
+    pSound->ProcessCallback ( pSound->vecfTmpAudioSndCrdStereo );
 
     return noErr;
 }
@@ -541,7 +542,7 @@ OSStatus CSound::processOutput ( void*                       inRefCon,
     QMutexLocker locker ( &pSound->Mutex );
 
     memcpy ( ioData->mBuffers[0].mData,
-        &pSound->vecsTmpAudioSndCrdStereo[0],
+        &pSound->vecfTmpAudioSndCrdStereo[0],
         pSound->pBufferList->mBuffers[0].mDataByteSize);
 
     return noErr;
@@ -38,7 +38,7 @@
 class CSound : public CSoundBase
 {
 public:
-    CSound ( void (*fpNewProcessCallback) ( CVector<short>& psData, void* arg ), void* arg );
+    CSound ( void (*fpNewProcessCallback) ( CVector<float>& vecfData, void* arg ), void* arg );
     virtual ~CSound() { CloseCoreAudio(); }
 
     virtual int  Init ( const int iNewPrefMonoBufferSize );
@@ -47,7 +47,7 @@ public:
 
     // these variables should be protected but cannot since we want
     // to access them from the callback function
-    CVector<short> vecsTmpAudioSndCrdStereo;
+    CVector<float> vecfTmpAudioSndCrdStereo;
     int            iCoreAudioBufferSizeMono;
     int            iCoreAudioBufferSizeStero;
 
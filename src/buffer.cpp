@@ -150,6 +150,10 @@ void CNetBufWithStats::Init ( const int  iNewBlockSize,
             ErrorRateStatistic[i].Init ( MAX_STATISTIC_COUNT, true );
         }
 
+        // the statistic counts put and get operations whereas the arrival
+        // time statistic is only updated on put
+        ArrivalTimeStatistic.Init ( MAX_STATISTIC_COUNT / 2 );
+
         // start initialization phase of IIR filtering, use a quarter the size
         // of the error rate statistic buffers which should be ok for a good
         // initialization value (initialization phase should be as short as
@@ -180,6 +184,19 @@ bool CNetBufWithStats::Put ( const CVector<uint8_t>& vecbyData,
     return bPutOK;
 }
 
+bool CNetBufWithStats::Put ( const CVector<uint8_t>& vecbyData,
+                             const int               iInSize,
+                             const int64_t           iRecTimeNs )
+{
+    // update the inter-arrival time statistic, one network packet may
+    // contain more than one block (the nominal cycle time is the duration
+    // of all blocks in the packet)
+    ArrivalTimeStatistic.Update ( iRecTimeNs,
+        SYSTEM_BLOCK_DURATION_MS_FLOAT * iInSize / iBlockSize );
+
+    return Put ( vecbyData, iInSize );
+}
+
 bool CNetBufWithStats::Get ( CVector<uint8_t>& vecbyData )
 {
     // call base class Get
@@ -225,6 +242,34 @@ void CNetBufWithStats::UpdateAutoSetting()
     }
 
 
+    // Arrival time jitter decision --------------------------------------------
+    // The simulation buffers only see the time when we process the packets
+    // which includes the delay of our own event loop. The inter-arrival time
+    // statistic is based on the receive time stamps of the packets. The
+    // buffer must at least be able to absorb twice the RMS jitter of the
+    // inter-arrival time plus the block which is currently read. The RMS
+    // jitter is the root mean square deviation from the nominal block
+    // interval (and not from the mean interval), therefore a constant clock
+    // drift between the peers increases the buffer, too.
+    if ( ArrivalTimeStatistic.InitializationState() >= 1.0 )
+    {
+        const int iJitterDecision = static_cast<int> ( ceil (
+            2 * ArrivalTimeStatistic.GetRmsJitterMs() /
+            SYSTEM_BLOCK_DURATION_MS_FLOAT ) ) + 1;
+
+        if ( iJitterDecision > iCurDecision )
+        {
+            iCurDecision = iJitterDecision;
+
+            // limit to the largest buffer size
+            if ( iCurDecision > viBufSizesForSim[NUM_STAT_SIMULATION_BUFFERS - 1] )
+            {
+                iCurDecision = viBufSizesForSim[NUM_STAT_SIMULATION_BUFFERS - 1];
+            }
+        }
+    }
+
+
     // Post calculation (filtering) --------------------------------------------
     // Define different weigths for up and down direction. Up direction
     // filtering shall be slower than for down direction since we assume
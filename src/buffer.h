@@ -25,6 +25,7 @@
 #if !defined ( BUFFER_H__3B123453_4344_BB23945IUHF1912__INCLUDED_ )
 #define BUFFER_H__3B123453_4344_BB23945IUHF1912__INCLUDED_
 
+#include <QAtomicInt>
 #include "util.h"
 #include "global.h"
 
@@ -399,8 +400,14 @@ public:
     virtual bool Put ( const CVector<uint8_t>& vecbyData, const int iInSize );
     virtual bool Get ( CVector<uint8_t>& vecbyData );
 
+    // put with the receive time stamp of the network packet (in ns)
+    bool Put ( const CVector<uint8_t>& vecbyData,
+               const int               iInSize,
+               const int64_t           iRecTimeNs );
+
     int GetAutoSetting() { return iCurAutoBufferSizeSetting; }
     void GetErrorRates ( CVector<double>& vecErrRates, double& dLimit );
+    double GetArrivalTimeRmsJitterMs() { return ArrivalTimeStatistic.GetRmsJitterMs(); }
 
 protected:
     void UpdateAutoSetting();
@@ -411,6 +418,9 @@ protected:
     CNetBuf    SimulationBuffer[NUM_STAT_SIMULATION_BUFFERS];
     int        viBufSizesForSim[NUM_STAT_SIMULATION_BUFFERS];
 
+    // packet inter-arrival time statistic
+    CCycleTimeVariance ArrivalTimeStatistic;
+
     double     dCurIIRFilterResult;
     int        iCurDecidedResult;
     int        iInitCounter;
@@ -467,7 +477,42 @@ public:
         }
     }
 
-    CVector<TData> Get()
+    // Direct access to the buffer memory: the data of the given size can be
+    // written at the returned position (NULL on buffer overrun or if not
+    // initialized), afterwards "PutInPlace" must be called to update the
+    // buffer state.
+    TData* GetPutPointer ( const int iVecSize )
+    {
+        if ( ( iVecSize > 0 ) && ( iPutPos + iVecSize <= iMemSize ) )
+        {
+            return &vecsMemory[iPutPos];
+        }
+        else
+        {
+            return NULL;
+        }
+    }
+
+    bool PutInPlace ( const int iVecSize )
+    {
+        const int iEnd = iPutPos + iVecSize;
+
+        // first check for buffer overrun
+        if ( iEnd <= iMemSize )
+        {
+            iPutPos = iEnd;
+
+            // return "buffer is ready for readout" flag
+            return ( iEnd == iMemSize );
+        }
+        else
+        {
+            // buffer overrun or not initialized, return "not ready"
+            return false;
+        }
+    }
+
+    const CVector<TData>& Get()
     {
         iPutPos = 0;
         return vecsMemory;
@@ -479,4 +524,107 @@ protected:
     int            iPutPos;
 };
 
+
+// Wait-free buffer (single producer, single consumer) -------------------------
+// Exactly one thread puts and exactly one other thread gets data. Each side
+// only writes its own position and publishes it atomically so that no side
+// ever waits for the other one (e.g. for transferring audio data out of the
+// real-time audio callback). One element is always left unused to distinguish
+// a full from an empty buffer. "Init" must not be called while the buffer is
+// in use.
+template<class TData> class CWaitFreeBuffer
+{
+public:
+    CWaitFreeBuffer() : iMemSize ( 1 ), iPutPos ( 0 ), iGetPos ( 0 ) {}
+
+    void Init ( const int iNewMaxNumData )
+    {
+        iMemSize = iNewMaxNumData + 1;
+        vecMemory.Init ( iMemSize );
+        AtomicStoreRelease ( iPutPos, 0 );
+        AtomicStoreRelease ( iGetPos, 0 );
+    }
+
+    int GetAvailData() const
+    {
+        const int iAvData = AtomicLoadAcquire ( iPutPos ) -
+                            AtomicLoadAcquire ( iGetPos );
+        return iAvData < 0 ? iAvData + iMemSize : iAvData;
+    }
+
+    int GetAvailSpace() const { return iMemSize - 1 - GetAvailData(); }
+
+    // producer side (returns false if there is not enough space)
+    bool Put ( const TData* pData, const int iNumData )
+    {
+        // only the producer changes the put position
+        const int iCurPutPos = AtomicLoadRelaxed ( iPutPos );
+
+        if ( iNumData > GetAvailSpace() )
+        {
+            return false;
+        }
+
+        int iPos = iCurPutPos;
+
+        for ( int i = 0; i < iNumData; i++ )
+        {
+            vecMemory[iPos] = pData[i];
+
+            if ( ++iPos == iMemSize )
+            {
+                iPos = 0;
+            }
+        }
+
+        // publish the new data
+        AtomicStoreRelease ( iPutPos, iPos );
+        return true;
+    }
+
+    // consumer side (returns false if there is not enough data)
+    bool Get ( TData* pData, const int iNumData )
+    {
+        // only the consumer changes the get position
+        const int iCurGetPos = AtomicLoadRelaxed ( iGetPos );
+
+        if ( iNumData > GetAvailData() )
+        {
+            return false;
+        }
+
+        int iPos = iCurGetPos;
+
+        for ( int i = 0; i < iNumData; i++ )
+        {
+            pData[i] = vecMemory[iPos];
+
+            if ( ++iPos == iMemSize )
+            {
+                iPos = 0;
+            }
+        }
+
+        // release the memory for the producer
+        AtomicStoreRelease ( iGetPos, iPos );
+        return true;
+    }
+
+    // consumer side, drops data without reading it
+    void Skip ( const int iNumData )
+    {
+        if ( iNumData <= GetAvailData() )
+        {
+            AtomicStoreRelease ( iGetPos,
+                ( AtomicLoadRelaxed ( iGetPos ) + iNumData ) % iMemSize );
+        }
+    }
+
+protected:
+    CVector<TData> vecMemory;
+    int            iMemSize;
+    QAtomicInt     iPutPos;
+    QAtomicInt     iGetPos;
+};
+
 #endif /* !defined ( BUFFER_H__3B123453_4344_BB23945IUHF1912__INCLUDED_ ) */
@@ -25,23 +25,261 @@
 #include "channel.h"
 
 
+// CChannelGainMatrix implementation *******************************************
+CChannelGainMatrix::CChannelGainMatrix() :
+    pPublished      ( new CVector<double> ( MAX_NUM_CHANNELS * MAX_NUM_CHANNELS,
+                                            (double) 1.0 ) ),
+    pReaderSnapshot ( NULL )
+{
+}
+
+CChannelGainMatrix::~CChannelGainMatrix()
+{
+    delete AtomicLoadRelaxed ( pPublished );
+
+    while ( !RetiredMatrices.empty() )
+    {
+        delete RetiredMatrices.front();
+        RetiredMatrices.pop_front();
+    }
+}
+
+void CChannelGainMatrix::SetGain ( const int    iChanID,
+                                   const int    iOtherChanID,
+                                   const double dNewGain )
+{
+    QMutexLocker locker ( &Mutex );
+
+    // set value (make sure channel IDs are in range)
+    if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) &&
+         ( iOtherChanID >= 0 ) && ( iOtherChanID < MAX_NUM_CHANNELS ) )
+    {
+        CVector<double>* pNewMatrix = new CVector<double> ( *AtomicLoadRelaxed ( pPublished ) );
+
+        ( *pNewMatrix )[iChanID * MAX_NUM_CHANNELS + iOtherChanID] = dNewGain;
+
+        Publish ( pNewMatrix );
+    }
+}
+
+void CChannelGainMatrix::ResetGains ( const int iChanID )
+{
+    QMutexLocker locker ( &Mutex );
+
+    if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) )
+    {
+        CVector<double>* pNewMatrix = new CVector<double> ( *AtomicLoadRelaxed ( pPublished ) );
+
+        // reset the gains of the channel and the gains of this channel ID for
+        // all other channels
+        for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+        {
+            ( *pNewMatrix )[iChanID * MAX_NUM_CHANNELS + i] = (double) 1.0;
+            ( *pNewMatrix )[i * MAX_NUM_CHANNELS + iChanID] = (double) 1.0;
+        }
+
+        Publish ( pNewMatrix );
+    }
+}
+
+double CChannelGainMatrix::GetGain ( const int iChanID,
+                                     const int iOtherChanID )
+{
+    // only the writers delete matrices, therefore the published matrix is
+    // valid while we hold the mutex
+    QMutexLocker locker ( &Mutex );
+
+    // get value (make sure channel IDs are in range)
+    if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) &&
+         ( iOtherChanID >= 0 ) && ( iOtherChanID < MAX_NUM_CHANNELS ) )
+    {
+        return GetGain ( *AtomicLoadRelaxed ( pPublished ), iChanID, iOtherChanID );
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+const CVector<double>& CChannelGainMatrix::AcquireSnapshot()
+{
+    CVector<double>* pSnapshot;
+    CVector<double>* pCurPublished = AtomicLoadAcquire ( pPublished );
+
+    // announce the snapshot we are using and check that it was not replaced
+    // in the meantime, otherwise a writer might not have seen our
+    // announcement before deleting it (the ordered exchange is a full memory
+    // barrier)
+    do
+    {
+        pSnapshot = pCurPublished;
+
+        pReaderSnapshot.fetchAndStoreOrdered ( pSnapshot );
+
+        pCurPublished = AtomicLoadAcquire ( pPublished );
+    }
+    while ( pCurPublished != pSnapshot );
+
+    return *pSnapshot;
+}
+
+void CChannelGainMatrix::Publish ( CVector<double>* pNewMatrix )
+{
+/*
+    note: this function must be called inside the mutex region
+*/
+    // replace the published matrix, the old one is retired
+    RetiredMatrices.push_back ( pPublished.fetchAndStoreOrdered ( pNewMatrix ) );
+
+    // delete all retired matrices which are not used by the reader
+    CVector<double>* pCurReaderSnapshot = AtomicLoadAcquire ( pReaderSnapshot );
+
+    std::list<CVector<double>*>::iterator it = RetiredMatrices.begin();
+
+    while ( it != RetiredMatrices.end() )
+    {
+        if ( *it != pCurReaderSnapshot )
+        {
+            delete *it;
+            it = RetiredMatrices.erase ( it );
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+
+// CChannelTimeOutWheel implementation *****************************************
+CChannelTimeOutWheel::CChannelTimeOutWheel() :
+    iNextTick ( 0 )
+{
+    // the monotonic clock of the wheel starts with tick zero
+    ElapsedTimer.start();
+
+
+    // Connections -------------------------------------------------------------
+    QObject::connect ( &Timer, SIGNAL ( timeout() ),
+        this, SLOT ( OnTimer() ) );
+
+    Timer.start ( CON_TIME_OUT_WHEEL_TICK_MS );
+}
+
+void CChannelTimeOutWheel::Insert ( CChannel* pChannel )
+{
+    QMutexLocker locker ( &Mutex );
+
+    // a channel must only be once in the wheel (the number of entries is
+    // limited by the number of channels so that a search is cheap)
+    for ( int i = 0; i < CON_TIME_OUT_WHEEL_NUM_SLOTS; i++ )
+    {
+        std::list<CChannel*>::const_iterator it = vecSlots[i].begin();
+
+        for ( ; it != vecSlots[i].end(); ++it )
+        {
+            if ( *it == pChannel )
+            {
+                return;
+            }
+        }
+    }
+
+    InsertIntern ( pChannel, pChannel->GetConTimeOutTick() );
+}
+
+void CChannelTimeOutWheel::InsertIntern ( CChannel* pChannel,
+                                          const int iExpTick )
+{
+/*
+    note: this function must be called inside the mutex region
+*/
+    // an already passed expiry tick is evaluated in the next processed slot,
+    // an expiry tick more than one wheel turn ahead is evaluated again in
+    // each turn until it is due
+    int iSlotTick = iExpTick;
+
+    if ( iSlotTick < iNextTick )
+    {
+        iSlotTick = iNextTick;
+    }
+
+    vecSlots[iSlotTick % CON_TIME_OUT_WHEEL_NUM_SLOTS].push_back ( pChannel );
+}
+
+void CChannelTimeOutWheel::OnTimer()
+{
+    const int            iCurTick = GetCurTick();
+    std::list<CChannel*> ExpiredChannels;
+
+    Mutex.lock();
+    {
+        // process all slots which are due (the timer might be delayed so that
+        // more than one tick has to be processed)
+        while ( iNextTick <= iCurTick )
+        {
+            // take the channels out of the slot so that a channel which is
+            // re-armed one wheel turn ahead is not processed twice
+            std::list<CChannel*> SlotChannels;
+            SlotChannels.swap ( vecSlots[iNextTick % CON_TIME_OUT_WHEEL_NUM_SLOTS] );
+
+            std::list<CChannel*>::iterator it = SlotChannels.begin();
+
+            for ( ; it != SlotChannels.end(); ++it )
+            {
+                // a channel which was disabled in the meantime is dropped
+                if ( ( *it )->IsConnected() )
+                {
+                    const int iExpTick = ( *it )->GetConTimeOutTick();
+
+                    if ( iExpTick > iCurTick )
+                    {
+                        // audio packets were received, re-arm the channel
+                        InsertIntern ( *it, iExpTick );
+                    }
+                    else
+                    {
+                        ExpiredChannels.push_back ( *it );
+                    }
+                }
+            }
+
+            iNextTick++;
+        }
+    }
+    Mutex.unlock();
+
+    // disconnect the expired channels outside the mutex region since signals
+    // are emitted
+    std::list<CChannel*>::iterator it = ExpiredChannels.begin();
+
+    for ( ; it != ExpiredChannels.end(); ++it )
+    {
+        if ( !( *it )->TimeOut ( iCurTick ) )
+        {
+            // an audio packet was received just now
+            Insert ( *it );
+        }
+    }
+}
+
+
 // CChannel implementation *****************************************************
 CChannel::CChannel ( const bool bNIsServer ) :
-    vecdGains          ( MAX_NUM_CHANNELS, (double) 1.0 ),
+    iServerChanID      ( 0 ),
+    pGainMatrix        ( NULL ),
+    pHotState          ( NULL ),
     bDoAutoSockBufSize ( true ),
+    pTimeOutWheel      ( NULL ),
+    bIsConnected       ( false ),
+    iLastRecTick       ( 0 ),
     bIsEnabled         ( false ),
-    bIsServer          ( bNIsServer )
+    bIsServer          ( bNIsServer ),
+    bLocalMonitoring   ( false )
 {
     // reset network transport properties
     ResetNetworkTransportProperties();
-
-    // initial value for connection time out counter, we calculate the total
-    // number of samples here and subtract the number of samples of the block
-    // which we take out of the buffer to be independent of block sizes
-    iConTimeOutStartVal = CON_TIME_OUT_SEC_MAX * SYSTEM_SAMPLE_RATE_HZ;
-
-    // init time-out for the buffer with zero -> no connection
-    iConTimeOut = 0;
+    InitFec();
 
     // init the socket buffer
     SetSockBufNumFrames ( DEF_NET_BUF_SIZE_NUM_BL );
@@ -105,13 +343,19 @@ QObject::connect ( &Protocol,
         SIGNAL ( ReqNetTranspProps() ),
         this, SLOT ( OnReqNetTranspProps() ) );
 
-#ifdef ENABLE_RECEIVE_SOCKET_IN_SEPARATE_THREAD
+    QObject::connect ( &Protocol,
+        SIGNAL ( LocalMonitoringChanged ( bool ) ),
+        this, SLOT ( OnLocalMonitoringChanged ( bool ) ) );
+
+    QObject::connect ( &Protocol,
+        SIGNAL ( ProtFeaturesReceived() ),
+        SIGNAL ( ProtFeaturesReceived() ) );
+
     // this connection is intended for a thread transition if we have a
     // separate socket thread running
     QObject::connect ( this,
         SIGNAL ( ParseMessageBody ( CVector<uint8_t>, int, int ) ),
         this, SLOT ( OnParseMessageBody ( CVector<uint8_t>, int, int ) ) );
-#endif
 }
 
 bool CChannel::ProtocolIsEnabled()
@@ -137,18 +381,22 @@ void CChannel::SetEnable ( const bool bNEnStat )
     // set internal parameter
     bIsEnabled = bNEnStat;
 
-    // if channel is not enabled, reset time out count and protocol
+    // if channel is not enabled, reset connection state and protocol (the
+    // time-out wheel drops the channel on its next evaluation)
     if ( !bNEnStat )
     {
-        iConTimeOut = 0;
+        bIsConnected = false;
         Protocol.Reset();
     }
+
+    MarkHotStateChanged();
 }
 
 void CChannel::SetAudioStreamProperties ( const EAudComprType eNewAudComprType,
                                           const int iNewNetwFrameSize,
                                           const int iNewNetwFrameSizeFact,
-                                          const int iNewNumAudioChannels )
+                                          const int iNewNumAudioChannels,
+                                          const int iNewNetwFecNumBytes )
 {
 /*
     this function is intended for the server (not the client)
@@ -161,8 +409,19 @@ void CChannel::SetAudioStreamProperties ( const EAudComprType eNewAudComprType,
         // store new values
         eAudioCompressionType = eNewAudComprType;
         iNumAudioChannels     = iNewNumAudioChannels;
-        iNetwFrameSize        = iNewNetwFrameSize;
         iNetwFrameSizeFact    = iNewNetwFrameSizeFact;
+        iNetwFecNumBytes      = iNewNetwFecNumBytes;
+
+        // with forward error correction, the network frame additionally
+        // contains the redundant frame and the sequence number
+        if ( iNetwFecNumBytes > 0 )
+        {
+            iNetwFrameSize = iNewNetwFrameSize + iNetwFecNumBytes + 1;
+        }
+        else
+        {
+            iNetwFrameSize = iNewNetwFrameSize;
+        }
 
         // init socket buffer
         SockBuf.Init ( iNetwFrameSize, iCurSockBufNumFrames );
@@ -170,12 +429,16 @@ void CChannel::SetAudioStreamProperties ( const EAudComprType eNewAudComprType,
         // init conversion buffer
         ConvBuf.Init ( iNetwFrameSize * iNetwFrameSizeFact );
 
+        InitFec();
+
         // fill network transport properties struct
         NetworkTransportProps =
             GetNetworkTransportPropsFromCurrentSettings();
     }
     Mutex.unlock();
 
+    MarkHotStateChanged();
+
     // tell the server about the new network settings
     Protocol.CreateNetwTranspPropsMes ( NetworkTransportProps );
 }
@@ -232,23 +495,18 @@ bool CChannel::SetSockBufNumFrames ( const int  iNewNumFrames,
 void CChannel::SetGain ( const int    iChanID,
                          const double dNewGain )
 {
-    QMutexLocker locker ( &Mutex );
-
-    // set value (make sure channel ID is in range)
-    if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) )
+    // the gains are only used in the server which owns the matrix
+    if ( pGainMatrix != NULL )
     {
-        vecdGains[iChanID] = dNewGain;
+        pGainMatrix->SetGain ( iServerChanID, iChanID, dNewGain );
     }
 }
 
 double CChannel::GetGain ( const int iChanID )
 {
-    QMutexLocker locker ( &Mutex );
-
-    // get value (make sure channel ID is in range)
-    if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) )
+    if ( pGainMatrix != NULL )
     {
-        return vecdGains[iChanID];
+        return pGainMatrix->GetGain ( iServerChanID, iChanID );
     }
     else
     {
@@ -384,15 +642,33 @@ void CChannel::OnNetTranspPropsReceived ( CNetworkTransportProps NetworkTranspor
             iNetwFrameSize =
                 NetworkTransportProps.iBaseNetworkPacketSize;
 
+            // for OPUS the audio coder argument defines the size of the
+            // redundant frame for forward error correction, the remaining
+            // coded frame must still be usable
+            if ( ( eAudioCompressionType == CT_OPUS ) &&
+                 ( NetworkTransportProps.iAudioCodingArg >= CELT_MINIMUM_NUM_BYTES ) &&
+                 ( iNetwFrameSize - NetworkTransportProps.iAudioCodingArg - 1 >= CELT_MINIMUM_NUM_BYTES ) )
+            {
+                iNetwFecNumBytes = NetworkTransportProps.iAudioCodingArg;
+            }
+            else
+            {
+                iNetwFecNumBytes = 0;
+            }
+
             // update socket buffer (the network block size is a multiple of the
             // minimum network frame size
             SockBuf.Init ( iNetwFrameSize, iCurSockBufNumFrames );
 
             // init conversion buffer
             ConvBuf.Init ( iNetwFrameSize * iNetwFrameSizeFact );
+
+            InitFec();
         }
         Mutex.unlock();
 
+        MarkHotStateChanged();
+
         // if old CELT codec is used, inform the client that the new OPUS codec
         // is supported
         if ( NetworkTransportProps.eAudioCodingType != CT_OPUS )
@@ -408,6 +684,17 @@ void CChannel::OnReqNetTranspProps()
     Protocol.CreateNetwTranspPropsMes ( GetNetworkTransportPropsFromCurrentSettings() );
 }
 
+void CChannel::OnLocalMonitoringChanged ( bool bEnabled )
+{
+    // only the server shall act on the local monitoring message
+    if ( bIsServer )
+    {
+        bLocalMonitoring = bEnabled;
+
+        MarkHotStateChanged();
+    }
+}
+
 CNetworkTransportProps CChannel::GetNetworkTransportPropsFromCurrentSettings()
 {
     // use current stored settings of the channel to fill the network transport
@@ -419,23 +706,166 @@ CNetworkTransportProps CChannel::GetNetworkTransportPropsFromCurrentSettings()
         SYSTEM_SAMPLE_RATE_HZ,
         eAudioCompressionType,
         0, // version of the codec
-        0 );
+        iNetwFecNumBytes );
+}
+
+void CChannel::InitFec()
+{
+    // the redundant frame of the first packet does not belong to a sent frame
+    // but it is never used since the receiver does not know the sequence
+    // number of a previous frame
+    vecbyFecPrevFrame.Init ( iNetwFecNumBytes, 0 );
+    iFecSendSeqNum = 0;
+
+    vecbyFecHeldFrame.Init ( iNetwFrameSize );
+    bFecFrameHeld = false;
+    iFecExpSeqNum = -1; // no frame received yet
+}
+
+bool CChannel::GetFecData ( CVector<uint8_t>& vecbyData,
+                            int&              iNumCodedBytes,
+                            int&              iNumFecBytes )
+{
+/*
+    note: this function must be called inside the mutex region
+*/
+    const int iCodedFrameSize = GetNetwCodedFrameSize();
+
+    // a frame was held back in the previous call since its redundant frame was
+    // used for the lost frame before it (the redundant frame was already
+    // decoded and must not be given to the redundant decoder again)
+    if ( bFecFrameHeld )
+    {
+        vecbyData      = vecbyFecHeldFrame;
+        iNumCodedBytes = iCodedFrameSize;
+        iNumFecBytes   = 0;
+        bFecFrameHeld  = false;
+
+        return true;
+    }
+
+    if ( !SockBuf.Get ( vecbyData ) )
+    {
+        // the missing frame is concealed by the decoder and its slot is gone,
+        // therefore the next frame is expected to have the following sequence
+        // number (otherwise the redundant frame of the next frame would be
+        // played in the slot after the concealed one and all following frames
+        // would be shifted), if the missing frame is just late, it is used as
+        // a regular frame when it arrives
+        if ( iFecExpSeqNum >= 0 )
+        {
+            iFecExpSeqNum = ( iFecExpSeqNum + 1 ) & 255;
+        }
+
+        iNumCodedBytes = 0;
+        iNumFecBytes   = 0;
+
+        return false;
+    }
+
+    const int iSeqNum = vecbyData[iNetwFrameSize - 1];
+
+    if ( ( iFecExpSeqNum >= 0 ) && ( iSeqNum == ( ( iFecExpSeqNum + 1 ) & 255 ) ) )
+    {
+        // exactly one frame was lost: the current frame carries the redundant
+        // coding of the lost frame which is returned now whereas the current
+        // frame is held back for the next call (since no frame was taken out
+        // of the jitter buffer for the held frame, the buffer fill level is
+        // the same as without the loss)
+        vecbyFecHeldFrame = vecbyData;
+        bFecFrameHeld     = true;
+
+        for ( int i = 0; i < iNetwFecNumBytes; i++ )
+        {
+            vecbyData[i] = vecbyFecHeldFrame[iCodedFrameSize + i];
+        }
+
+        iNumCodedBytes = 0;
+        iNumFecBytes   = iNetwFecNumBytes;
+    }
+    else
+    {
+        // regular frame or more than one frame lost (in this case the
+        // redundant frame cannot help but it is still decoded to keep the
+        // redundant decoder in line with the encoder)
+        iNumCodedBytes = iCodedFrameSize;
+        iNumFecBytes   = iNetwFecNumBytes;
+    }
+
+    iFecExpSeqNum = ( iSeqNum + 1 ) & 255;
+
+    return true;
+}
+
+void CChannel::ResetTimeOutCounter()
+{
+    // store the time of the last received audio packet
+    if ( pTimeOutWheel != NULL )
+    {
+        AtomicStoreRelease ( iLastRecTick, pTimeOutWheel->GetCurTick() );
+    }
+
+    if ( !bIsConnected )
+    {
+        bIsConnected = true;
+
+        // the channel got connected (mark after the state change)
+        MarkHotStateChanged();
+    }
 }
 
 void CChannel::Disconnect()
 {
     // we only have to disconnect the channel if it is actually connected
-    if ( IsConnected() )
+    if ( IsConnected() && ( pTimeOutWheel != NULL ) )
     {
-        // set time out counter to a small value > 0 so that the next time a
-        // received audio block is queried, the disconnection is performed
+        // move the time of the last received packet back so that the
+        // connection expires on the next tick of the time-out wheel
         // (assuming that no audio packet is received in the meantime)
-        iConTimeOut = 1; // a small number > 0
+        AtomicStoreRelease ( iLastRecTick, pTimeOutWheel->GetCurTick() -
+            CChannelTimeOutWheel::GetNumTimeOutTicks() );
     }
 }
 
+bool CChannel::TimeOut ( const int iCurTick )
+{
+    bool bNowDisconnected = false;
+
+    Mutex.lock();
+    {
+        // check again inside the mutex region since a packet might have been
+        // received since the evaluation of the time-out wheel
+        if ( bIsConnected && ( GetConTimeOutTick() <= iCurTick ) )
+        {
+            bIsConnected     = false;
+            bNowDisconnected = true;
+
+            // reset network transport properties
+            ResetNetworkTransportProperties();
+
+            // the next client on this channel mixes its own signal remotely
+            // unless it tells otherwise
+            bLocalMonitoring = false;
+        }
+    }
+    Mutex.unlock();
+
+    // in case we are just disconnected, we have to fire a message
+    if ( bNowDisconnected )
+    {
+        MarkHotStateChanged();
+
+        // emit message
+        emit Disconnected();
+    }
+
+    // a channel which is still connected has to be re-armed
+    return bNowDisconnected || !bIsConnected;
+}
+
 EPutDataStat CChannel::PutData ( const CVector<uint8_t>& vecbyData,
-                                 int                     iNumBytes )
+                                 int                     iNumBytes,
+                                 const int64_t           iRecTimeNs )
 {
 /*
     Note that this function might be called from a different thread (separate
@@ -444,6 +874,11 @@ EPutDataStat CChannel::PutData ( const CVector<uint8_t>& vecbyData,
     done as early as possible.
     This is the reason why "ParseMessageBody" is not called directly but through a
     signal-slot mechanism.
+    The signal is connected with the default (automatic) connection type, i.e.
+    if this function is called in the thread of the channel object (main
+    socket), the message is parsed immediately and if it is called from a
+    receive thread, the message is queued for the thread of the channel object.
+    Therefore no check of the current thread is needed here.
 */
 
     // init return state
@@ -483,22 +918,15 @@ EPutDataStat CChannel::PutData ( const CVector<uint8_t>& vecbyData,
                 }
                 else
                 {
-#ifdef ENABLE_RECEIVE_SOCKET_IN_SEPARATE_THREAD
-                    // parse the message assuming this is a regular protocol message
+                    // parse the message assuming this is a regular protocol
+                    // message in the thread of the channel object (see the
+                    // note at the beginning of this function)
                     emit ParseMessageBody ( vecbyMesBodyData, iRecCounter, iRecID );
 
                     // note that protocol OK is not correct here since we do not
                     // check if the protocol was ok since we emit just a signal
                     // and do not get any feedback on the protocol decoding state
                     eRet = PS_PROT_OK;
-#else
-                    // parse the message assuming this is a protocol message
-                    if ( !Protocol.ParseMessageBody ( vecbyMesBodyData, iRecCounter, iRecID ) )
-                    {
-                        // set status flag
-                        eRet = PS_PROT_OK;
-                    }
-#endif
                 }
             }
             else
@@ -524,8 +952,9 @@ EPutDataStat CChannel::PutData ( const CVector<uint8_t>& vecbyData,
                 // only process audio if packet has correct size
                 if ( iNumBytes == ( iNetwFrameSize * iNetwFrameSizeFact ) )
                 {
-                    // store new packet in jitter buffer
-                    if ( SockBuf.Put ( vecbyData, iNumBytes ) )
+                    // store new packet in jitter buffer (the receive time
+                    // stamp is used for the inter-arrival time statistic)
+                    if ( SockBuf.Put ( vecbyData, iNumBytes, iRecTimeNs ) )
                     {
                         eRet = PS_AUDIO_OK;
                     }
@@ -561,6 +990,13 @@ EPutDataStat CChannel::PutData ( const CVector<uint8_t>& vecbyData,
 
         if ( bNewConnection )
         {
+            // the liveness of the new connection is tracked by the time-out
+            // wheel
+            if ( pTimeOutWheel != NULL )
+            {
+                pTimeOutWheel->Insert ( this );
+            }
+
             // inform other objects that new connection was established
             emit NewConnection();
         }
@@ -569,49 +1005,41 @@ EPutDataStat CChannel::PutData ( const CVector<uint8_t>& vecbyData,
     return eRet;
 }
 
-EGetDataStat CChannel::GetData ( CVector<uint8_t>& vecbyData )
+EGetDataStat CChannel::GetData ( CVector<uint8_t>& vecbyData,
+                                 int&              iNumCodedBytes,
+                                 int&              iNumFecBytes )
 {
     EGetDataStat eGetStatus;
 
     Mutex.lock();
     {
         // the socket access must be inside a mutex
-        const bool bSockBufState = SockBuf.Get ( vecbyData );
+        bool bSockBufState;
 
-        // decrease time-out counter
-        if ( iConTimeOut > 0 )
+        if ( iNetwFecNumBytes > 0 )
         {
-            // subtract the number of samples of the current block since the
-            // time out counter is based on samples not on blocks (definition:
-            // always one atomic block is get by using the GetData() function
-            // where the atomic block size is "SYSTEM_FRAME_SIZE_SAMPLES")
-
-// TODO this code only works with the above assumption -> better
-// implementation so that we are not depending on assumptions
-
-            iConTimeOut -= SYSTEM_FRAME_SIZE_SAMPLES;
+            bSockBufState = GetFecData ( vecbyData, iNumCodedBytes, iNumFecBytes );
+        }
+        else
+        {
+            bSockBufState  = SockBuf.Get ( vecbyData );
+            iNumCodedBytes = iNetwFrameSize;
+            iNumFecBytes   = 0;
+        }
 
-            if ( iConTimeOut <= 0 )
+        // the connection time-out is handled by the time-out wheel, reading
+        // the buffer has no influence on the connection state
+        if ( bIsConnected )
+        {
+            if ( bSockBufState )
             {
-                // channel is just disconnected
-                eGetStatus  = GS_CHAN_NOW_DISCONNECTED;
-                iConTimeOut = 0; // make sure we do not have negative values
-
-                // reset network transport properties
-                ResetNetworkTransportProperties();
+                // everything is ok
+                eGetStatus = GS_BUFFER_OK;
             }
             else
             {
-                if ( bSockBufState )
-                {
-                    // everything is ok
-                    eGetStatus = GS_BUFFER_OK;
-                }
-                else
-                {
-                    // channel is not yet disconnected but no data in buffer
-                    eGetStatus = GS_BUFFER_UNDERRUN;
-                }
+                // channel is connected but no data in buffer
+                eGetStatus = GS_BUFFER_UNDERRUN;
             }
         }
         else
@@ -622,34 +1050,56 @@ EGetDataStat CChannel::GetData ( CVector<uint8_t>& vecbyData )
     }
     Mutex.unlock();
 
-    // in case we are just disconnected, we have to fire a message
-    if ( eGetStatus == GS_CHAN_NOW_DISCONNECTED )
-    {
-        // emit message
-        emit Disconnected();
-    }
-
     return eGetStatus;
 }
 
-CVector<uint8_t> CChannel::PrepSendPacket ( const CVector<uint8_t>& vecbyNPacket )
+uint8_t* CChannel::GetSendBufPointer ( const int iNumBytes )
 {
     QMutexLocker locker ( &Mutex );
 
-    // if the block is not ready we have to initialize with zero length to
-    // tell the following network send routine that nothing should be sent
-    CVector<uint8_t> vecbySendBuf ( 0 );
+    // the conversion buffer converts the sound card block size in the network
+    // block size, the coded data is directly written in its memory
+    return ConvBuf.GetPutPointer ( iNumBytes );
+}
 
-    // use conversion buffer to convert sound card block size in network
-    // block size
-    if ( ConvBuf.Put ( vecbyNPacket ) )
+bool CChannel::PrepSendPacket ( const int iNumBytes )
+{
+    QMutexLocker locker ( &Mutex );
+
+    if ( iNetwFecNumBytes > 0 )
     {
-        // a packet is ready
-        vecbySendBuf.Init ( iNetwFrameSize * iNetwFrameSizeFact );
-        vecbySendBuf = ConvBuf.Get();
+        uint8_t* pbyFrame = ConvBuf.GetPutPointer ( iNumBytes );
+
+        if ( pbyFrame != NULL )
+        {
+            // the encoder has written the redundant coding of the current
+            // frame, it is sent with the next frame and the one of the
+            // previous frame is sent now
+            uint8_t* pbyFecFrame = pbyFrame + iNumBytes - iNetwFecNumBytes - 1;
+
+            for ( int i = 0; i < iNetwFecNumBytes; i++ )
+            {
+                const uint8_t byCurFec = pbyFecFrame[i];
+
+                pbyFecFrame[i]       = vecbyFecPrevFrame[i];
+                vecbyFecPrevFrame[i] = byCurFec;
+            }
+
+            pbyFrame[iNumBytes - 1] = static_cast<uint8_t> ( iFecSendSeqNum );
+            iFecSendSeqNum          = ( iFecSendSeqNum + 1 ) & 255;
+        }
     }
 
-    return vecbySendBuf;
+    // returns true if a packet is ready
+    return ConvBuf.PutInPlace ( iNumBytes );
+}
+
+int CChannel::GetSockBufNumFramesFilled()
+{
+    QMutexLocker locker ( &Mutex );
+
+    // the jitter buffer blocks are network frames
+    return SockBuf.GetAvailData() / iNetwFrameSize;
 }
 
 int CChannel::GetUploadRateKbps()
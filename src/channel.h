@@ -26,6 +26,10 @@
 #define CHANNEL_HOIH9345KJH98_3_4344_BB23945IUHF1912__INCLUDED_
 
 #include <QThread>
+#include <QAtomicPointer>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QTimer>
 #include <QDateTime>
 #include <QFile>
 #include <QTextStream>
@@ -41,6 +45,10 @@
 // correction is implemented)
 #define CON_TIME_OUT_SEC_MAX                30 // seconds
 
+// granularity and number of slots of the connection time-out wheel
+#define CON_TIME_OUT_WHEEL_TICK_MS          100 // ms
+#define CON_TIME_OUT_WHEEL_NUM_SLOTS        64
+
 enum EPutDataStat
 {
     PS_GEN_ERROR,
@@ -53,6 +61,152 @@ enum EPutDataStat
 
 
 /* Classes ********************************************************************/
+// Gains of all channels ------------------------------------------------------
+// Matrix of the gains of channel "iOtherChanID" in the mix of channel
+// "iChanID". The mixer reads a consistent snapshot without any locking whereas
+// the (rare) writers update a copy of the matrix and publish it atomically
+// (read-copy-update). A replaced matrix is deleted by a later writer as soon
+// as the mixer does not use it anymore which is known by the snapshot pointer
+// the mixer announces on acquiring (only one reader is supported).
+class CChannelGainMatrix
+{
+public:
+    CChannelGainMatrix();
+    virtual ~CChannelGainMatrix();
+
+    // writer interface
+    void SetGain ( const int    iChanID,
+                   const int    iOtherChanID,
+                   const double dNewGain );
+
+    void ResetGains ( const int iChanID );
+
+    double GetGain ( const int iChanID, const int iOtherChanID );
+
+    // reader interface for the mixer
+    const CVector<double>& AcquireSnapshot();
+    void ReleaseSnapshot() { AtomicStoreRelease ( pReaderSnapshot, (CVector<double>*) NULL ); }
+
+    static double GetGain ( const CVector<double>& vecdSnapshot,
+                            const int              iChanID,
+                            const int              iOtherChanID )
+        { return vecdSnapshot[iChanID * MAX_NUM_CHANNELS + iOtherChanID]; }
+
+protected:
+    void Publish ( CVector<double>* pNewMatrix );
+
+    QAtomicPointer<CVector<double> > pPublished;
+    QAtomicPointer<CVector<double> > pReaderSnapshot;
+    std::list<CVector<double>*>      RetiredMatrices;
+
+    // the writers are serialized by a mutex
+    QMutex                           Mutex;
+};
+
+
+// Per tick relevant channel state --------------------------------------------
+// The state of all channels which is needed by the server in each tick is
+// kept in compact arrays (structure of arrays) so that the tick does not have
+// to touch the large channel objects. A channel marks its entry as changed on
+// a state change (connection, audio stream properties) and the server
+// refreshes the marked entries at the beginning of the next tick.
+// The changed channels are stored as bits of an int, the following typedef
+// fails to compile if MAX_NUM_CHANNELS is too large for that.
+typedef char MaxNumChannelsFitsChangedMask[( MAX_NUM_CHANNELS <= 31 ) ? 1 : -1];
+
+class CChannelHotState
+{
+public:
+    CChannelHotState() : iNumConnChan ( 0 ), iChangedMask ( 0 )
+    {
+        for ( int i = 0; i < MAX_NUM_CHANNELS; i++ )
+        {
+            vbIsConnected[i]          = false;
+            veAudioCompressionType[i] = CT_NONE;
+            viNetwFrameSize[i]        = 0;
+            viNetwCodedFrameSize[i]   = 0;
+            viNetwFecNumBytes[i]      = 0;
+            viNumAudioChannels[i]     = 1;
+            vbLocalMonitoring[i]      = false;
+        }
+    }
+
+    // one bit per channel (MAX_NUM_CHANNELS must not exceed 31), the bit is
+    // set by a compare-and-swap loop since Qt 4 has no atomic "or" operation
+    void MarkChanged ( const int iChanID )
+    {
+        int iOldMask;
+
+        do
+        {
+            iOldMask = AtomicLoadRelaxed ( iChangedMask );
+        }
+        while ( !iChangedMask.testAndSetOrdered ( iOldMask,
+                                                  iOldMask | ( 1 << iChanID ) ) );
+    }
+
+    int TakeChangedMask() { return iChangedMask.fetchAndStoreOrdered ( 0 ); }
+
+    // IDs of the connected channels
+    int           iNumConnChan;
+    int           viConnChanIDs[MAX_NUM_CHANNELS];
+
+    bool          vbIsConnected[MAX_NUM_CHANNELS];
+    EAudComprType veAudioCompressionType[MAX_NUM_CHANNELS];
+    int           viNetwFrameSize[MAX_NUM_CHANNELS];
+    int           viNetwCodedFrameSize[MAX_NUM_CHANNELS];
+    int           viNetwFecNumBytes[MAX_NUM_CHANNELS];
+    int           viNumAudioChannels[MAX_NUM_CHANNELS];
+    bool          vbLocalMonitoring[MAX_NUM_CHANNELS];
+
+protected:
+    QAtomicInt    iChangedMask;
+};
+
+
+// Connection time-out wheel --------------------------------------------------
+// The liveness of the connections is tracked by the monotonic time (in wheel
+// ticks) of the last received audio packet of each channel. The connected
+// channels are stored in the slot of their expiry tick. If a slot is due, the
+// expiry tick of each of its channels is re-evaluated (lazy re-arming, a
+// received packet does not touch the wheel) and the channel is either moved
+// to the slot of its new expiry tick or it is disconnected. This is
+// independent of the audio processing, i.e., it also works if no audio data
+// is taken out of the channels.
+class CChannel; // forward declaration
+
+class CChannelTimeOutWheel : public QObject
+{
+    Q_OBJECT
+
+public:
+    CChannelTimeOutWheel();
+
+    // monotonic time in wheel ticks (thread safe)
+    int GetCurTick() const
+        { return static_cast<int> ( ElapsedTimer.elapsed() / CON_TIME_OUT_WHEEL_TICK_MS ); }
+
+    static int GetNumTimeOutTicks()
+        { return CON_TIME_OUT_SEC_MAX * 1000 / CON_TIME_OUT_WHEEL_TICK_MS; }
+
+    // must be called if a channel gets connected
+    void Insert ( CChannel* pChannel );
+
+protected:
+    void InsertIntern ( CChannel* pChannel, const int iExpTick );
+
+    QElapsedTimer        ElapsedTimer;
+    QTimer               Timer;
+    std::list<CChannel*> vecSlots[CON_TIME_OUT_WHEEL_NUM_SLOTS];
+    int                  iNextTick;
+    QMutex               Mutex;
+
+public slots:
+    void OnTimer();
+};
+
+
+// Channel ---------------------------------------------------------------------
 class CChannel : public QObject
 {
     Q_OBJECT
@@ -63,14 +217,39 @@ public:
     CChannel ( const bool bNIsServer = true );
 
     EPutDataStat PutData ( const CVector<uint8_t>& vecbyData,
-                           int iNumBytes );
-    EGetDataStat GetData ( CVector<uint8_t>& vecbyData );
+                           int                     iNumBytes,
+                           const int64_t           iRecTimeNs );
+    // the first "iNumCodedBytes" of the data are decoded by the regular audio
+    // decoder, with forward error correction they are followed by
+    // "iNumFecBytes" of a redundant frame which must be decoded by an own
+    // decoder so that its state follows the redundant encoder of the sender
+    // (if "iNumCodedBytes" is zero, the redundant frame replaces a lost frame)
+    EGetDataStat GetData ( CVector<uint8_t>& vecbyData,
+                           int&              iNumCodedBytes,
+                           int&              iNumFecBytes );
+
+    // the audio encoder writes the coded data directly in the send buffer of
+    // the channel, if a network packet is complete, "PrepSendPacket" returns
+    // true and the packet can be accessed with "GetSendPacket" (with forward
+    // error correction, the encoder writes the redundant coding of the
+    // current frame behind the coded frame, the channel exchanges it with the
+    // one of the previous frame and appends the sequence number)
+    uint8_t* GetSendBufPointer ( const int iNumBytes );
+    bool PrepSendPacket ( const int iNumBytes );
+    const CVector<uint8_t>& GetSendPacket() { return ConvBuf.Get(); }
+
+    void ResetTimeOutCounter();
+    bool IsConnected() const { return bIsConnected; }
+    void Disconnect();
 
-    CVector<uint8_t> PrepSendPacket ( const CVector<uint8_t>& vecbyNPacket );
+    // the connection time-out is evaluated by the time-out wheel
+    void SetTimeOutWheel ( CChannelTimeOutWheel* pNTimeOutWheel )
+        { pTimeOutWheel = pNTimeOutWheel; }
 
-    void ResetTimeOutCounter() { iConTimeOut = iConTimeOutStartVal; }
-    bool IsConnected() const { return iConTimeOut > 0; }
-    void Disconnect();
+    int GetConTimeOutTick() const
+        { return AtomicLoadAcquire ( iLastRecTick ) + CChannelTimeOutWheel::GetNumTimeOutTicks(); }
+
+    bool TimeOut ( const int iCurTick );
 
     void SetEnable ( const bool bNEnStat );
     bool IsEnabled() { return bIsEnabled; }
@@ -95,6 +274,19 @@ Protocol.CreateChanNameMes ( ChInfo.strName );
     }
     void CreateReqChanInfoMes() { Protocol.CreateReqChanInfoMes(); }
 
+    // the server stores the gains and the per tick relevant state of the
+    // channel in server wide structures (at the index of this channel)
+    void SetServerState ( const int           iNChanID,
+                          CChannelGainMatrix* pNGainMatrix,
+                          CChannelHotState*   pNHotState )
+    {
+        iServerChanID = iNChanID;
+        pGainMatrix   = pNGainMatrix;
+        pHotState     = pNHotState;
+
+        MarkHotStateChanged();
+    }
+
     void SetGain ( const int iChanID, const double dNewGain );
     double GetGain ( const int iChanID );
 
@@ -104,6 +296,7 @@ Protocol.CreateChanNameMes ( ChInfo.strName );
     bool SetSockBufNumFrames ( const int  iNewNumFrames,
                                const bool bPreserve = false );
     int GetSockBufNumFrames() const { return iCurSockBufNumFrames; }
+    int GetSockBufNumFramesFilled();
 
     void UpdateSocketBufferSize();
 
@@ -113,7 +306,8 @@ Protocol.CreateChanNameMes ( ChInfo.strName );
     void SetAudioStreamProperties ( const EAudComprType eNewAudComprType,
                                     const int iNewNetwFrameSize,
                                     const int iNewNetwFrameSizeFact,
-                                    const int iNewNumAudioChannels );
+                                    const int iNewNumAudioChannels,
+                                    const int iNewNetwFecNumBytes );
 
     void SetDoAutoSockBufSize ( const bool bValue )
         { bDoAutoSockBufSize = bValue; }
@@ -122,13 +316,27 @@ Protocol.CreateChanNameMes ( ChInfo.strName );
 
     int GetNetwFrameSizeFact() const { return iNetwFrameSizeFact; }
     int GetNetwFrameSize() const { return iNetwFrameSize; }
+    int GetNetwFecNumBytes() const { return iNetwFecNumBytes; }
+
+    // number of bytes of the coded audio frame in a network frame
+    int GetNetwCodedFrameSize() const
+    {
+        return iNetwFecNumBytes > 0 ?
+            iNetwFrameSize - iNetwFecNumBytes - 1 : iNetwFrameSize;
+    }
 
     void GetBufErrorRates ( CVector<double>& vecErrRates, double& dLimit )
         { SockBuf.GetErrorRates ( vecErrRates, dLimit ); }
 
+    double GetArrivalTimeRmsJitterMs() { return SockBuf.GetArrivalTimeRmsJitterMs(); }
+
     EAudComprType GetAudioCompressionType() { return eAudioCompressionType; }
     int GetNumAudioChannels() const { return iNumAudioChannels; }
 
+    // the client monitors its own signal locally, i.e., the server excludes
+    // it from the personal mix of this client
+    bool GetLocalMonitoring() const { return bLocalMonitoring; }
+
     // network protocol interface
     void CreateJitBufMes ( const int iJitBufSize )
     { 
@@ -141,6 +349,8 @@ Protocol.CreateChanNameMes ( ChInfo.strName );
     void CreateReqJitBufMes()                             { Protocol.CreateReqJitBufMes(); }
     void CreateReqConnClientsList()                       { Protocol.CreateReqConnClientsList(); }
     void CreateChatTextMes ( const QString& strChatText ) { Protocol.CreateChatTextMes ( strChatText ); }
+    void CreateLocalMonitoringMes ( const bool bEnabled ) { Protocol.CreateLocalMonitoringMes ( bEnabled ); }
+    void CreateBroadcastMes ( const CProtocol::CBroadcastMessage& BroadcastMes ) { Protocol.CreateBroadcastMes ( BroadcastMes ); }
 
 // #### COMPATIBILITY OLD VERSION, TO BE REMOVED ####
 void CreateConClientListNameMes ( const CVector<CChannelInfo>& vecChanInfo )
@@ -149,11 +359,33 @@ void CreateConClientListNameMes ( const CVector<CChannelInfo>& vecChanInfo )
     void CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInfo )
         { Protocol.CreateConClientListMes ( vecChanInfo ); }
 
+    void CreateConClientListDeltaMes ( const int                    iBaseVersion,
+                                       const int                    iNewVersion,
+                                       const CVector<CChannelInfo>& vecChangedChanInfo,
+                                       const CVector<int>&          vecRemovedChanIDs )
+        { Protocol.CreateConClientListDeltaMes ( iBaseVersion, iNewVersion, vecChangedChanInfo, vecRemovedChanIDs ); }
+
+    bool IsPeerFeatureSupported ( const int iFeature )
+        { return Protocol.IsPeerFeatureSupported ( iFeature ); }
+
     CNetworkTransportProps GetNetworkTransportPropsFromCurrentSettings();
 
 protected:
     bool ProtocolIsEnabled();
 
+    void MarkHotStateChanged()
+    {
+        if ( pHotState != NULL )
+        {
+            pHotState->MarkChanged ( iServerChanID );
+        }
+    }
+
+    void InitFec();
+    bool GetFecData ( CVector<uint8_t>& vecbyData,
+                      int&              iNumCodedBytes,
+                      int&              iNumFecBytes );
+
     void ResetNetworkTransportProperties()
     {
         // set it to a state were no decoding is ever possible (since we want
@@ -162,6 +394,7 @@ protected:
         eAudioCompressionType = CT_NONE;
         iNetwFrameSizeFact    = FRAME_SIZE_FACTOR_PREFERRED;
         iNetwFrameSize        = CELT_MINIMUM_NUM_BYTES;
+        iNetwFecNumBytes      = 0; // no forward error correction
         iNumAudioChannels     = 1; // mono
     }
 
@@ -171,8 +404,10 @@ protected:
     // channel info
     CChannelCoreInfo  ChannelInfo;
 
-    // mixer and effect settings
-    CVector<double>   vecdGains;
+    // server wide state
+    int                 iServerChanID;
+    CChannelGainMatrix* pGainMatrix;
+    CChannelHotState*   pHotState;
 
     // network jitter-buffer
     CNetBufWithStats  SockBuf;
@@ -185,17 +420,29 @@ protected:
     // network protocol
     CProtocol         Protocol;
 
-    int               iConTimeOut;
-    int               iConTimeOutStartVal;
+    // connection state (the time of the last received audio packet is given
+    // in ticks of the time-out wheel)
+    CChannelTimeOutWheel* pTimeOutWheel;
+    bool                  bIsConnected;
+    QAtomicInt            iLastRecTick;
 
     bool              bIsEnabled;
     bool              bIsServer;
 
     int               iNetwFrameSizeFact;
     int               iNetwFrameSize;
+    int               iNetwFecNumBytes;
+
+    // forward error correction (redundant coding of the previous frame)
+    CVector<uint8_t>  vecbyFecPrevFrame;
+    int               iFecSendSeqNum;
+    CVector<uint8_t>  vecbyFecHeldFrame;
+    bool              bFecFrameHeld;
+    int               iFecExpSeqNum;
 
     EAudComprType     eAudioCompressionType;
     int               iNumAudioChannels;
+    bool              bLocalMonitoring;
 
     QMutex            Mutex;
 
@@ -207,12 +454,11 @@ public slots:
     void OnChangeChanInfo ( CChannelCoreInfo ChanInfo );
     void OnNetTranspPropsReceived ( CNetworkTransportProps NetworkTransportProps );
     void OnReqNetTranspProps();
+    void OnLocalMonitoringChanged ( bool bEnabled );
 
-#ifdef ENABLE_RECEIVE_SOCKET_IN_SEPARATE_THREAD
     void OnParseMessageBody ( CVector<uint8_t> vecbyMesBodyData,
                               int              iRecCounter,
                               int              iRecID ) { Protocol.ParseMessageBody ( vecbyMesBodyData, iRecCounter, iRecID ); }
-#endif
 
 signals:
     void MessReadyForSending ( CVector<uint8_t> vecMessage );
@@ -228,16 +474,15 @@ signals:
     void OpusSupported();
     void ChatTextReceived ( QString strChatText );
     void ReqNetTranspProps();
+    void ProtFeaturesReceived();
     void Disconnected();
 
     void DetectedCLMessage ( CVector<uint8_t> vecbyMesBodyData,
                              int              iRecID );
 
-#ifdef ENABLE_RECEIVE_SOCKET_IN_SEPARATE_THREAD
     void ParseMessageBody ( CVector<uint8_t> vecbyMesBodyData,
                             int              iRecCounter,
                             int              iRecID );
-#endif
 };
 
 #endif /* !defined ( CHANNEL_HOIH9345KJH98_3_4344_BB23945IUHF1912__INCLUDED_ ) */
@@ -26,7 +26,117 @@
 
 
 /* Implementation *************************************************************/
-CClient::CClient ( const quint16 iPortNumber ) :
+CAudioProcessingThread::CAudioProcessingThread ( void (*fpNewProcessCallback) ( void* arg ),
+                                                 void* arg ) :
+    fpProcessCallback   ( fpNewProcessCallback ),
+    pProcessCallbackArg ( arg ),
+    bRun                ( false )
+{
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
+    semaphore_create ( mach_task_self(), &Semaphore, SYNC_POLICY_FIFO, 0 );
+#elif defined ( _WIN32 )
+    Semaphore = CreateSemaphore ( NULL, 0, MAXLONG, NULL );
+#else
+    sem_init ( &Semaphore, 0, 0 );
+#endif
+}
+
+CAudioProcessingThread::~CAudioProcessingThread()
+{
+    Stop();
+
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
+    semaphore_destroy ( mach_task_self(), Semaphore );
+#elif defined ( _WIN32 )
+    CloseHandle ( Semaphore );
+#else
+    sem_destroy ( &Semaphore );
+#endif
+}
+
+void CAudioProcessingThread::Wake()
+{
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
+    semaphore_signal ( Semaphore );
+#elif defined ( _WIN32 )
+    ReleaseSemaphore ( Semaphore, 1, NULL );
+#else
+    sem_post ( &Semaphore );
+#endif
+}
+
+void CAudioProcessingThread::WaitForWake()
+{
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
+    semaphore_wait ( Semaphore );
+#elif defined ( _WIN32 )
+    WaitForSingleObject ( Semaphore, INFINITE );
+#else
+    // the wait may be interrupted by a signal
+    while ( sem_wait ( &Semaphore ) != 0 ) {}
+#endif
+}
+
+bool CAudioProcessingThread::TryWaitForWake()
+{
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
+    mach_timespec_t NoTimeOut = { 0, 0 };
+    return semaphore_timedwait ( Semaphore, NoTimeOut ) == KERN_SUCCESS;
+#elif defined ( _WIN32 )
+    return WaitForSingleObject ( Semaphore, 0 ) == WAIT_OBJECT_0;
+#else
+    return sem_trywait ( &Semaphore ) == 0;
+#endif
+}
+
+void CAudioProcessingThread::Start()
+{
+    // only start if not already running
+    if ( !bRun )
+    {
+        // set run flag
+        bRun = true;
+
+        // the audio processing must not be interrupted by the GUI
+        QThread::start ( QThread::TimeCriticalPriority );
+    }
+}
+
+void CAudioProcessingThread::Stop()
+{
+    if ( bRun )
+    {
+        // set flag so that thread can leave the main loop and wake it up
+        bRun = false;
+        Wake();
+
+        // give thread some time to terminate
+        wait ( 5000 );
+
+        // drop the wake ups which were not processed
+        while ( TryWaitForWake() ) {}
+    }
+}
+
+void CAudioProcessingThread::run()
+{
+    // loop until the thread shall be terminated
+    while ( bRun )
+    {
+        // wait for the next sound card block
+        WaitForWake();
+
+        if ( bRun )
+        {
+            (*fpProcessCallback) ( pProcessCallbackArg );
+        }
+    }
+}
+
+
+CClient::CClient ( const quint16  iPortNumber,
+                   const QString& strAudioInFileName,
+                   const QString& strAudioOutFileName ) :
     vstrIPAddress                    ( MAX_NUM_SERVER_ADDR_ITEMS, "" ),
     ChannelInfo                      (),
     vecStoredFaderTags               ( MAX_NUM_STORED_FADER_LEVELS, "" ),
@@ -41,21 +151,33 @@ CClient::CClient ( const quint16 iPortNumber ) :
     Channel                          ( false ), /* we need a client channel -> "false" */
     eAudioCompressionType            ( CT_OPUS ),
     iCeltNumCodedBytes               ( CELT_NUM_BYTES_MONO_LOW_QUALITY ),
+    iFecNumCodedBytes                ( 0 ),
+    iNetwFrameSize                   ( CELT_NUM_BYTES_MONO_LOW_QUALITY ),
     eAudioQuality                    ( AQ_LOW ),
     bUseStereo                       ( false ),
+    bUseAudioFec                     ( false ),
     bIsInitializationPhase           ( true ),
     Socket                           ( &Channel, iPortNumber ),
-    Sound                            ( AudioCallback, this ),
+    pSound                           ( NULL ),
+    iNumLostPackets                  ( 0 ),
     iAudioInFader                    ( AUD_FADER_IN_MIDDLE ),
     bReverbOnLeftChan                ( false ),
     iReverbLevel                     ( 0 ),
+    bLocalMonitoring                 ( false ),
+    bLocalMonitoringSupported        ( false ),
+    iLocalMonitorLevel               ( AUD_LOCAL_MONITOR_MAX / 2 ),
+    bDelayMeasurement                ( false ),
+    iLastDelayMeasTimeMs             ( -1 ),
     iSndCrdPrefFrameSizeFactor       ( FRAME_SIZE_FACTOR_PREFERRED ),
     iSndCrdFrameSizeFactor           ( FRAME_SIZE_FACTOR_PREFERRED ),
     bSndCrdConversionBufferRequired  ( false ),
     iSndCardMonoBlockSizeSamConvBuff ( 0 ),
+    AudioProcessingThread            ( AudioProcessingCallback, this ),
+    iSndCrdBufferOutFill             ( 0 ),
     bFraSiFactPrefSupported          ( false ),
     bFraSiFactDefSupported           ( false ),
     bFraSiFactSafeSupported          ( false ),
+    bSndCrdCapsCached                ( false ),
     bOpenChatOnNewMessage            ( true ),
     eGUIDesign                       ( GD_ORIGINAL ),
     strCentralServerAddress          ( "" ),
@@ -64,6 +186,28 @@ CClient::CClient ( const quint16 iPortNumber ) :
 {
     int iOpusError;
 
+    // the connection time-out is tracked independently of the audio processing
+    Channel.SetTimeOutWheel ( &TimeOutWheel );
+
+    // audio interface: if audio files are given, the audio is read from and
+    // written to files instead of using the sound card (headless client)
+    if ( strAudioInFileName.isEmpty() && strAudioOutFileName.isEmpty() )
+    {
+        pSound = new CSound ( AudioCallback, this );
+    }
+    else
+    {
+        CSoundFile* pSoundFile = new CSoundFile ( AudioCallback,
+                                                  this,
+                                                  strAudioInFileName,
+                                                  strAudioOutFileName );
+
+        QObject::connect ( pSoundFile, SIGNAL ( InputFileFinished() ),
+            SIGNAL ( AudioInputFinished() ) );
+
+        pSound = pSoundFile;
+    }
+
     // init audio encoder/decoder (mono)
     CeltModeMono = cc6_celt_mode_create (
         SYSTEM_SAMPLE_RATE_HZ, 1, SYSTEM_FRAME_SIZE_SAMPLES, NULL );
@@ -138,6 +282,58 @@ CClient::CClient ( const quint16 iPortNumber ) :
                               OPUS_SET_COMPLEXITY ( 1 ) );
 #endif
 
+    // init audio encoders/decoders for the redundant frames of the forward
+    // error correction (they have their own state since they work on a low
+    // bit rate)
+    OpusEncoderFecMono = opus_custom_encoder_create ( OpusMode,
+                                                      1,
+                                                      &iOpusError );
+
+    OpusDecoderFecMono = opus_custom_decoder_create ( OpusMode,
+                                                      1,
+                                                      &iOpusError );
+
+    OpusEncoderFecStereo = opus_custom_encoder_create ( OpusMode,
+                                                        2,
+                                                        &iOpusError );
+
+    OpusDecoderFecStereo = opus_custom_decoder_create ( OpusMode,
+                                                        2,
+                                                        &iOpusError );
+
+    opus_custom_encoder_ctl ( OpusEncoderFecMono,
+                              OPUS_SET_VBR ( 0 ) );
+
+    opus_custom_encoder_ctl ( OpusEncoderFecMono,
+                              OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+
+    opus_custom_encoder_ctl ( OpusEncoderFecMono,
+                              OPUS_SET_BITRATE (
+                                  CalcBitRateBitsPerSecFromCodedBytes (
+                                      OPUS_NUM_BYTES_MONO_FEC ) ) );
+
+    opus_custom_encoder_ctl ( OpusEncoderFecStereo,
+                              OPUS_SET_VBR ( 0 ) );
+
+    opus_custom_encoder_ctl ( OpusEncoderFecStereo,
+                              OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+
+    opus_custom_encoder_ctl ( OpusEncoderFecStereo,
+                              OPUS_SET_BITRATE (
+                                  CalcBitRateBitsPerSecFromCodedBytes (
+                                      OPUS_NUM_BYTES_STEREO_FEC ) ) );
+
+#ifdef USE_LOW_COMPLEXITY_CELT_ENC
+    opus_custom_encoder_ctl ( OpusEncoderFecMono,
+                              OPUS_SET_COMPLEXITY ( 1 ) );
+
+    opus_custom_encoder_ctl ( OpusEncoderFecStereo,
+                              OPUS_SET_COMPLEXITY ( 1 ) );
+#endif
+
+    // init the averaging of the overall delay measurement
+    DelayMeasAv.Init ( DELAY_MEAS_AV_LEN );
+
 
     // Connections -------------------------------------------------------------
     // connections for the protocol mechanism
@@ -173,6 +369,9 @@ CClient::CClient ( const quint16 iPortNumber ) :
     QObject::connect ( &Channel, SIGNAL ( NewConnection() ),
         this, SLOT ( OnNewConnection() ) );
 
+    QObject::connect ( &Channel, SIGNAL ( ProtFeaturesReceived() ),
+        this, SLOT ( OnProtFeaturesReceived() ) );
+
     QObject::connect ( &Channel,
         SIGNAL ( ChatTextReceived ( QString ) ),
         SIGNAL ( ChatTextReceived ( QString ) ) );
@@ -197,9 +396,13 @@ QObject::connect ( &Channel, SIGNAL ( OpusSupported() ),
         SIGNAL ( CLPingWithNumClientsReceived ( CHostAddress, int, int ) ),
         this, SLOT ( OnCLPingWithNumClientsReceived ( CHostAddress, int, int ) ) );
 
+    QObject::connect ( &ConnLessProtocol,
+        SIGNAL ( CLAudioDelayMeasReceived ( CHostAddress, int, int ) ),
+        this, SLOT ( OnCLAudioDelayMeasReceived ( CHostAddress, int, int ) ) );
+
 
     // other
-    QObject::connect ( &Sound, SIGNAL ( ReinitRequest ( int ) ),
+    QObject::connect ( pSound, SIGNAL ( ReinitRequest ( int ) ),
         this, SLOT ( OnSndCrdReinitRequest ( int ) ) );
 
     QObject::connect ( &Socket, SIGNAL ( InvalidPacketReceived ( CVector<uint8_t>, int, CHostAddress ) ),
@@ -282,6 +485,37 @@ void CClient::OnNewConnection()
     // Same problem is with the jitter buffer message.
     Channel.CreateReqConnClientsList();
     CreateServerJitterBufferMessage();
+
+    // the delay measurement results of a previous connection are not valid
+    DelayMeasAv.Reset();
+    iLastDelayMeasTimeMs = -1;
+}
+
+void CClient::OnProtFeaturesReceived()
+{
+    // the server includes our own signal in our mix unless we tell otherwise,
+    // an old server does not know the message and would still send our own
+    // signal, therefore the local mix is only used if the server supports it
+    // (the server sends its features on each new connection)
+    bLocalMonitoringSupported =
+        Channel.IsPeerFeatureSupported ( PROT_FEATURE_LOCAL_MONITORING );
+
+    if ( bLocalMonitoring && bLocalMonitoringSupported )
+    {
+        Channel.CreateLocalMonitoringMes ( true );
+    }
+}
+
+void CClient::SetLocalMonitoring ( const bool bNLM )
+{
+    bLocalMonitoring = bNLM;
+
+    // tell the server to exclude (or include again) our own signal from our
+    // mix, on a new connection this is done in "OnProtFeaturesReceived"
+    if ( Channel.IsConnected() && bLocalMonitoringSupported )
+    {
+        Channel.CreateLocalMonitoringMes ( bNLM );
+    }
 }
 
 void CClient::CreateServerJitterBufferMessage()
@@ -329,6 +563,56 @@ void CClient::OnCLPingWithNumClientsReceived ( CHostAddress InetAddr,
     }
 }
 
+void CClient::CreateCLPingMes()
+{
+    ConnLessProtocol.CreateCLPingMes ( Channel.GetAddress(), PreparePingMessage() );
+
+    // the overall delay measurement uses the interval of the ping messages,
+    // the message is connection less (i.e. not acknowledged and not
+    // re-transmitted) so that the round trip time is the one of the network
+    if ( bDelayMeasurement && Channel.IsConnected() )
+    {
+        ConnLessProtocol.CreateCLAudioDelayMeasMes ( Channel.GetAddress(),
+                                                     PreparePingMessage(),
+                                                     0 );
+    }
+}
+
+void CClient::OnCLAudioDelayMeasReceived ( CHostAddress InetAddr,
+                                           int          iMs,
+                                           int          iServerJitBufFill )
+{
+    // make sure the answer comes from our server
+    if ( !bDelayMeasurement || !( InetAddr == Channel.GetAddress() ) )
+    {
+        return;
+    }
+
+    // take care of wrap arounds (if wrapping, do not use result)
+    const int iRoundTripMs = EvaluatePingMessage ( iMs );
+
+    if ( iRoundTripMs < 0 )
+    {
+        return;
+    }
+
+    // delay from the encoder input to the decoder output: the round trip time
+    // of the message which goes the same way as the audio packets,
+    // the waiting time in the jitter buffers of the server and the client
+    // (the current fills in audio frames), the time to fill the network
+    // packets and the additional delay of the audio codec
+    const int iNumJitBufFrames =
+        iServerJitBufFill + Channel.GetSockBufNumFramesFilled();
+
+    const double dDelayMs = iRoundTripMs +
+        SYSTEM_BLOCK_DURATION_MS_FLOAT * iNumJitBufFrames +
+        static_cast<double> ( GetSystemMonoBlSize() ) * 1000 / SYSTEM_SAMPLE_RATE_HZ +
+        SYSTEM_BLOCK_DURATION_MS_FLOAT / 2;
+
+    DelayMeasAv.Add ( dDelayMs );
+    iLastDelayMeasTimeMs = PreciseTime.elapsed();
+}
+
 int CClient::PreparePingMessage()
 {
     // transmit the current precise time (in ms)
@@ -376,22 +660,39 @@ void CClient::SetSndCrdPrefFrameSizeFactor ( const int iNewFactor )
     {
         // init with new parameter, if client was running then first
         // stop it and restart again after new initialization
-        const bool bWasRunning = Sound.IsRunning();
+        const bool bWasRunning = pSound->IsRunning();
         if ( bWasRunning )
         {
-            Sound.Stop();
+            pSound->Stop();
         }
 
         // set new parameter
         iSndCrdPrefFrameSizeFactor = iNewFactor;
 
+        // the cached capabilities might be outdated (e.g. the buffer size was
+        // changed outside of our software), if the selected frame size is
+        // marked as unsupported, the capabilities are probed again
+        const QString strDevName = GetSndCrdCurDevName();
+
+        if ( mapSndCrdCaps.contains ( strDevName ) )
+        {
+            const int iCaps = mapSndCrdCaps[strDevName];
+
+            if ( ( ( iNewFactor == FRAME_SIZE_FACTOR_PREFERRED ) && !( iCaps & SND_CRD_CAPS_PREF_SUPPORTED ) ) ||
+                 ( ( iNewFactor == FRAME_SIZE_FACTOR_DEFAULT )   && !( iCaps & SND_CRD_CAPS_DEF_SUPPORTED ) ) ||
+                 ( ( iNewFactor == FRAME_SIZE_FACTOR_SAFE )      && !( iCaps & SND_CRD_CAPS_SAFE_SUPPORTED ) ) )
+            {
+                mapSndCrdCaps.remove ( strDevName );
+            }
+        }
+
         // init with new block size index parameter
         Init();
 
         if ( bWasRunning )
         {
             // restart client
-            Sound.Start();
+            pSound->Start();
         }
     }
 }
@@ -413,10 +714,10 @@ void CClient::SetAudoCompressiontype ( const EAudComprType eNAudCompressionType
 {
     // init with new parameter, if client was running then first
     // stop it and restart again after new initialization
-    const bool bWasRunning = Sound.IsRunning();
+    const bool bWasRunning = pSound->IsRunning();
     if ( bWasRunning )
     {
-        Sound.Stop();
+        pSound->Stop();
     }
 
     // set new parameter
@@ -425,7 +726,7 @@ void CClient::SetAudoCompressiontype ( const EAudComprType eNAudCompressionType
 
     if ( bWasRunning )
     {
-        Sound.Start();
+        pSound->Start();
     }
 }
 
@@ -433,10 +734,10 @@ void CClient::SetAudioQuality ( const EAudioQuality eNAudioQuality )
 {
     // init with new parameter, if client was running then first
     // stop it and restart again after new initialization
-    const bool bWasRunning = Sound.IsRunning();
+    const bool bWasRunning = pSound->IsRunning();
     if ( bWasRunning )
     {
-        Sound.Stop();
+        pSound->Stop();
     }
 
     // set new parameter
@@ -445,7 +746,7 @@ void CClient::SetAudioQuality ( const EAudioQuality eNAudioQuality )
 
     if ( bWasRunning )
     {
-        Sound.Start();
+        pSound->Start();
     }
 }
 
@@ -453,10 +754,10 @@ void CClient::SetUseStereo ( const bool bNUseStereo )
 {
     // init with new parameter, if client was running then first
     // stop it and restart again after new initialization
-    const bool bWasRunning = Sound.IsRunning();
+    const bool bWasRunning = pSound->IsRunning();
     if ( bWasRunning )
     {
-        Sound.Stop();
+        pSound->Stop();
     }
 
     // set new parameter
@@ -465,7 +766,27 @@ void CClient::SetUseStereo ( const bool bNUseStereo )
 
     if ( bWasRunning )
     {
-        Sound.Start();
+        pSound->Start();
+    }
+}
+
+void CClient::SetUseAudioFec ( const bool bNUseAudioFec )
+{
+    // init with new parameter, if client was running then first
+    // stop it and restart again after new initialization
+    const bool bWasRunning = pSound->IsRunning();
+    if ( bWasRunning )
+    {
+        pSound->Stop();
+    }
+
+    // set new parameter
+    bUseAudioFec = bNUseAudioFec;
+    Init();
+
+    if ( bWasRunning )
+    {
+        pSound->Start();
     }
 }
 
@@ -473,13 +794,13 @@ QString CClient::SetSndCrdDev ( const int iNewDev )
 {
     // if client was running then first
     // stop it and restart again after new initialization
-    const bool bWasRunning = Sound.IsRunning();
+    const bool bWasRunning = pSound->IsRunning();
     if ( bWasRunning )
     {
-        Sound.Stop();
+        pSound->Stop();
     }
 
-    const QString strReturn = Sound.SetDev ( iNewDev );
+    const QString strReturn = pSound->SetDev ( iNewDev );
 
     // init again because the sound card actual buffer size might
     // be changed on new device
@@ -488,7 +809,7 @@ QString CClient::SetSndCrdDev ( const int iNewDev )
     if ( bWasRunning )
     {
         // restart client
-        Sound.Start();
+        pSound->Start();
     }
 
     return strReturn;
@@ -498,19 +819,19 @@ void CClient::SetSndCrdLeftInputChannel ( const int iNewChan )
 {
     // if client was running then first
     // stop it and restart again after new initialization
-    const bool bWasRunning = Sound.IsRunning();
+    const bool bWasRunning = pSound->IsRunning();
     if ( bWasRunning )
     {
-        Sound.Stop();
+        pSound->Stop();
     }
 
-    Sound.SetLeftInputChannel ( iNewChan );
+    pSound->SetLeftInputChannel ( iNewChan );
     Init();
 
     if ( bWasRunning )
     {
         // restart client
-        Sound.Start();
+        pSound->Start();
     }
 }
 
@@ -518,19 +839,19 @@ void CClient::SetSndCrdRightInputChannel ( const int iNewChan )
 {
     // if client was running then first
     // stop it and restart again after new initialization
-    const bool bWasRunning = Sound.IsRunning();
+    const bool bWasRunning = pSound->IsRunning();
     if ( bWasRunning )
     {
-        Sound.Stop();
+        pSound->Stop();
     }
 
-    Sound.SetRightInputChannel ( iNewChan );
+    pSound->SetRightInputChannel ( iNewChan );
     Init();
 
     if ( bWasRunning )
     {
         // restart client
-        Sound.Start();
+        pSound->Start();
     }
 }
 
@@ -538,19 +859,19 @@ void CClient::SetSndCrdLeftOutputChannel ( const int iNewChan )
 {
     // if client was running then first
     // stop it and restart again after new initialization
-    const bool bWasRunning = Sound.IsRunning();
+    const bool bWasRunning = pSound->IsRunning();
     if ( bWasRunning )
     {
-        Sound.Stop();
+        pSound->Stop();
     }
 
-    Sound.SetLeftOutputChannel ( iNewChan );
+    pSound->SetLeftOutputChannel ( iNewChan );
     Init();
 
     if ( bWasRunning )
     {
         // restart client
-        Sound.Start();
+        pSound->Start();
     }
 }
 
@@ -558,19 +879,19 @@ void CClient::SetSndCrdRightOutputChannel ( const int iNewChan )
 {
     // if client was running then first
     // stop it and restart again after new initialization
-    const bool bWasRunning = Sound.IsRunning();
+    const bool bWasRunning = pSound->IsRunning();
     if ( bWasRunning )
     {
-        Sound.Stop();
+        pSound->Stop();
     }
 
-    Sound.SetRightOutputChannel ( iNewChan );
+    pSound->SetRightOutputChannel ( iNewChan );
     Init();
 
     if ( bWasRunning )
     {
         // restart client
-        Sound.Start();
+        pSound->Start();
     }
 }
 
@@ -583,10 +904,10 @@ void CClient::OnSndCrdReinitRequest ( int iSndCrdResetType )
 
     // if client was running then first
     // stop it and restart again after new initialization
-    const bool bWasRunning = Sound.IsRunning();
+    const bool bWasRunning = pSound->IsRunning();
     if ( bWasRunning )
     {
-        Sound.Stop();
+        pSound->Stop();
     }
 
     // perform reinit request as indicated by the request type parameter
@@ -596,7 +917,11 @@ void CClient::OnSndCrdReinitRequest ( int iSndCrdResetType )
         {
             // reinit the driver if requested
             // (we use the currently selected driver)
-            Sound.SetDev ( Sound.GetDev() );
+            pSound->SetDev ( pSound->GetDev() );
+
+            // the driver settings might have been changed, i.e., the
+            // cached capabilities of the device are not valid anymore
+            mapSndCrdCaps.remove ( GetSndCrdCurDevName() );
         }
 
         // init client object (must always be performed if the driver
@@ -607,7 +932,7 @@ void CClient::OnSndCrdReinitRequest ( int iSndCrdResetType )
     if ( bWasRunning )
     {
         // restart client
-        Sound.Start();
+        pSound->Start();
     }
 }
 
@@ -621,17 +946,21 @@ eAudioCompressionType = CT_CELT;
     // init object
     Init();
 
+    // the features of the server are not known before it has sent them
+    bLocalMonitoringSupported = false;
+
     // enable channel
     Channel.SetEnable ( true );
 
     // start audio interface
-    Sound.Start();
+    pSound->Start();
 }
 
 void CClient::Stop()
 {
-    // stop audio interface
-    Sound.Stop();
+    // stop audio interface and audio processing
+    pSound->Stop();
+    AudioProcessingThread.Stop();
 
     // disable channel
     Channel.SetEnable ( false );
@@ -663,33 +992,123 @@ void CClient::Stop()
     PostWinMessage ( MS_RESET_ALL, 0 );
 }
 
-void CClient::Init()
+QString CClient::GetSndCrdCurDevName()
+{
+    const int iCurDev = pSound->GetDev();
+
+    if ( ( iCurDev >= 0 ) && ( iCurDev < pSound->GetNumDev() ) )
+    {
+        return pSound->GetDeviceName ( iCurDev );
+    }
+    else
+    {
+        return "";
+    }
+}
+
+bool CClient::GetSndCrdCaps ( QString& strDevName,
+                              int&     iCaps )
+{
+    strDevName = GetSndCrdCurDevName();
+
+    if ( mapSndCrdCaps.contains ( strDevName ) )
+    {
+        iCaps = mapSndCrdCaps[strDevName];
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+void CClient::ProbeSndCrdCaps()
 {
-    // check if possible frame size factors are supported
     const int iFraSizePreffered =
         FRAME_SIZE_FACTOR_PREFERRED * SYSTEM_FRAME_SIZE_SAMPLES;
 
     bFraSiFactPrefSupported =
-        ( Sound.Init ( iFraSizePreffered ) == iFraSizePreffered );
+        ( pSound->Init ( iFraSizePreffered ) == iFraSizePreffered );
 
     const int iFraSizeDefault =
         FRAME_SIZE_FACTOR_DEFAULT * SYSTEM_FRAME_SIZE_SAMPLES;
 
     bFraSiFactDefSupported =
-        ( Sound.Init ( iFraSizeDefault ) == iFraSizeDefault );
+        ( pSound->Init ( iFraSizeDefault ) == iFraSizeDefault );
 
     const int iFraSizeSafe =
         FRAME_SIZE_FACTOR_SAFE * SYSTEM_FRAME_SIZE_SAMPLES;
 
     bFraSiFactSafeSupported =
-        ( Sound.Init ( iFraSizeSafe ) == iFraSizeSafe );
+        ( pSound->Init ( iFraSizeSafe ) == iFraSizeSafe );
+
+    // store the result in the cache
+    int iCaps = 0;
+
+    if ( bFraSiFactPrefSupported )
+    {
+        iCaps |= SND_CRD_CAPS_PREF_SUPPORTED;
+    }
+
+    if ( bFraSiFactDefSupported )
+    {
+        iCaps |= SND_CRD_CAPS_DEF_SUPPORTED;
+    }
+
+    if ( bFraSiFactSafeSupported )
+    {
+        iCaps |= SND_CRD_CAPS_SAFE_SUPPORTED;
+    }
+
+    mapSndCrdCaps[GetSndCrdCurDevName()] = iCaps;
+    bSndCrdCapsCached = false;
+}
+
+void CClient::Init()
+{
+    // the audio processing thread must not run while the buffers are changed
+    AudioProcessingThread.Stop();
+
+    // check if possible frame size factors are supported (probing requires
+    // an initialization of the sound card for each frame size, therefore the
+    // result is cached per sound card device)
+    const QString strDevName  = GetSndCrdCurDevName();
+    const bool    bCapsCached = mapSndCrdCaps.contains ( strDevName );
+
+    if ( bCapsCached )
+    {
+        const int iCaps = mapSndCrdCaps[strDevName];
+
+        bFraSiFactPrefSupported = ( ( iCaps & SND_CRD_CAPS_PREF_SUPPORTED ) != 0 );
+        bFraSiFactDefSupported  = ( ( iCaps & SND_CRD_CAPS_DEF_SUPPORTED )  != 0 );
+        bFraSiFactSafeSupported = ( ( iCaps & SND_CRD_CAPS_SAFE_SUPPORTED ) != 0 );
+        bSndCrdCapsCached       = true;
+    }
+    else
+    {
+        ProbeSndCrdCaps();
+    }
 
     // translate block size index in actual block size
     const int iPrefMonoFrameSize =
         iSndCrdPrefFrameSizeFactor * SYSTEM_FRAME_SIZE_SAMPLES;
 
     // get actual sound card buffer size using preferred size
-    iMonoBlockSizeSam = Sound.Init ( iPrefMonoFrameSize );
+    iMonoBlockSizeSam = pSound->Init ( iPrefMonoFrameSize );
+
+    // the cached capabilities are outdated if the sound card does not give us
+    // a frame size which it supported before (e.g. the buffer size was
+    // changed in the driver setup) -> probe again
+    if ( bCapsCached &&
+         ( iMonoBlockSizeSam != iPrefMonoFrameSize ) &&
+         ( ( ( iSndCrdPrefFrameSizeFactor == FRAME_SIZE_FACTOR_PREFERRED ) && bFraSiFactPrefSupported ) ||
+           ( ( iSndCrdPrefFrameSizeFactor == FRAME_SIZE_FACTOR_DEFAULT )   && bFraSiFactDefSupported ) ||
+           ( ( iSndCrdPrefFrameSizeFactor == FRAME_SIZE_FACTOR_SAFE )      && bFraSiFactSafeSupported ) ) )
+    {
+        ProbeSndCrdCaps();
+
+        iMonoBlockSizeSam = pSound->Init ( iPrefMonoFrameSize );
+    }
 
     // Calculate the current sound card frame size factor. In case
     // the current mono block size is not a multiple of the system
@@ -721,33 +1140,42 @@ void CClient::Init()
 
         iStereoBlockSizeSam = 2 * iMonoBlockSizeSam;
 
-        // inits for conversion buffer (the size of the conversion buffer must
-        // be the sum of input/output sizes which is the worst case fill level)
-        const int iConBufSize =
-            iStereoBlockSizeSam + iSndCardStereoBlockSizeSamConvBuff;
-
-        SndCrdConversionBufferIn.Init  ( iConBufSize );
-        SndCrdConversionBufferOut.Init ( iConBufSize );
-        vecDataConvBuf.Init            ( iStereoBlockSizeSam );
-
-        // the output conversion buffer must be filled with the inner
-        // block size for initialization (this is the latency which is
-        // introduced by the conversion buffer) to avoid buffer underruns
-        const CVector<int16_t> vZeros ( iStereoBlockSizeSam, 0 );
-        SndCrdConversionBufferOut.Put ( vZeros, vZeros.Size() );
-
+        // the block size conversion is done by the buffers of the audio
+        // processing thread (see below)
         bSndCrdConversionBufferRequired = true;
     }
 
     // calculate stereo (two channels) buffer size
     iStereoBlockSizeSam = 2 * iMonoBlockSizeSam;
 
-    vecsAudioSndCrdMono.Init ( iMonoBlockSizeSam );
-    vecdAudioStereo.Init     ( iStereoBlockSizeSam );
+    // Inits for the buffers of the audio processing thread. The processed
+    // audio of a sound card block is available in the next audio callback,
+    // therefore the output buffer must be filled with one sound card block
+    // for initialization (plus one internal block if the block sizes differ
+    // which is the latency introduced by the block size conversion) to avoid
+    // buffer underruns.
+    const int iSndCrdStereoBlockSizeSam = 2 * GetSndCrdActualMonoBlSize();
+
+    iSndCrdBufferOutFill = iSndCrdStereoBlockSizeSam +
+        GetSndCrdConvBufAdditionalDelayMonoBlSize() * 2;
+
+    SndCrdBufferIn.Init  ( 4 * ( iSndCrdStereoBlockSizeSam + iStereoBlockSizeSam ) );
+    SndCrdBufferOut.Init ( 4 * ( iSndCrdStereoBlockSizeSam + iStereoBlockSizeSam ) );
+    vecfProcessStereo.Init ( iStereoBlockSizeSam );
+
+    const CVector<float> vZeros ( iSndCrdBufferOutFill, 0 );
+    SndCrdBufferOut.Put ( &vZeros[0], vZeros.Size() );
+
+    vecfAudioSndCrdMono.Init ( iMonoBlockSizeSam );
+
+    // the local monitoring signal is always stored as stereo
+    vecfLocalMonitor.Init ( iStereoBlockSizeSam );
 
     // init reverberation
-    AudioReverbL.Init ( SYSTEM_SAMPLE_RATE_HZ );
-    AudioReverbR.Init ( SYSTEM_SAMPLE_RATE_HZ );
+    AudioReverb.Init ( SYSTEM_SAMPLE_RATE_HZ );
+
+    // init audio processing load meter
+    AudioLoadMeter.Init ( iMonoBlockSizeSam );
 
     // inits for audio coding
     if ( eAudioCompressionType == CT_CELT )
@@ -812,8 +1240,6 @@ void CClient::Init()
             }
         }
     }
-    vecCeltData.Init ( iCeltNumCodedBytes );
-
     if ( bUseStereo )
     {
         opus_custom_encoder_ctl ( OpusEncoderStereo,
@@ -829,141 +1255,183 @@ void CClient::Init()
                                           iCeltNumCodedBytes ) ) );
     }
 
+    // forward error correction: each network frame additionally carries a
+    // low bit rate coding of the previous frame, this is only supported for
+    // OPUS and if the server knows about it (the OPUS codec is only used
+    // after the server has informed us so that the protocol features of the
+    // server are known at this point)
+    if ( bUseAudioFec &&
+         ( eAudioCompressionType == CT_OPUS ) &&
+         Channel.IsPeerFeatureSupported ( PROT_FEATURE_AUDIO_FEC ) )
+    {
+        if ( bUseStereo )
+        {
+            iFecNumCodedBytes = OPUS_NUM_BYTES_STEREO_FEC;
+        }
+        else
+        {
+            iFecNumCodedBytes = OPUS_NUM_BYTES_MONO_FEC;
+        }
+    }
+    else
+    {
+        iFecNumCodedBytes = 0;
+    }
+
     // inits for network and channel
-    vecbyNetwData.Init ( iCeltNumCodedBytes );
     if ( bUseStereo )
     {
-        vecsNetwork.Init ( iStereoBlockSizeSam );
+        vecfNetwork.Init ( iStereoBlockSizeSam );
 
         // set the channel network properties
         Channel.SetAudioStreamProperties ( eAudioCompressionType,
                                            iCeltNumCodedBytes,
                                            iSndCrdFrameSizeFactor,
-                                           2 );
+                                           2,
+                                           iFecNumCodedBytes );
     }
     else
     {
-        vecsNetwork.Init ( iMonoBlockSizeSam );
+        vecfNetwork.Init ( iMonoBlockSizeSam );
 
         // set the channel network properties
         Channel.SetAudioStreamProperties ( eAudioCompressionType,
                                            iCeltNumCodedBytes,
                                            iSndCrdFrameSizeFactor,
-                                           1 );
+                                           1,
+                                           iFecNumCodedBytes );
     }
 
+    // the network frame contains the redundant frame in case of FEC
+    iNetwFrameSize = Channel.GetNetwFrameSize();
+    vecbyNetwData.Init ( iNetwFrameSize );
+
+    // decoder output which is not used (a redundant frame which is not needed
+    // or a concealed frame which is replaced by a redundant frame)
+    vecfFecDecOut.Init ( 2 * SYSTEM_FRAME_SIZE_SAMPLES );
+
     // reset initialization phase flag
     bIsInitializationPhase = true;
+
+    // the audio processing thread waits for the first sound card block
+    AudioProcessingThread.Start();
 }
 
-void CClient::AudioCallback ( CVector<int16_t>& psData, void* arg )
+void CClient::AudioCallback ( CVector<float>& vecfData, void* arg )
 {
     // get the pointer to the object
     CClient* pMyClientObj = reinterpret_cast<CClient*> ( arg );
 
     // process audio data
-    pMyClientObj->ProcessSndCrdAudioData ( psData );
+    pMyClientObj->ProcessSndCrdAudioData ( vecfData );
 }
 
-void CClient::ProcessSndCrdAudioData ( CVector<int16_t>& vecsStereoSndCrd )
+void CClient::ProcessSndCrdAudioData ( CVector<float>& vecfStereoSndCrd )
 {
-    // check if a conversion buffer is required or not
-    if ( bSndCrdConversionBufferRequired )
+/*
+    this function is called in the real-time audio callback, it must not block
+*/
+    const int iSndCrdStereoBlockSizeSam = vecfStereoSndCrd.Size();
+
+    // pass the captured block to the audio processing thread (if the thread
+    // does not keep up, the block is dropped)
+    SndCrdBufferIn.Put ( &vecfStereoSndCrd[0], iSndCrdStereoBlockSizeSam );
+    AudioProcessingThread.Wake();
+
+    // if the audio processing thread was late, it has caught up in the
+    // meantime, drop the additional block to keep the latency constant
+    if ( SndCrdBufferOut.GetAvailData() >=
+         iSndCrdBufferOutFill + iSndCrdStereoBlockSizeSam )
     {
-        // add new sound card block in conversion buffer
-        SndCrdConversionBufferIn.Put ( vecsStereoSndCrd, vecsStereoSndCrd.Size() );
+        SndCrdBufferOut.Skip ( iSndCrdStereoBlockSizeSam );
+    }
 
-        // process all available blocks of data
-        while ( SndCrdConversionBufferIn.GetAvailData() >= iStereoBlockSizeSam )
-        {
-            // get one block of data for processing
-            SndCrdConversionBufferIn.Get ( vecDataConvBuf );
+    // get the processed audio data of the previous blocks, on a buffer
+    // underrun silence is played (the processing missed its deadline)
+    if ( !SndCrdBufferOut.Get ( &vecfStereoSndCrd[0], iSndCrdStereoBlockSizeSam ) )
+    {
+        vecfStereoSndCrd.Reset ( 0 );
+        AudioLoadMeter.AddOverrun();
+    }
+}
 
-            // process audio data
-            ProcessAudioDataIntern ( vecDataConvBuf );
+void CClient::AudioProcessingCallback ( void* arg )
+{
+    // get the pointer to the object
+    CClient* pMyClientObj = reinterpret_cast<CClient*> ( arg );
 
-            SndCrdConversionBufferOut.Put ( vecDataConvBuf, vecDataConvBuf.Size() );
-        }
+    // process audio data
+    pMyClientObj->ProcessAudioBlocks();
+}
 
-        // get processed sound card block out of the conversion buffer
-        SndCrdConversionBufferOut.Get ( vecsStereoSndCrd );
-    }
-    else
+void CClient::ProcessAudioBlocks()
+{
+    // process all complete blocks of the internal block size which are
+    // available (the sound card block size might be different)
+    while ( SndCrdBufferIn.Get ( &vecfProcessStereo[0], iStereoBlockSizeSam ) )
     {
-        // regular case: no conversion buffer required
-        // process audio data
-        ProcessAudioDataIntern ( vecsStereoSndCrd );
+        AudioLoadMeter.StartBlock();
+        ProcessAudioDataIntern ( vecfProcessStereo );
+        AudioLoadMeter.StopBlock();
+
+        SndCrdBufferOut.Put ( &vecfProcessStereo[0], iStereoBlockSizeSam );
     }
 }
 
-void CClient::ProcessAudioDataIntern ( CVector<int16_t>& vecsStereoSndCrd )
+void CClient::ProcessAudioDataIntern ( CVector<float>& vecfStereoSndCrd )
 {
     int i, j;
 
+    // the setting may be changed by the GUI during the processing
+    const bool bUseLocalMonitor = bLocalMonitoring && bLocalMonitoringSupported;
+
     // Transmit signal ---------------------------------------------------------
     // update stereo signal level meter
-    SignalLevelMeter.Update ( vecsStereoSndCrd );
-
-    // convert data from short to double
-    for ( i = 0; i < iStereoBlockSizeSam; i++ )
-    {
-        vecdAudioStereo[i] = static_cast<double> ( vecsStereoSndCrd[i] );
-    }
+    SignalLevelMeter.Update ( vecfStereoSndCrd );
 
-    // add reverberation effect if activated
+    // add reverberation effect if activated (the reverberation is applied on
+    // the sound card buffer directly since it is overwritten by the received
+    // audio data afterwards)
     if ( iReverbLevel != 0 )
     {
         // calculate attenuation amplification factor
-        const double dRevLev =
-            static_cast<double> ( iReverbLevel ) / AUD_REVERB_MAX / 2;
+        const float fRevLev =
+            static_cast<float> ( iReverbLevel ) / AUD_REVERB_MAX / 2;
 
-        if ( bUseStereo )
-        {
-            // for stereo always apply reverberation effect on both channels
-            for ( i = 0; i < iStereoBlockSizeSam; i += 2 )
-            {
-                // left channel
-                vecdAudioStereo[i] +=
-                    dRevLev * AudioReverbL.ProcessSample ( vecdAudioStereo[i] );
+        // for stereo always apply reverberation effect on both channels, for
+        // mono only on the selected channel
+        float fRevLevLeft  = fRevLev;
+        float fRevLevRight = fRevLev;
 
-                // right channel
-                vecdAudioStereo[i + 1] +=
-                    dRevLev * AudioReverbR.ProcessSample ( vecdAudioStereo[i + 1] );
-            }
-        }
-        else
+        if ( !bUseStereo )
         {
             if ( bReverbOnLeftChan )
             {
-                for ( i = 0; i < iStereoBlockSizeSam; i += 2 )
-                {
-                    // left channel
-                    vecdAudioStereo[i] +=
-                        dRevLev * AudioReverbL.ProcessSample ( vecdAudioStereo[i] );
-                }
+                fRevLevRight = 0;
             }
             else
             {
-                for ( i = 1; i < iStereoBlockSizeSam; i += 2 )
-                {
-                    // right channel
-                    vecdAudioStereo[i] +=
-                        dRevLev * AudioReverbR.ProcessSample ( vecdAudioStereo[i] );
-                }
+                fRevLevLeft = 0;
             }
         }
+
+        AudioReverb.Process ( &vecfStereoSndCrd[0],
+                              &vecfStereoSndCrd[0],
+                              iMonoBlockSizeSam,
+                              fRevLevLeft,
+                              fRevLevRight );
     }
 
-    // mix both signals depending on the fading setting, convert
-    // from double to short
+    // mix both signals depending on the fading setting (no type conversion
+    // is required since the audio codecs use float samples, too)
     if ( iAudioInFader == AUD_FADER_IN_MIDDLE )
     {
         if ( bUseStereo )
         {
-            // perform type conversion
+            // copy the stereo signal
             for ( i = 0; i < iStereoBlockSizeSam; i++ )
             {
-                vecsNetwork[i] = Double2Short ( vecdAudioStereo[i] );
+                vecfNetwork[i] = vecfStereoSndCrd[i];
             }
         }
         else
@@ -971,9 +1439,8 @@ void CClient::ProcessAudioDataIntern ( CVector<int16_t>& vecsStereoSndCrd )
             // mix channels together
             for ( i = 0, j = 0; i < iMonoBlockSizeSam; i++, j += 2 )
             {
-                vecsNetwork[i] =
-                    Double2Short ( ( vecdAudioStereo[j] +
-                    vecdAudioStereo[j + 1] ) / 2 );
+                vecfNetwork[i] =
+                    ( vecfStereoSndCrd[j] + vecfStereoSndCrd[j + 1] ) / 2;
             }
         }
     }
@@ -982,7 +1449,7 @@ void CClient::ProcessAudioDataIntern ( CVector<int16_t>& vecsStereoSndCrd )
         if ( bUseStereo )
         {
             // stereo
-            const double dAttFactStereo = static_cast<double> (
+            const float fAttFactStereo = static_cast<float> (
                 AUD_FADER_IN_MIDDLE - abs ( AUD_FADER_IN_MIDDLE - iAudioInFader ) ) /
                 AUD_FADER_IN_MIDDLE;
 
@@ -991,11 +1458,8 @@ void CClient::ProcessAudioDataIntern ( CVector<int16_t>& vecsStereoSndCrd )
                 for ( i = 0, j = 0; i < iMonoBlockSizeSam; i++, j += 2 )
                 {
                     // attenuation on right channel
-                    vecsNetwork[j] = Double2Short (
-                        vecdAudioStereo[j] );
-
-                    vecsNetwork[j + 1] = Double2Short (
-                        dAttFactStereo * vecdAudioStereo[j + 1] );
+                    vecfNetwork[j]     = vecfStereoSndCrd[j];
+                    vecfNetwork[j + 1] = fAttFactStereo * vecfStereoSndCrd[j + 1];
                 }
             }
             else
@@ -1003,11 +1467,8 @@ void CClient::ProcessAudioDataIntern ( CVector<int16_t>& vecsStereoSndCrd )
                 for ( i = 0, j = 0; i < iMonoBlockSizeSam; i++, j += 2 )
                 {
                     // attenuation on left channel
-                    vecsNetwork[j] = Double2Short (
-                        dAttFactStereo * vecdAudioStereo[j] );
-
-                    vecsNetwork[j + 1] = Double2Short (
-                        vecdAudioStereo[j + 1] );
+                    vecfNetwork[j]     = fAttFactStereo * vecfStereoSndCrd[j];
+                    vecfNetwork[j + 1] = vecfStereoSndCrd[j + 1];
                 }
             }
         }
@@ -1017,11 +1478,11 @@ void CClient::ProcessAudioDataIntern ( CVector<int16_t>& vecsStereoSndCrd )
             // make sure that in the middle position the two channels are
             // amplified by 1/2, if the pan is set to one channel, this
             // channel should have an amplification of 1 
-            const double dAttFactMono = static_cast<double> (
+            const float fAttFactMono = static_cast<float> (
                 AUD_FADER_IN_MIDDLE - abs ( AUD_FADER_IN_MIDDLE - iAudioInFader ) ) /
                 AUD_FADER_IN_MIDDLE / 2;
 
-            const double dAmplFactMono = 0.5 + static_cast<double> (
+            const float fAmplFactMono = 0.5f + static_cast<float> (
                 abs ( AUD_FADER_IN_MIDDLE - iAudioInFader ) ) /
                 AUD_FADER_IN_MIDDLE / 2;
 
@@ -1030,9 +1491,8 @@ void CClient::ProcessAudioDataIntern ( CVector<int16_t>& vecsStereoSndCrd )
                 for ( i = 0, j = 0; i < iMonoBlockSizeSam; i++, j += 2 )
                 {
                     // attenuation on right channel
-                    vecsNetwork[i] = Double2Short (
-                        dAmplFactMono * vecdAudioStereo[j] +
-                        dAttFactMono * vecdAudioStereo[j + 1] );
+                    vecfNetwork[i] = fAmplFactMono * vecfStereoSndCrd[j] +
+                        fAttFactMono * vecfStereoSndCrd[j + 1];
                 }
             }
             else
@@ -1040,69 +1500,123 @@ void CClient::ProcessAudioDataIntern ( CVector<int16_t>& vecsStereoSndCrd )
                 for ( i = 0, j = 0; i < iMonoBlockSizeSam; i++, j += 2 )
                 {
                     // attenuation on left channel
-                    vecsNetwork[i] = Double2Short (
-                        dAmplFactMono * vecdAudioStereo[j + 1] +
-                        dAttFactMono * vecdAudioStereo[j] );
+                    vecfNetwork[i] = fAmplFactMono * vecfStereoSndCrd[j + 1] +
+                        fAttFactMono * vecfStereoSndCrd[j];
                 }
             }
         }
     }
 
-    for ( i = 0; i < iSndCrdFrameSizeFactor; i++ )
+    // keep the transmitted signal (with reverberation and pan applied) for the
+    // local monitoring
+    if ( bUseLocalMonitor )
     {
         if ( bUseStereo )
         {
-            // encode current audio frame
-            if ( eAudioCompressionType == CT_CELT )
+            for ( i = 0; i < iStereoBlockSizeSam; i++ )
             {
-                cc6_celt_encode ( CeltEncoderStereo,
-                                  &vecsNetwork[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES],
-                                  NULL,
-                                  &vecCeltData[0],
-                                  iCeltNumCodedBytes );
+                vecfLocalMonitor[i] = vecfNetwork[i];
             }
-            else
+        }
+        else
+        {
+            for ( i = 0, j = 0; i < iMonoBlockSizeSam; i++, j += 2 )
             {
-                opus_custom_encode ( OpusEncoderStereo,
-                                     &vecsNetwork[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES],
-                                     SYSTEM_FRAME_SIZE_SAMPLES,
-                                     &vecCeltData[0],
-                                     iCeltNumCodedBytes );
+                vecfLocalMonitor[j] = vecfLocalMonitor[j + 1] = vecfNetwork[i];
             }
         }
-        else
+    }
+
+    for ( i = 0; i < iSndCrdFrameSizeFactor; i++ )
+    {
+        // the coded audio data is directly written in the send buffer of the
+        // channel (no intermediate copy)
+        uint8_t* pbyCodedData = Channel.GetSendBufPointer ( iNetwFrameSize );
+
+        if ( pbyCodedData != NULL )
         {
-            // encode current audio frame
-            if ( eAudioCompressionType == CT_CELT )
+            if ( bUseStereo )
             {
-                cc6_celt_encode ( CeltEncoderMono,
-                                  &vecsNetwork[i * SYSTEM_FRAME_SIZE_SAMPLES],
-                                  NULL,
-                                  &vecCeltData[0],
-                                  iCeltNumCodedBytes );
+                // encode current audio frame
+                if ( eAudioCompressionType == CT_CELT )
+                {
+                    cc6_celt_encode_float ( CeltEncoderStereo,
+                                            &vecfNetwork[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES],
+                                            NULL,
+                                            pbyCodedData,
+                                            iCeltNumCodedBytes );
+                }
+                else
+                {
+                    opus_custom_encode_float ( OpusEncoderStereo,
+                                               &vecfNetwork[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES],
+                                               SYSTEM_FRAME_SIZE_SAMPLES,
+                                               pbyCodedData,
+                                               iCeltNumCodedBytes );
+
+                    if ( iFecNumCodedBytes > 0 )
+                    {
+                        // redundant frame behind the coded frame
+                        opus_custom_encode_float ( OpusEncoderFecStereo,
+                                                   &vecfNetwork[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES],
+                                                   SYSTEM_FRAME_SIZE_SAMPLES,
+                                                   pbyCodedData + iCeltNumCodedBytes,
+                                                   iFecNumCodedBytes );
+                    }
+                }
             }
             else
             {
-                opus_custom_encode ( OpusEncoderMono,
-                                     &vecsNetwork[i * SYSTEM_FRAME_SIZE_SAMPLES],
-                                     SYSTEM_FRAME_SIZE_SAMPLES,
-                                     &vecCeltData[0],
-                                     iCeltNumCodedBytes );
+                // encode current audio frame
+                if ( eAudioCompressionType == CT_CELT )
+                {
+                    cc6_celt_encode_float ( CeltEncoderMono,
+                                            &vecfNetwork[i * SYSTEM_FRAME_SIZE_SAMPLES],
+                                            NULL,
+                                            pbyCodedData,
+                                            iCeltNumCodedBytes );
+                }
+                else
+                {
+                    opus_custom_encode_float ( OpusEncoderMono,
+                                               &vecfNetwork[i * SYSTEM_FRAME_SIZE_SAMPLES],
+                                               SYSTEM_FRAME_SIZE_SAMPLES,
+                                               pbyCodedData,
+                                               iCeltNumCodedBytes );
+
+                    if ( iFecNumCodedBytes > 0 )
+                    {
+                        // redundant frame behind the coded frame
+                        opus_custom_encode_float ( OpusEncoderFecMono,
+                                                   &vecfNetwork[i * SYSTEM_FRAME_SIZE_SAMPLES],
+                                                   SYSTEM_FRAME_SIZE_SAMPLES,
+                                                   pbyCodedData + iCeltNumCodedBytes,
+                                                   iFecNumCodedBytes );
+                    }
+                }
+            }
+
+            // send coded audio through the network if the packet is complete
+            if ( Channel.PrepSendPacket ( iNetwFrameSize ) )
+            {
+                Socket.SendPacket ( Channel.GetSendPacket(),
+                                    Channel.GetAddress() );
             }
         }
-
-        // send coded audio through the network
-        Socket.SendPacket ( Channel.PrepSendPacket ( vecCeltData ),
-            Channel.GetAddress() );
     }
 
 
     // Receive signal ----------------------------------------------------------
     for ( i = 0; i < iSndCrdFrameSizeFactor; i++ )
     {
-        // receive a new block
+        // receive a new block (with forward error correction the block
+        // additionally contains a redundant frame, if the number of coded
+        // bytes is zero, a lost frame was recovered by the redundant frame)
+        int iNumCodedBytes;
+        int iNumFecBytes;
+
         const bool bReceiveDataOk =
-            ( Channel.GetData ( vecbyNetwData ) == GS_BUFFER_OK );
+            ( Channel.GetData ( vecbyNetwData, iNumCodedBytes, iNumFecBytes ) == GS_BUFFER_OK );
 
         if ( bReceiveDataOk )
         {
@@ -1124,76 +1638,109 @@ void CClient::ProcessAudioDataIntern ( CVector<int16_t>& vecsStereoSndCrd )
             {
                 if ( eAudioCompressionType == CT_CELT )
                 {
-                    cc6_celt_decode ( CeltDecoderStereo,
-                                      &vecbyNetwData[0],
-                                      iCeltNumCodedBytes,
-                                      &vecsStereoSndCrd[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES] );
+                    cc6_celt_decode_float ( CeltDecoderStereo,
+                                            &vecbyNetwData[0],
+                                            iNumCodedBytes,
+                                            &vecfStereoSndCrd[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES] );
                 }
                 else
                 {
-                    opus_custom_decode ( OpusDecoderStereo,
-                                         &vecbyNetwData[0],
-                                         iCeltNumCodedBytes,
-                                         &vecsStereoSndCrd[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES],
-                                         SYSTEM_FRAME_SIZE_SAMPLES );
+                    // the regular decoder conceals the frame which is
+                    // replaced by the redundant frame so that its state
+                    // stays continuous in time
+                    opus_custom_decode_float ( OpusDecoderStereo,
+                                               iNumCodedBytes > 0 ? &vecbyNetwData[0] : NULL,
+                                               iNumCodedBytes > 0 ? iNumCodedBytes : iCeltNumCodedBytes,
+                                               iNumCodedBytes > 0 ?
+                                                   &vecfStereoSndCrd[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES] :
+                                                   &vecfFecDecOut[0],
+                                               SYSTEM_FRAME_SIZE_SAMPLES );
+
+                    // the redundant frames are always decoded by their own
+                    // decoder which has the state of the redundant encoder
+                    if ( iNumFecBytes > 0 )
+                    {
+                        opus_custom_decode_float ( OpusDecoderFecStereo,
+                                                   &vecbyNetwData[iNumCodedBytes],
+                                                   iNumFecBytes,
+                                                   iNumCodedBytes > 0 ?
+                                                       &vecfFecDecOut[0] :
+                                                       &vecfStereoSndCrd[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES],
+                                                   SYSTEM_FRAME_SIZE_SAMPLES );
+                    }
                 }
             }
             else
             {
                 if ( eAudioCompressionType == CT_CELT )
                 {
-                    cc6_celt_decode ( CeltDecoderMono,
-                                      &vecbyNetwData[0],
-                                      iCeltNumCodedBytes,
-                                      &vecsAudioSndCrdMono[i * SYSTEM_FRAME_SIZE_SAMPLES] );
+                    cc6_celt_decode_float ( CeltDecoderMono,
+                                            &vecbyNetwData[0],
+                                            iNumCodedBytes,
+                                            &vecfAudioSndCrdMono[i * SYSTEM_FRAME_SIZE_SAMPLES] );
                 }
                 else
                 {
-                    opus_custom_decode ( OpusDecoderMono,
-                                         &vecbyNetwData[0],
-                                         iCeltNumCodedBytes,
-                                         &vecsAudioSndCrdMono[i * SYSTEM_FRAME_SIZE_SAMPLES],
-                                         SYSTEM_FRAME_SIZE_SAMPLES );
+                    opus_custom_decode_float ( OpusDecoderMono,
+                                               iNumCodedBytes > 0 ? &vecbyNetwData[0] : NULL,
+                                               iNumCodedBytes > 0 ? iNumCodedBytes : iCeltNumCodedBytes,
+                                               iNumCodedBytes > 0 ?
+                                                   &vecfAudioSndCrdMono[i * SYSTEM_FRAME_SIZE_SAMPLES] :
+                                                   &vecfFecDecOut[0],
+                                               SYSTEM_FRAME_SIZE_SAMPLES );
+
+                    if ( iNumFecBytes > 0 )
+                    {
+                        opus_custom_decode_float ( OpusDecoderFecMono,
+                                                   &vecbyNetwData[iNumCodedBytes],
+                                                   iNumFecBytes,
+                                                   iNumCodedBytes > 0 ?
+                                                       &vecfFecDecOut[0] :
+                                                       &vecfAudioSndCrdMono[i * SYSTEM_FRAME_SIZE_SAMPLES],
+                                                   SYSTEM_FRAME_SIZE_SAMPLES );
+                    }
                 }
             }
         }
         else
         {
             // lost packet
+            iNumLostPackets.ref();
+
             if ( bUseStereo )
             {
                 if ( eAudioCompressionType == CT_CELT )
                 {
-                    cc6_celt_decode ( CeltDecoderStereo,
-                                      NULL,
-                                      0,
-                                      &vecsStereoSndCrd[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES] );
+                    cc6_celt_decode_float ( CeltDecoderStereo,
+                                            NULL,
+                                            0,
+                                            &vecfStereoSndCrd[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES] );
                 }
                 else
                 {
-                    opus_custom_decode ( OpusDecoderStereo,
-                                         NULL,
-                                         iCeltNumCodedBytes,
-                                         &vecsStereoSndCrd[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES],
-                                         SYSTEM_FRAME_SIZE_SAMPLES );
+                    opus_custom_decode_float ( OpusDecoderStereo,
+                                               NULL,
+                                               iCeltNumCodedBytes,
+                                               &vecfStereoSndCrd[i * 2 * SYSTEM_FRAME_SIZE_SAMPLES],
+                                               SYSTEM_FRAME_SIZE_SAMPLES );
                 }
             }
             else
             {
                 if ( eAudioCompressionType == CT_CELT )
                 {
-                    cc6_celt_decode ( CeltDecoderMono,
-                                      NULL,
-                                      0,
-                                      &vecsAudioSndCrdMono[i * SYSTEM_FRAME_SIZE_SAMPLES] );
+                    cc6_celt_decode_float ( CeltDecoderMono,
+                                            NULL,
+                                            0,
+                                            &vecfAudioSndCrdMono[i * SYSTEM_FRAME_SIZE_SAMPLES] );
                 }
                 else
                 {
-                    opus_custom_decode ( OpusDecoderMono,
-                                         NULL,
-                                         iCeltNumCodedBytes,
-                                         &vecsAudioSndCrdMono[i * SYSTEM_FRAME_SIZE_SAMPLES],
-                                         SYSTEM_FRAME_SIZE_SAMPLES );
+                    opus_custom_decode_float ( OpusDecoderMono,
+                                               NULL,
+                                               iCeltNumCodedBytes,
+                                               &vecfAudioSndCrdMono[i * SYSTEM_FRAME_SIZE_SAMPLES],
+                                               SYSTEM_FRAME_SIZE_SAMPLES );
                 }
             }
         }
@@ -1207,7 +1754,7 @@ static FILE* pFileDelay = fopen("c:\\temp\\test2.dat", "wb");
 short sData[2];
 for (i = 0; i < iMonoBlockSizeSam; i++)
 {
-    sData[0] = (short) vecsAudioSndCrdMono[i];
+    sData[0] = (short) vecfAudioSndCrdMono[i];
     fwrite(&sData, size_t(2), size_t(1), pFileDelay);
 }
 fflush(pFileDelay);
@@ -1223,15 +1770,28 @@ fflush(pFileDelay);
             // copy mono data in stereo sound card buffer
             for ( i = 0, j = 0; i < iMonoBlockSizeSam; i++, j += 2 )
             {
-                vecsStereoSndCrd[j] = vecsStereoSndCrd[j + 1] =
-                    vecsAudioSndCrdMono[i];
+                vecfStereoSndCrd[j] = vecfStereoSndCrd[j + 1] =
+                    vecfAudioSndCrdMono[i];
             }
         }
     }
     else
     {
         // if not connected, clear data
-        vecsStereoSndCrd.Reset ( 0 );
+        vecfStereoSndCrd.Reset ( 0 );
+    }
+
+    // local monitoring: mix the own signal directly into the output without
+    // the network round trip (the server excludes it from our mix)
+    if ( bUseLocalMonitor )
+    {
+        const float fLocalMonLev =
+            static_cast<float> ( iLocalMonitorLevel ) / AUD_LOCAL_MONITOR_MAX;
+
+        for ( i = 0; i < iStereoBlockSizeSam; i++ )
+        {
+            vecfStereoSndCrd[i] += fLocalMonLev * vecfLocalMonitor[i];
+        }
     }
 
     // update socket buffer size
@@ -1254,11 +1814,12 @@ int CClient::EstimatedOverallDelay ( const int iPingTimeMs )
 
     // we assume that we have two period sizes for the input and one for the
     // output, therefore we have "3 *" instead of "2 *" (for input and output)
-    // the actual sound card buffer size, also consider delay introduced by
+    // the actual sound card buffer size, one period size is added for the
+    // audio processing thread, also consider delay introduced by
     // sound card conversion buffer by using
     // "GetSndCrdConvBufAdditionalDelayMonoBlSize"
     const double dTotalSoundCardDelayMs =
-        ( 3 * GetSndCrdActualMonoBlSize() +
+        ( 4 * GetSndCrdActualMonoBlSize() +
         GetSndCrdConvBufAdditionalDelayMonoBlSize() ) *
         1000 / SYSTEM_SAMPLE_RATE_HZ;
 
@@ -1279,3 +1840,27 @@ int CClient::EstimatedOverallDelay ( const int iPingTimeMs )
 
     return MathUtils::round ( dTotalBufferDelayMs + iPingTimeMs );
 }
+
+int CClient::MeasuredOverallDelay()
+{
+/*
+    The delay measurement covers the path from the encoder input to the
+    decoder output. The delay of the sound card buffers and of the buffers of
+    the audio processing thread is known exactly and is added: one sound card
+    block for capturing, the fill of the output buffer and one sound card block
+    for playing.
+*/
+    // no valid measurement result available (e.g., if the server does not
+    // answer the delay measurement messages)
+    if ( !bDelayMeasurement || ( iLastDelayMeasTimeMs < 0 ) ||
+         ( PreciseTime.elapsed() - iLastDelayMeasTimeMs > DELAY_MEAS_TIME_OUT_MS ) )
+    {
+        return -1;
+    }
+
+    const int iLocalDelaySam = 2 * GetSndCrdActualMonoBlSize() +
+        iSndCrdBufferOutFill / 2;
+
+    return MathUtils::round ( DelayMeasAv.GetAverage() +
+        static_cast<double> ( iLocalDelaySam ) * 1000 / SYSTEM_SAMPLE_RATE_HZ );
+}
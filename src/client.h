@@ -30,6 +30,8 @@
 #include <QString>
 #include <QDateTime>
 #include <QMessageBox>
+#include <QThread>
+#include <QMap>
 #include "cc6_celt.h"
 #include "opus_custom.h"
 #include "global.h"
@@ -37,6 +39,7 @@
 #include "channel.h"
 #include "util.h"
 #include "buffer.h"
+#include "soundfile.h"
 #ifdef LLCON_VST_PLUGIN
 # include "vstsound.h"
 #else
@@ -54,6 +57,14 @@
 # endif
 #endif
 
+// semaphores of the operating system for waking the audio processing thread
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
+# include <mach/mach.h>
+# include <mach/semaphore.h>
+#elif !defined ( _WIN32 )
+# include <semaphore.h>
+#endif
+
 
 /* Definitions ****************************************************************/
 // audio in fader range
@@ -64,6 +75,14 @@
 // audio reverberation range
 #define AUD_REVERB_MAX                          100
 
+// local monitoring level range
+#define AUD_LOCAL_MONITOR_MAX                   100
+
+// overall delay measurement: number of averaged results and maximum age of the
+// last result (the requests are sent with the ping messages)
+#define DELAY_MEAS_AV_LEN                       5
+#define DELAY_MEAS_TIME_OUT_MS                  5000
+
 // CELT number of coded bytes per audio packet
 // 24: mono low quality            156 kbps (128) / 114 kbps (256)
 // 44: mono normal quality         216 kbps (128) / 174 kbps (256)
@@ -95,18 +114,76 @@
 #define OPUS_NUM_BYTES_STEREO_NORMAL_QUALITY    71
 #define OPUS_NUM_BYTES_STEREO_HIGH_QUALITY      142
 
+// OPUS number of coded bytes of the redundant low bit rate frame which is
+// appended to each audio packet for forward error correction
+// 12: mono                         36 kbps
+// 20: stereo                       60 kbps
+#define OPUS_NUM_BYTES_MONO_FEC                 12
+#define OPUS_NUM_BYTES_STEREO_FEC               20
+
+// bit masks of the cached sound card capabilities (supported frame size
+// factors of a sound card device)
+#define SND_CRD_CAPS_PREF_SUPPORTED             1
+#define SND_CRD_CAPS_DEF_SUPPORTED              2
+#define SND_CRD_CAPS_SAFE_SUPPORTED             4
+#define SND_CRD_CAPS_ALL                        7
+
 
 /* Classes ********************************************************************/
+// Audio processing thread -----------------------------------------------------
+// The audio coding and the network access of the client are done in this
+// thread so that the real-time audio callback only exchanges audio samples
+// with wait-free buffers. The audio callback wakes up the thread on each new
+// sound card block.
+class CAudioProcessingThread : public QThread
+{
+public:
+    CAudioProcessingThread ( void (*fpNewProcessCallback) ( void* arg ),
+                             void* arg );
+    virtual ~CAudioProcessingThread();
+
+    void Start();
+    void Stop();
+
+    // called in the audio callback, the semaphore of the operating system is
+    // used since it does not lock (the QSemaphore locks a mutex)
+    void Wake();
+
+protected:
+    virtual void run();
+
+    void WaitForWake();
+    bool TryWaitForWake();
+
+    void (*fpProcessCallback) ( void* arg );
+    void*        pProcessCallbackArg;
+
+    bool         bRun;
+
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
+    semaphore_t  Semaphore;
+#elif defined ( _WIN32 )
+    HANDLE       Semaphore;
+#else
+    sem_t        Semaphore;
+#endif
+};
+
+
 class CClient : public QObject
 {
     Q_OBJECT
 
 public:
-    CClient ( const quint16 iPortNumber );
+    CClient ( const quint16  iPortNumber,
+              const QString& strAudioInFileName = "",
+              const QString& strAudioOutFileName = "" );
+
+    virtual ~CClient() { delete pSound; }
 
     void   Start();
     void   Stop();
-    bool   IsRunning() { return Sound.IsRunning(); }
+    bool   IsRunning() { return pSound->IsRunning(); }
     bool   SetServerAddr ( QString strNAddr );
     double MicLevelL() { return SignalLevelMeter.MicLevelLeft(); }
     double MicLevelR() { return SignalLevelMeter.MicLevelRight(); }
@@ -124,6 +201,9 @@ public:
     bool GetUseStereo() const { return bUseStereo; }
     void SetUseStereo ( const bool bNUseStereo );
 
+    bool GetUseAudioFec() const { return bUseAudioFec; }
+    void SetUseAudioFec ( const bool bNUseAudioFec );
+
     void SetServerListCentralServerAddress ( const QString& sNCentServAddr )
         { strCentralServerAddress = sNCentServAddr; }
 
@@ -146,10 +226,17 @@ public:
     void SetReverbOnLeftChan ( const bool bIL )
     {
         bReverbOnLeftChan = bIL;
-        AudioReverbL.Clear();
-        AudioReverbR.Clear();
+        AudioReverb.Clear();
     }
 
+    // the own signal is mixed directly into the output, the server excludes
+    // it from our mix
+    bool GetLocalMonitoring() const { return bLocalMonitoring; }
+    void SetLocalMonitoring ( const bool bNLM );
+
+    int GetLocalMonitorLevel() const { return iLocalMonitorLevel; }
+    void SetLocalMonitorLevel ( const int iNL ) { iLocalMonitorLevel = iNL; }
+
     void SetDoAutoSockBufSize ( const bool bValue );
     bool GetDoAutoSockBufSize() const { return Channel.GetDoAutoSockBufSize(); }
 
@@ -175,28 +262,28 @@ public:
     int GetUploadRateKbps() { return Channel.GetUploadRateKbps(); }
 
     // sound card device selection
-    int     GetSndCrdNumDev() { return Sound.GetNumDev(); }
+    int     GetSndCrdNumDev() { return pSound->GetNumDev(); }
     QString GetSndCrdDeviceName ( const int iDiD )
-        { return Sound.GetDeviceName ( iDiD ); }
+        { return pSound->GetDeviceName ( iDiD ); }
 
     QString SetSndCrdDev ( const int iNewDev );
-    int     GetSndCrdDev() { return Sound.GetDev(); }
-    void    OpenSndCrdDriverSetup() { Sound.OpenDriverSetup(); }
+    int     GetSndCrdDev() { return pSound->GetDev(); }
+    void    OpenSndCrdDriverSetup() { pSound->OpenDriverSetup(); }
 
     // sound card channel selection
-    int     GetSndCrdNumInputChannels() { return Sound.GetNumInputChannels(); }
-    QString GetSndCrdInputChannelName ( const int iDiD ) { return Sound.GetInputChannelName ( iDiD ); }
+    int     GetSndCrdNumInputChannels() { return pSound->GetNumInputChannels(); }
+    QString GetSndCrdInputChannelName ( const int iDiD ) { return pSound->GetInputChannelName ( iDiD ); }
     void    SetSndCrdLeftInputChannel  ( const int iNewChan );
     void    SetSndCrdRightInputChannel ( const int iNewChan );
-    int     GetSndCrdLeftInputChannel()  { return Sound.GetLeftInputChannel(); }
-    int     GetSndCrdRightInputChannel() { return Sound.GetRightInputChannel(); }
+    int     GetSndCrdLeftInputChannel()  { return pSound->GetLeftInputChannel(); }
+    int     GetSndCrdRightInputChannel() { return pSound->GetRightInputChannel(); }
 
-    int     GetSndCrdNumOutputChannels() { return Sound.GetNumOutputChannels(); }
-    QString GetSndCrdOutputChannelName ( const int iDiD ) { return Sound.GetOutputChannelName ( iDiD ); }
+    int     GetSndCrdNumOutputChannels() { return pSound->GetNumOutputChannels(); }
+    QString GetSndCrdOutputChannelName ( const int iDiD ) { return pSound->GetOutputChannelName ( iDiD ); }
     void    SetSndCrdLeftOutputChannel  ( const int iNewChan );
     void    SetSndCrdRightOutputChannel ( const int iNewChan );
-    int     GetSndCrdLeftOutputChannel()  { return Sound.GetLeftOutputChannel(); }
-    int     GetSndCrdRightOutputChannel() { return Sound.GetRightOutputChannel(); }
+    int     GetSndCrdLeftOutputChannel()  { return pSound->GetLeftOutputChannel(); }
+    int     GetSndCrdRightOutputChannel() { return pSound->GetRightOutputChannel(); }
 
     void SetSndCrdPrefFrameSizeFactor ( const int iNewFactor );
     int GetSndCrdPrefFrameSizeFactor()
@@ -234,6 +321,18 @@ public:
     bool GetFraSiFactDefSupported()  { return bFraSiFactDefSupported; }
     bool GetFraSiFactSafeSupported() { return bFraSiFactSafeSupported; }
 
+    // the supported frame sizes were taken from the cache and not probed
+    bool GetSndCrdCapsCached() const { return bSndCrdCapsCached; }
+
+    // The supported frame size factors are probed by initializing the sound
+    // card with each of them. The result is cached per device (and stored in
+    // the settings file) so that a reconfiguration of the client only
+    // initializes the sound card once. Returns false if the capabilities of
+    // the current device are not yet known.
+    bool GetSndCrdCaps ( QString& strDevName, int& iCaps );
+    void SetSndCrdCaps ( const QString& strDevName, const int iCaps )
+        { mapSndCrdCaps[strDevName] = iCaps; }
+
     void SetRemoteChanGain ( const int iId, const double dGain )
         { Channel.SetRemoteChanGain ( iId, dGain ); }
 
@@ -242,8 +341,7 @@ public:
     void CreateChatTextMes ( const QString& strChatText )
         { Channel.CreateChatTextMes ( strChatText ); }
 
-    void CreateCLPingMes()
-        { ConnLessProtocol.CreateCLPingMes ( Channel.GetAddress(), PreparePingMessage() ); }
+    void CreateCLPingMes();
 
     void CreateCLServerListPingMes ( const CHostAddress& InetAddr )
     {
@@ -256,10 +354,29 @@ public:
         { ConnLessProtocol.CreateCLReqServerListMes ( InetAddr ); }
 
     int EstimatedOverallDelay ( const int iPingTimeMs );
+    int MeasuredOverallDelay();
+
+    bool GetDelayMeasurement() const { return bDelayMeasurement; }
+    void SetDelayMeasurement ( const bool bEnable )
+        { bDelayMeasurement = bEnable; }
+
+    // average and peak audio processing load in percent of the block duration
+    // since the last call (-1 if no audio was processed in the meantime) and
+    // number of sound card blocks which were not processed in time
+    void GetAndResetAudioLoad ( int& iAverageLoad, int& iPeakLoad )
+        { AudioLoadMeter.GetAndResetLoad ( iAverageLoad, iPeakLoad ); }
+
+    int GetNumAudioOverruns() const { return AudioLoadMeter.GetNumOverruns(); }
 
     void GetBufErrorRates ( CVector<double>& vecErrRates, double& dLimit )
         { Channel.GetBufErrorRates ( vecErrRates, dLimit ); }
 
+    double GetArrivalTimeRmsJitterMs() { return Channel.GetArrivalTimeRmsJitterMs(); }
+
+    // number of audio packets which were missing in the jitter buffer since
+    // the last call
+    int GetAndResetNumLostPackets() { return iNumLostPackets.fetchAndStoreOrdered ( 0 ); }
+
     // settings
     CVector<QString> vstrIPAddress;
     CChannelCoreInfo ChannelInfo;
@@ -277,16 +394,21 @@ public:
 
 #ifdef LLCON_VST_PLUGIN
     // VST version must have direct access to sound object
-    CSound* GetSound() { return &Sound; }
+    // the VST plug-in always uses its own sound interface
+    CSound* GetSound() { return static_cast<CSound*> ( pSound ); }
 #endif
 
 protected:
-    // callback function must be static, otherwise it does not work
-    static void AudioCallback ( CVector<short>& psData, void* arg );
+    // callback functions must be static, otherwise it does not work
+    static void AudioCallback ( CVector<float>& vecfData, void* arg );
+    static void AudioProcessingCallback ( void* arg );
 
     void        Init();
-    void        ProcessSndCrdAudioData ( CVector<short>& vecsStereoSndCrd );
-    void        ProcessAudioDataIntern ( CVector<short>& vecsStereoSndCrd );
+    void        ProbeSndCrdCaps();
+    QString     GetSndCrdCurDevName();
+    void        ProcessSndCrdAudioData ( CVector<float>& vecfStereoSndCrd );
+    void        ProcessAudioBlocks();
+    void        ProcessAudioDataIntern ( CVector<float>& vecfStereoSndCrd );
 
     int         PreparePingMessage();
     int         EvaluatePingMessage ( const int iMs );
@@ -296,6 +418,7 @@ protected:
 void SetAudoCompressiontype ( const EAudComprType eNAudCompressionType );
 
     // only one channel is needed for client application
+    CChannelTimeOutWheel    TimeOutWheel;
     CChannel                Channel;
     CProtocol               ConnLessProtocol;
 
@@ -311,41 +434,58 @@ void SetAudoCompressiontype ( const EAudComprType eNAudCompressionType );
     OpusCustomDecoder*      OpusDecoderMono;
     OpusCustomEncoder*      OpusEncoderStereo;
     OpusCustomDecoder*      OpusDecoderStereo;
+    OpusCustomEncoder*      OpusEncoderFecMono;
+    OpusCustomDecoder*      OpusDecoderFecMono;
+    OpusCustomEncoder*      OpusEncoderFecStereo;
+    OpusCustomDecoder*      OpusDecoderFecStereo;
     EAudComprType           eAudioCompressionType;
     int                     iCeltNumCodedBytes;
+    int                     iFecNumCodedBytes;
+    int                     iNetwFrameSize;
     EAudioQuality           eAudioQuality;
     bool                    bUseStereo;
+    bool                    bUseAudioFec;
     bool                    bIsInitializationPhase;
-    CVector<unsigned char>  vecCeltData;
 
-#ifdef ENABLE_RECEIVE_SOCKET_IN_SEPARATE_THREAD
     CHighPrioSocket         Socket;
-#else
-    CSocket                 Socket;
-#endif
-    CSound                  Sound;
+    CSoundBase*             pSound;
     CStereoSignalLevelMeter SignalLevelMeter;
 
     CVector<uint8_t>        vecbyNetwData;
+    QAtomicInt              iNumLostPackets;
 
     int                     iAudioInFader;
     bool                    bReverbOnLeftChan;
     int                     iReverbLevel;
-    CAudioReverb            AudioReverbL;
-    CAudioReverb            AudioReverbR;
+    CAudioReverb            AudioReverb;
+    bool                    bLocalMonitoring;
+    bool                    bLocalMonitoringSupported;
+    int                     iLocalMonitorLevel;
+    bool                    bDelayMeasurement;
+    CMovingAv<double>       DelayMeasAv;
+    int                     iLastDelayMeasTimeMs;
+    CAudioLoadMeter         AudioLoadMeter;
 
     int                     iSndCrdPrefFrameSizeFactor;
     int                     iSndCrdFrameSizeFactor;
 
     bool                    bSndCrdConversionBufferRequired;
     int                     iSndCardMonoBlockSizeSamConvBuff;
-    CBufferBase<int16_t>    SndCrdConversionBufferIn;
-    CBufferBase<int16_t>    SndCrdConversionBufferOut;
-    CVector<int16_t>        vecDataConvBuf;
+
+    // transfer of the sound card blocks from and to the audio processing
+    // thread (the buffers also convert the sound card block size to the
+    // internal block size)
+    CAudioProcessingThread  AudioProcessingThread;
+    CWaitFreeBuffer<float>  SndCrdBufferIn;
+    CWaitFreeBuffer<float>  SndCrdBufferOut;
+    int                     iSndCrdBufferOutFill;
+    CVector<float>          vecfProcessStereo;
 
     bool                    bFraSiFactPrefSupported;
     bool                    bFraSiFactDefSupported;
     bool                    bFraSiFactSafeSupported;
+    bool                    bSndCrdCapsCached;
+    QMap<QString, int>      mapSndCrdCaps;
 
     int                     iMonoBlockSizeSam;
     int                     iStereoBlockSizeSam;
@@ -356,9 +496,12 @@ void SetAudoCompressiontype ( const EAudComprType eNAudCompressionType );
     QString                 strCentralServerAddress;
     bool                    bUseDefaultCentralServerAddress;
 
-    CVector<int16_t>        vecsAudioSndCrdMono;
-    CVector<double>         vecdAudioStereo;
-    CVector<int16_t>        vecsNetwork;
+    // the audio processing uses normalized float samples from the sound card
+    // to the audio codec
+    CVector<float>          vecfAudioSndCrdMono;
+    CVector<float>          vecfNetwork;
+    CVector<float>          vecfFecDecOut;
+    CVector<float>          vecfLocalMonitor;
 
     // server settings
     int                     iServerSockBufNumFrames;
@@ -376,8 +519,12 @@ public slots:
     void OnJittBufSizeChanged ( int iNewJitBufSize );
     void OnReqChanInfo() { Channel.SetRemoteInfo ( ChannelInfo ); }
     void OnNewConnection();
+    void OnProtFeaturesReceived();
     void OnCLPingReceived ( CHostAddress InetAddr,
                             int          iMs );
+    void OnCLAudioDelayMeasReceived ( CHostAddress InetAddr,
+                                      int          iMs,
+                                      int          iServerJitBufFill );
 
     void OnSendCLProtMessage ( CHostAddress InetAddr, CVector<uint8_t> vecMessage );
     void OnCLPingWithNumClientsReceived ( CHostAddress InetAddr,
@@ -400,6 +547,7 @@ signals:
                                             int          iPingTime,
                                             int          iNumClients );
     void Disconnected();
+    void AudioInputFinished();
 
 // #### COMPATIBILITY OLD VERSION, TO BE REMOVED ####
 void UpstreamRateChanged();
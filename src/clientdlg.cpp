@@ -911,8 +911,14 @@ void CClientDlg::OnTimerPing()
 
 void CClientDlg::OnPingTimeResult ( int iPingTime )
 {
-    // calculate overall delay
-    const int iOverallDelayMs = pClient->EstimatedOverallDelay ( iPingTime );
+    // use the measured overall delay if a valid measurement result is
+    // available, otherwise estimate the overall delay
+    int iOverallDelayMs = pClient->MeasuredOverallDelay();
+
+    if ( iOverallDelayMs < 0 )
+    {
+        iOverallDelayMs = pClient->EstimatedOverallDelay ( iPingTime );
+    }
 
     // color definition: <= 40 ms green, <= 65 ms yellow, otherwise red
     int iOverallDelayLEDColor;
@@ -150,7 +150,8 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
         "current upload rate and the overall delay. The lower the buffer size, "
         "the higher the probability of red light in the status indicator (drop "
         "outs) and the higher the upload rate and the lower the overall "
-        "delay.<br>"
+        "delay. Since the audio is processed decoupled from the sound card, "
+        "the overall delay contains one additional buffer of this size.<br>"
         "The buffer setting is therefore a trade-off between audio "
         "quality and overall delay." );
 
@@ -216,6 +217,30 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
 
     chbUseStereo->setAccessibleName ( tr ( "Stereo check box" ) );
 
+    // forward error correction
+    chbAudioFec->setWhatsThis ( tr ( "<b>Error Correction:</b> If enabled, "
+        "each network packet additionally carries a low quality copy of the "
+        "previous audio frame. A single lost packet is then replaced by this "
+        "copy instead of being concealed. This increases the stream data rate "
+        "and is only used if the server supports it and the audio quality "
+        "uses the OPUS codec." ) );
+
+    chbAudioFec->setAccessibleName ( tr ( "Error correction check box" ) );
+
+    // local monitoring
+    QString strLocalMonitor = tr ( "<b>Local Monitoring:</b> If enabled, "
+        "your own signal (including the reverberation effect and the pan "
+        "setting) is mixed directly into your output with the level set by "
+        "the slider, i.e., you hear yourself without the delay of the "
+        "network round trip. The server then removes your own signal from "
+        "the mix it sends back to you. This requires a server which "
+        "supports it, otherwise the setting has no effect." );
+
+    chbLocalMonitor->setWhatsThis ( strLocalMonitor );
+    chbLocalMonitor->setAccessibleName ( tr ( "Local monitoring check box" ) );
+    sldLocalMonitorLevel->setWhatsThis ( strLocalMonitor );
+    sldLocalMonitorLevel->setAccessibleName ( tr ( "Local monitoring level slider control" ) );
+
     // central server address
     QString strCentrServAddr = tr ( "<b>Central Server Address:</b> The "
         "central server address is the IP address or URL of the central server "
@@ -242,7 +267,8 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
         "the server is too large or your internet connection is not "
         "sufficient.<br>"
         "The overall delay is calculated from the current ping time and the "
-        "delay which is introduced by the current buffer settings.<br>"
+        "delay which is introduced by the current buffer settings (including "
+        "one sound card buffer for the audio processing).<br>"
         "The upstream rate depends on the current audio packet size and the "
         "audio compression setting. Make sure that the upstream rate is not "
         "higher than the available rate (check the upstream capabilities of "
@@ -259,6 +285,32 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
         "you will not have much fun using the " ) + APP_NAME +
         tr ( " software." ) + TOOLTIP_COM_END_TEXT );
 
+    // delay measurement
+    chbMeasureDelay->setWhatsThis ( tr ( "<b>Measure Overall Delay:</b> If "
+        "enabled, the overall delay is measured by a protocol message which "
+        "goes the same way as the audio data. The server returns the message "
+        "together with the current fill of its jitter buffer so that the "
+        "actual network round trip time and the actual waiting times in the "
+        "jitter buffers are used instead of the assumed ones. The audio "
+        "signal is not changed. If no valid measurement result is available "
+        "(e.g. for old servers), the estimated overall delay is shown." ) );
+
+    chbMeasureDelay->setAccessibleName ( tr ( "Measure overall delay check box" ) );
+
+    // audio processing load
+    const QString strAudioLoad = tr ( "<b>Audio Processing Load:</b> The "
+        "time which is needed for processing the audio (coding, effects and "
+        "buffer conversion) in percent of the available time per audio block "
+        "(average and peak value of the last second). The overruns are the "
+        "number of sound card blocks which could not be processed in time "
+        "since the connection was started, each overrun is an audible "
+        "dropout. If the load is high or if overruns occur at a low network "
+        "jitter, your computer is not fast enough for the current settings "
+        "(e.g., try a larger buffer delay or disable the stereo mode)." );
+
+    lblAudioLoad->setWhatsThis      ( strAudioLoad );
+    lblAudioLoadValue->setWhatsThis ( strAudioLoad );
+
 
     // init driver button
 #ifdef _WIN32
@@ -274,6 +326,7 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
     lblPingTimeValue->setText     ( "---" );
     lblOverallDelayValue->setText ( "---" );
     lblUpstreamValue->setText     ( "---" );
+    lblAudioLoadValue->setText    ( "---" );
 
 
     // init slider controls ---
@@ -313,6 +366,16 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
         chbGUIDesignFancy->setCheckState ( Qt::Checked );
     }
 
+    // delay measurement check box
+    if ( pClient->GetDelayMeasurement() )
+    {
+        chbMeasureDelay->setCheckState ( Qt::Checked );
+    }
+    else
+    {
+        chbMeasureDelay->setCheckState ( Qt::Unchecked );
+    }
+
     // "Audio Quality" combo box
     cbxAudioQuality->clear();
     cbxAudioQuality->addItem ( "Low" );    // AQ_LOW
@@ -330,6 +393,28 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
         chbUseStereo->setCheckState ( Qt::Unchecked );
     }
 
+    // "Error Correction" check box
+    if ( pClient->GetUseAudioFec() )
+    {
+        chbAudioFec->setCheckState ( Qt::Checked );
+    }
+    else
+    {
+        chbAudioFec->setCheckState ( Qt::Unchecked );
+    }
+
+    // "Local Monitoring" check box and level slider
+    if ( pClient->GetLocalMonitoring() )
+    {
+        chbLocalMonitor->setCheckState ( Qt::Checked );
+    }
+    else
+    {
+        chbLocalMonitor->setCheckState ( Qt::Unchecked );
+    }
+    sldLocalMonitorLevel->setRange ( 0, AUD_LOCAL_MONITOR_MAX );
+    sldLocalMonitorLevel->setValue ( pClient->GetLocalMonitorLevel() );
+
     // update default central server address check box
     if ( pClient->GetUseDefaultCentralServerAddress() )
     {
@@ -372,6 +457,9 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
     QObject::connect ( sldNetBufServer, SIGNAL ( valueChanged ( int ) ),
         this, SLOT ( OnNetBufServerValueChanged ( int ) ) );
 
+    QObject::connect ( sldLocalMonitorLevel, SIGNAL ( valueChanged ( int ) ),
+        this, SLOT ( OnLocalMonitorLevelValueChanged ( int ) ) );
+
     // check boxes
     QObject::connect ( chbOpenChatOnNewMessage, SIGNAL ( stateChanged ( int ) ),
         this, SLOT ( OnOpenChatOnNewMessageStateChanged ( int ) ) );
@@ -382,12 +470,21 @@ CClientSettingsDlg::CClientSettingsDlg ( CClient* pNCliP, QWidget* parent,
     QObject::connect ( chbUseStereo, SIGNAL ( stateChanged ( int ) ),
         this, SLOT ( OnUseStereoStateChanged ( int ) ) );
 
+    QObject::connect ( chbAudioFec, SIGNAL ( stateChanged ( int ) ),
+        this, SLOT ( OnAudioFecStateChanged ( int ) ) );
+
+    QObject::connect ( chbLocalMonitor, SIGNAL ( stateChanged ( int ) ),
+        this, SLOT ( OnLocalMonitorStateChanged ( int ) ) );
+
     QObject::connect ( chbAutoJitBuf, SIGNAL ( stateChanged ( int ) ),
         this, SLOT ( OnAutoJitBufStateChanged ( int ) ) );
 
     QObject::connect ( chbDefaultCentralServer, SIGNAL ( stateChanged ( int ) ),
         this, SLOT ( OnDefaultCentralServerStateChanged ( int ) ) );
 
+    QObject::connect ( chbMeasureDelay, SIGNAL ( stateChanged ( int ) ),
+        this, SLOT ( OnMeasureDelayStateChanged ( int ) ) );
+
     // line edits
     QObject::connect ( edtCentralServerAddress, SIGNAL ( editingFinished() ),
         this, SLOT ( OnCentralServerAddressEditingFinished() ) );
@@ -484,15 +581,19 @@ void CClientSettingsDlg::UpdateSoundCardFrame()
 
     SndCrdBufferDelayButtonGroup.setExclusive ( true );
 
-    // disable radio buttons which are not supported by audio interface
+    // disable radio buttons which are not supported by audio interface (if
+    // the capabilities are cached, they might be outdated, in this case the
+    // selection of an unsupported buffer size probes the capabilities again)
+    const bool bSndCrdCapsCached = pClient->GetSndCrdCapsCached();
+
     rbtBufferDelayPreferred->setEnabled (
-        pClient->GetFraSiFactPrefSupported() );
+        pClient->GetFraSiFactPrefSupported() || bSndCrdCapsCached );
 
     rbtBufferDelayDefault->setEnabled (
-        pClient->GetFraSiFactDefSupported() );
+        pClient->GetFraSiFactDefSupported() || bSndCrdCapsCached );
 
     rbtBufferDelaySafe->setEnabled (
-        pClient->GetFraSiFactSafeSupported() );
+        pClient->GetFraSiFactSafeSupported() || bSndCrdCapsCached );
 }
 
 void CClientSettingsDlg::UpdateSoundChannelSelectionFrame()
@@ -669,6 +770,27 @@ void CClientSettingsDlg::OnUseStereoStateChanged ( int value )
     UpdateDisplay(); // upload rate will be changed
 }
 
+void CClientSettingsDlg::OnAudioFecStateChanged ( int value )
+{
+    pClient->SetUseAudioFec ( value == Qt::Checked );
+    UpdateDisplay(); // upload rate will be changed
+}
+
+void CClientSettingsDlg::OnLocalMonitorStateChanged ( int value )
+{
+    pClient->SetLocalMonitoring ( value == Qt::Checked );
+}
+
+void CClientSettingsDlg::OnLocalMonitorLevelValueChanged ( int value )
+{
+    pClient->SetLocalMonitorLevel ( value );
+}
+
+void CClientSettingsDlg::OnMeasureDelayStateChanged ( int value )
+{
+    pClient->SetDelayMeasurement ( value == Qt::Checked );
+}
+
 void CClientSettingsDlg::OnDefaultCentralServerStateChanged ( int value )
 {
     // apply new setting to the client
@@ -742,12 +864,27 @@ void CClientSettingsDlg::UpdateDisplay()
         lblPingTimeValue->setText     ( "---" );
         lblOverallDelayValue->setText ( "---" );
         lblUpstreamValue->setText     ( "---" );
+        lblAudioLoadValue->setText    ( "---" );
     }
     else
     {
         // update upstream rate information label (only if client is running)
         lblUpstreamValue->setText (
             QString().setNum ( pClient->GetUploadRateKbps() ) + " kbps" );
+
+        // update audio processing load label
+        int iAverageLoad;
+        int iPeakLoad;
+
+        pClient->GetAndResetAudioLoad ( iAverageLoad, iPeakLoad );
+
+        if ( iAverageLoad >= 0 )
+        {
+            lblAudioLoadValue->setText ( QString().setNum ( iAverageLoad ) +
+                " % (peak " + QString().setNum ( iPeakLoad ) + " %), " +
+                QString().setNum ( pClient->GetNumAudioOverruns() ) +
+                " overruns" );
+        }
     }
 }
 
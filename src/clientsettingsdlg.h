@@ -85,7 +85,11 @@ protected:
     void OnOpenChatOnNewMessageStateChanged ( int value );
     void OnGUIDesignFancyStateChanged ( int value );
     void OnUseStereoStateChanged ( int value );
+    void OnAudioFecStateChanged ( int value );
+    void OnLocalMonitorStateChanged ( int value );
+    void OnLocalMonitorLevelValueChanged ( int value );
     void OnDefaultCentralServerStateChanged ( int value );
+    void OnMeasureDelayStateChanged ( int value );
     void OnCentralServerAddressEditingFinished();
     void OnSndCrdBufferDelayButtonGroupClicked ( QAbstractButton* button );
     void OnSoundcardActivated ( int iSndDevIdx );
@@ -65,21 +65,6 @@ LED bar:      lbr
 
 
 /* Definitions ****************************************************************/
-// The receive socket should be put in a high priority thread to ensure the GUI
-// does not effect the stability of the audio stream (e.g. if the GUI is on
-// high load because of a table update, the incoming network packets must still
-// be put in the jitter buffer with highest priority).
-// Since the new code is still in "experimental state", we introduced this macro
-// to enable/disable the new code.
-//
-// I disabled the new code again since it seems not to improve the situation
-// much. Maybe things must be tweaked for it to work correctly. Since the more
-// threads we have the higher is the risk of software crashes, I will only
-// enable the new code on significant performance gain.
-//
-//#define ENABLE_RECEIVE_SOCKET_IN_SEPARATE_THREAD
-#undef ENABLE_RECEIVE_SOCKET_IN_SEPARATE_THREAD
-
 // define this macro to get debug output
 //#define _DEBUG_
 #undef _DEBUG_
@@ -180,6 +165,8 @@ LED bar:      lbr
 // if you want to change this paramter, there has to be done code modifications
 // on other places, too! The code tag "MAX_NUM_CHANNELS_TAG" shows these places
 // (just search for the tag in the entire code)
+// note that the per tick channel state keeps one bit per channel in an int
+// (see CChannelHotState), therefore the value must not exceed 31
 #define MAX_NUM_CHANNELS                20 // max number channels for server
 
 // actual number of used channels in the server
@@ -188,7 +175,11 @@ LED bar:      lbr
 #define DEFAULT_USED_NUM_CHANNELS       7 // default used number channels for server
 
 // maximum number of servers registered in the server list
-#define MAX_NUM_SERVERS_IN_SERVER_LIST  100
+#define MAX_NUM_SERVERS_IN_SERVER_LIST  1000
+
+// maximum number of servers which are sent to old clients which do not support
+// the server list in parts (the list must fit in one network packet)
+#define MAX_NUM_SERVERS_IN_LEGACY_SERVER_LIST 100
 
 // defines the time interval at which the ping time is updated in the GUI
 #define PING_UPDATE_TIME_MS             500 // ms
@@ -210,6 +201,12 @@ LED bar:      lbr
 // time until a slave server registers in the server list
 #define SERVLIST_REGIST_INTERV_MINUTES  15 // minutes
 
+// minimum time between two NAT hole punchings of the listed servers for the
+// same requesting address and maximum number of requesting addresses for which
+// the hole punching is done within this time (the request can be spoofed)
+#define SERVLIST_PUNCH_INTERVAL_MS      10000 // ms
+#define SERVLIST_MAX_NUM_PUNCH_ADDR     100
+
 
 // length of the moving average buffer for response time measurement
 #define TIME_MOV_AV_RESPONSE_SECONDS    30 // seconds
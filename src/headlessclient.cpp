@@ -0,0 +1,134 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2013
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+\******************************************************************************/
+
+
+#include "headlessclient.h"
+
+
+/* Implementation *************************************************************/
+CHeadlessClient::CHeadlessClient ( CClient*       pNCliP,
+                                   const QString& strServerAddress,
+                                   const bool     bMeasureDelay ) :
+    pClient ( pNCliP ),
+    tsConsole ( stdout ),
+    iCurPingTime ( -1 )
+{
+    // connections -------------------------------------------------------------
+    QObject::connect ( &TimerPing, SIGNAL ( timeout() ),
+        this, SLOT ( OnTimerPing() ) );
+
+    QObject::connect ( &TimerStat, SIGNAL ( timeout() ),
+        this, SLOT ( OnTimerStat() ) );
+
+    QObject::connect ( pClient, SIGNAL ( PingTimeReceived ( int ) ),
+        this, SLOT ( OnPingTimeResult ( int ) ) );
+
+    QObject::connect ( pClient, SIGNAL ( Disconnected() ),
+        this, SLOT ( OnDisconnected() ) );
+
+    QObject::connect ( pClient, SIGNAL ( AudioInputFinished() ),
+        this, SLOT ( OnAudioInputFinished() ) );
+
+
+    // connect to the server ---------------------------------------------------
+    if ( !pClient->SetServerAddr ( strServerAddress ) )
+    {
+        throw CGenErr ( "The server address " + strServerAddress +
+            " is invalid.", "Network Error" );
+    }
+
+    // the overall delay is only measured on request (otherwise it is
+    // estimated), the setting of the settings file is not used
+    pClient->SetDelayMeasurement ( bMeasureDelay );
+
+    pClient->Start();
+
+    tsConsole << "- connecting to " << strServerAddress << endl;
+
+    ElapsedTime.start();
+    TimerPing.start ( PING_UPDATE_TIME_MS );
+    TimerStat.start ( HEADLESS_STAT_UPDATE_TIME_MS );
+}
+
+void CHeadlessClient::OnTimerStat()
+{
+    // one line per update: time, ping time, overall delay, jitter buffer
+    // sizes of client and server, RMS jitter of the packet inter-arrival
+    // time, number of lost packets since the last update and
+    // audio processing load (average/peak) with the number of overruns
+    const int iTimeS = static_cast<int> ( ElapsedTime.elapsed() / 1000 );
+
+    if ( !pClient->IsConnected() )
+    {
+        tsConsole << iTimeS << " s: not connected" << endl;
+        return;
+    }
+
+    const int iNumLostPackets = pClient->GetAndResetNumLostPackets();
+    int       iOverallDelayMs = pClient->MeasuredOverallDelay();
+    QString   strDelayType    = "measured";
+    int       iAverageLoad;
+    int       iPeakLoad;
+
+    pClient->GetAndResetAudioLoad ( iAverageLoad, iPeakLoad );
+
+    if ( ( iOverallDelayMs < 0 ) && ( iCurPingTime >= 0 ) )
+    {
+        strDelayType    = "estimated";
+        iOverallDelayMs = pClient->EstimatedOverallDelay ( iCurPingTime );
+    }
+
+    tsConsole << iTimeS << " s: ping " << iCurPingTime << " ms, delay " <<
+        iOverallDelayMs << " ms (" << strDelayType << "), jitter buffer " <<
+        pClient->GetSockBufNumFrames() << "/" <<
+        pClient->GetServerSockBufNumFrames() << ", arrival jitter " <<
+        QString().setNum ( pClient->GetArrivalTimeRmsJitterMs(), 'f', 2 ) <<
+        " ms, lost packets " << iNumLostPackets << ", audio load " <<
+        iAverageLoad << "/" << iPeakLoad << " %, overruns " <<
+        pClient->GetNumAudioOverruns() << endl;
+}
+
+void CHeadlessClient::OnDisconnected()
+{
+    tsConsole << "- disconnected" << endl;
+}
+
+void CHeadlessClient::OnAudioInputFinished()
+{
+    tsConsole << "- end of audio input" << endl;
+
+    // give the delayed audio some time to come back from the server
+    QTimer::singleShot ( HEADLESS_QUIT_DELAY_MS, this, SLOT ( OnQuit() ) );
+}
+
+void CHeadlessClient::OnQuit()
+{
+    TimerPing.stop();
+    TimerStat.stop();
+
+    // stopping the client finalizes the audio output file
+    pClient->Stop();
+
+    QCoreApplication::quit();
+}
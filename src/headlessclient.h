@@ -0,0 +1,77 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2013
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+\******************************************************************************/
+
+
+#if !defined ( HEADLESSCLIENT_HOIHGE76GEKJH98_3_4344_BB23945IUHF1912__INCLUDED_ )
+#define HEADLESSCLIENT_HOIHGE76GEKJH98_3_4344_BB23945IUHF1912__INCLUDED_
+
+#include <QObject>
+#include <QCoreApplication>
+#include <QTimer>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include "global.h"
+#include "client.h"
+
+
+/* Definitions ****************************************************************/
+// update time of the statistic output
+#define HEADLESS_STAT_UPDATE_TIME_MS    1000 // ms
+
+// time after the end of the audio input file until the client quits so that
+// the delayed audio which comes back from the server is recorded, too
+#define HEADLESS_QUIT_DELAY_MS          2000 // ms
+
+
+/* Classes ********************************************************************/
+// Client without GUI: connects to the given server on startup and writes the
+// jitter buffer and latency statistic to the console. If an audio input file
+// is used, the client quits after the end of the file.
+class CHeadlessClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    CHeadlessClient ( CClient*       pNCliP,
+                      const QString& strServerAddress,
+                      const bool     bMeasureDelay );
+
+protected:
+    CClient*      pClient;
+    QTextStream   tsConsole;
+    QTimer        TimerPing;
+    QTimer        TimerStat;
+    QElapsedTimer ElapsedTime;
+    int           iCurPingTime;
+
+public slots:
+    void OnTimerPing() { pClient->CreateCLPingMes(); }
+    void OnTimerStat();
+    void OnPingTimeResult ( int iPingTime ) { iCurPingTime = iPingTime; }
+    void OnDisconnected();
+    void OnAudioInputFinished();
+    void OnQuit();
+};
+
+#endif /* !defined ( HEADLESSCLIENT_HOIHGE76GEKJH98_3_4344_BB23945IUHF1912__INCLUDED_ ) */
@@ -0,0 +1,480 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2013
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+\******************************************************************************/
+
+
+#include "loadgenerator.h"
+
+
+/* Implementation *************************************************************/
+// Statistic of a virtual client -----------------------------------------------
+void CLoadGenStat::Reset()
+{
+    iNumFrames          = 0;
+    iNumLostFrames      = 0;
+    iNumPings           = 0;
+    iPingTimeSumMs      = 0;
+    iPingTimeMaxMs      = 0;
+    iNumBufSamples      = 0;
+    iSockBufSum         = 0;
+    iSockBufMax         = 0;
+    iServerSockBufSum   = 0;
+    iServerSockBufMax   = 0;
+    dArrivalJitterSumMs = 0;
+}
+
+void CLoadGenStat::Add ( const CLoadGenStat& Stat )
+{
+    iNumFrames          += Stat.iNumFrames;
+    iNumLostFrames      += Stat.iNumLostFrames;
+    iNumPings           += Stat.iNumPings;
+    iPingTimeSumMs      += Stat.iPingTimeSumMs;
+    iPingTimeMaxMs       = std::max ( iPingTimeMaxMs, Stat.iPingTimeMaxMs );
+    iNumBufSamples      += Stat.iNumBufSamples;
+    iSockBufSum         += Stat.iSockBufSum;
+    iSockBufMax          = std::max ( iSockBufMax, Stat.iSockBufMax );
+    iServerSockBufSum   += Stat.iServerSockBufSum;
+    iServerSockBufMax    = std::max ( iServerSockBufMax, Stat.iServerSockBufMax );
+    dArrivalJitterSumMs += Stat.dArrivalJitterSumMs;
+}
+
+QString CLoadGenStat::ToString() const
+{
+    // average and maximum values of the ping time and jitter buffer sizes,
+    // loss rate of the audio frames taken out of the jitter buffer and
+    // average RMS jitter of the packet inter-arrival time
+    QString strPing    = "-";
+    QString strLoss    = "-";
+    QString strSockBuf = "-";
+    QString strJitter  = "-";
+
+    if ( iNumPings > 0 )
+    {
+        strPing = QString().setNum ( static_cast<double> ( iPingTimeSumMs ) /
+            iNumPings, 'f', 1 ) + "/" + QString().setNum ( iPingTimeMaxMs );
+    }
+
+    if ( iNumFrames > 0 )
+    {
+        strLoss = QString().setNum ( 100.0 * iNumLostFrames / iNumFrames, 'f', 2 );
+    }
+
+    if ( iNumBufSamples > 0 )
+    {
+        strSockBuf = QString().setNum ( static_cast<double> ( iSockBufSum ) /
+            iNumBufSamples, 'f', 1 ) + "/" + QString().setNum ( iSockBufMax ) +
+            ", server " + QString().setNum ( static_cast<double> (
+            iServerSockBufSum ) / iNumBufSamples, 'f', 1 ) + "/" +
+            QString().setNum ( iServerSockBufMax );
+
+        strJitter = QString().setNum ( dArrivalJitterSumMs / iNumBufSamples,
+            'f', 2 );
+    }
+
+    return "ping " + strPing + " ms, lost " + strLoss + " %, jitter buffer " +
+        strSockBuf + ", arrival jitter " + strJitter + " ms";
+}
+
+
+// Virtual client ---------------------------------------------------------------
+CVirtualClient::CVirtualClient ( const int             iNClientID,
+                                 const CHostAddress&   NServerAddr,
+                                 CChannelTimeOutWheel* pTimeOutWheel,
+                                 CPreciseTime*         pNPreciseTime ) :
+    iClientID               ( iNClientID ),
+    ServerAddr              ( NServerAddr ),
+    ChannelInfo             (),
+    Channel                 ( false ), /* we need a client channel -> "false" */
+    Socket                  ( &Channel, 0 ), /* the system chooses the port */
+    pPreciseTime            ( pNPreciseTime ),
+    iServerSockBufNumFrames ( DEF_NET_BUF_SIZE_NUM_BL ),
+    bServerFull             ( false )
+{
+    // the name makes the virtual clients distinguishable on the server
+    ChannelInfo.strName = QString ( "Virtual %1" ).arg ( iClientID + 1 );
+
+    Channel.SetTimeOutWheel ( pTimeOutWheel );
+
+
+    // Connections -------------------------------------------------------------
+    // same connections for the protocol mechanism as in the normal client
+    QObject::connect ( &Channel,
+        SIGNAL ( MessReadyForSending ( CVector<uint8_t> ) ),
+        this, SLOT ( OnSendProtMessage ( CVector<uint8_t> ) ) );
+
+    QObject::connect ( &Channel,
+        SIGNAL ( DetectedCLMessage ( CVector<uint8_t>, int ) ),
+        this, SLOT ( OnDetectedCLMessage ( CVector<uint8_t>, int ) ) );
+
+    QObject::connect ( &Channel, SIGNAL ( ReqJittBufSize() ),
+        this, SLOT ( OnReqJittBufSize() ) );
+
+    QObject::connect ( &Channel, SIGNAL ( JittBufSizeChanged ( int ) ),
+        this, SLOT ( OnJittBufSizeChanged ( int ) ) );
+
+    QObject::connect ( &Channel, SIGNAL ( ReqChanInfo() ),
+        this, SLOT ( OnReqChanInfo() ) );
+
+    QObject::connect ( &Channel, SIGNAL ( NewConnection() ),
+        this, SLOT ( OnNewConnection() ) );
+
+    QObject::connect ( &ConnLessProtocol,
+        SIGNAL ( CLMessReadyForSending ( CHostAddress, CVector<uint8_t> ) ),
+        this, SLOT ( OnSendCLProtMessage ( CHostAddress, CVector<uint8_t> ) ) );
+
+    QObject::connect ( &ConnLessProtocol,
+        SIGNAL ( CLPingReceived ( CHostAddress, int ) ),
+        this, SLOT ( OnCLPingReceived ( CHostAddress, int ) ) );
+
+    QObject::connect ( &ConnLessProtocol, SIGNAL ( ServerFullMesReceived() ),
+        this, SLOT ( OnServerFull() ) );
+
+
+    // Connect to the server ---------------------------------------------------
+    // mono OPUS stream with the preferred frame size, the server is informed
+    // about the stream properties with the protocol
+    Channel.SetAudioStreamProperties ( CT_OPUS,
+                                       LOAD_GEN_NUM_CODED_BYTES,
+                                       FRAME_SIZE_FACTOR_PREFERRED,
+                                       1,
+                                       0 );
+
+    vecbyNetwData.Init ( Channel.GetNetwFrameSize() );
+
+    // both, the client and the server use an auto jitter buffer
+    Channel.SetDoAutoSockBufSize ( true );
+
+    Channel.SetAddress ( ServerAddr );
+    Channel.SetEnable ( true );
+}
+
+void CVirtualClient::ProcessFrame ( const uint8_t* pbyCodedFrame )
+{
+    // the pre-encoded frame is directly written in the send buffer of the
+    // channel, the audio is sent even if we are not yet connected since the
+    // server only creates a channel for us on received audio packets
+    uint8_t* pbyCodedData = Channel.GetSendBufPointer ( LOAD_GEN_NUM_CODED_BYTES );
+
+    if ( pbyCodedData != NULL )
+    {
+        memcpy ( pbyCodedData, pbyCodedFrame, LOAD_GEN_NUM_CODED_BYTES );
+
+        if ( Channel.PrepSendPacket ( LOAD_GEN_NUM_CODED_BYTES ) )
+        {
+            Socket.SendPacket ( Channel.GetSendPacket(), ServerAddr );
+        }
+    }
+
+    // take one frame out of the jitter buffer (it is not decoded), a missing
+    // frame is counted as a lost frame
+    if ( Channel.IsConnected() )
+    {
+        int iNumCodedBytes;
+        int iNumFecBytes;
+
+        CurStat.iNumFrames++;
+
+        if ( Channel.GetData ( vecbyNetwData, iNumCodedBytes, iNumFecBytes ) != GS_BUFFER_OK )
+        {
+            CurStat.iNumLostFrames++;
+        }
+
+        Channel.UpdateSocketBufferSize();
+    }
+}
+
+CLoadGenStat CVirtualClient::GetAndResetStat()
+{
+    // the jitter buffer sizes are sampled once per statistic interval
+    if ( Channel.IsConnected() )
+    {
+        const int iSockBufNumFrames = Channel.GetSockBufNumFrames();
+
+        CurStat.iNumBufSamples      = 1;
+        CurStat.iSockBufSum         = iSockBufNumFrames;
+        CurStat.iSockBufMax         = iSockBufNumFrames;
+        CurStat.iServerSockBufSum   = iServerSockBufNumFrames;
+        CurStat.iServerSockBufMax   = iServerSockBufNumFrames;
+        CurStat.dArrivalJitterSumMs = Channel.GetArrivalTimeRmsJitterMs();
+    }
+
+    TotalStat.Add ( CurStat );
+
+    const CLoadGenStat Stat = CurStat;
+    CurStat.Reset();
+
+    return Stat;
+}
+
+void CVirtualClient::Disconnect()
+{
+    Channel.SetEnable ( false );
+
+    // the server shall not wait for the channel time-out
+    ConnLessProtocol.CreateCLDisconnection ( ServerAddr );
+}
+
+void CVirtualClient::OnNewConnection()
+{
+    // same handshake as in the normal client: send infos, request the
+    // connected clients list and tell the server to use an auto jitter buffer
+    Channel.SetRemoteInfo ( ChannelInfo );
+    Channel.CreateReqConnClientsList();
+    Channel.CreateJitBufMes ( AUTO_NET_BUF_SIZE_FOR_PROTOCOL );
+
+    // a server which was full might accept us now
+    bServerFull = false;
+}
+
+void CVirtualClient::OnCLPingReceived ( CHostAddress InetAddr,
+                                        int          iMs )
+{
+    if ( InetAddr == ServerAddr )
+    {
+        // take care of wrap arounds (if wrapping, do not use result)
+        const int iCurDiff = pPreciseTime->elapsed() - iMs;
+
+        if ( iCurDiff >= 0 )
+        {
+            CurStat.iNumPings++;
+            CurStat.iPingTimeSumMs += iCurDiff;
+            CurStat.iPingTimeMaxMs  = std::max ( CurStat.iPingTimeMaxMs, iCurDiff );
+        }
+    }
+}
+
+
+// Load generator ---------------------------------------------------------------
+CLoadGenerator::CLoadGenerator ( const int      iNNumClients,
+                                 const QString& strServerAddress ) :
+    iNumClients ( iNNumClients ),
+    iCurFrame   ( 0 ),
+    tsConsole   ( stdout )
+{
+    if ( !NetworkUtil().ParseNetworkAddress ( strServerAddress, ServerAddr ) )
+    {
+        throw CGenErr ( "The server address " + strServerAddress +
+            " is invalid.", "Network Error" );
+    }
+
+    // the audio frames are encoded only once and are shared by all clients
+    PreEncodeFrames();
+
+
+    // Connections -------------------------------------------------------------
+    QObject::connect ( &HighPrecisionTimer, SIGNAL ( timeout() ),
+        this, SLOT ( OnTimer() ) );
+
+    QObject::connect ( &TimerStartClient, SIGNAL ( timeout() ),
+        this, SLOT ( OnTimerStartClient() ) );
+
+    QObject::connect ( &TimerPing, SIGNAL ( timeout() ),
+        this, SLOT ( OnTimerPing() ) );
+
+    QObject::connect ( &TimerStat, SIGNAL ( timeout() ),
+        this, SLOT ( OnTimerStat() ) );
+
+
+    // Start the load test -----------------------------------------------------
+    tsConsole << "- load test with " << iNumClients << " virtual clients on " <<
+        strServerAddress << endl;
+
+    ElapsedTime.start();
+    HighPrecisionTimer.Start();
+    TimerStartClient.start ( LOAD_GEN_START_INTERVAL_MS );
+    TimerPing.start ( PING_UPDATE_TIME_MS );
+    TimerStat.start ( LOAD_GEN_STAT_UPDATE_TIME_MS );
+
+    // the first virtual client is started immediately
+    OnTimerStartClient();
+}
+
+CLoadGenerator::~CLoadGenerator()
+{
+    HighPrecisionTimer.Stop();
+
+    for ( int i = 0; i < vecpVirtualClients.Size(); i++ )
+    {
+        delete vecpVirtualClients[i];
+    }
+}
+
+void CLoadGenerator::PreEncodeFrames()
+{
+    int iOpusError;
+
+    OpusCustomMode* OpusMode = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ,
+                                                         SYSTEM_FRAME_SIZE_SAMPLES,
+                                                         &iOpusError );
+
+    OpusCustomEncoder* OpusEncoderMono = opus_custom_encoder_create ( OpusMode,
+                                                                      1,
+                                                                      &iOpusError );
+
+    // same encoder settings as in the client
+    opus_custom_encoder_ctl ( OpusEncoderMono,
+                              OPUS_SET_VBR ( 0 ) );
+
+    opus_custom_encoder_ctl ( OpusEncoderMono,
+                              OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+
+    opus_custom_encoder_ctl ( OpusEncoderMono,
+                              OPUS_SET_BITRATE (
+                                  CalcBitRateBitsPerSecFromCodedBytes (
+                                      LOAD_GEN_NUM_CODED_BYTES ) ) );
+
+    // Test signal: chord with a tremolo and some noise. All frequencies are
+    // integer multiples of 1 Hz so that the one second loop has no
+    // discontinuities.
+    CVector<float> vecfAudio ( SYSTEM_FRAME_SIZE_SAMPLES );
+    const double   dTwoPi = 2.0 * 3.14159265358979;
+
+    vecbyPreEncFrames.Init ( LOAD_GEN_NUM_PRE_ENC_FRAMES * LOAD_GEN_NUM_CODED_BYTES );
+
+    for ( int iFrame = 0; iFrame < LOAD_GEN_NUM_PRE_ENC_FRAMES; iFrame++ )
+    {
+        for ( int i = 0; i < SYSTEM_FRAME_SIZE_SAMPLES; i++ )
+        {
+            const double dTime = static_cast<double> (
+                iFrame * SYSTEM_FRAME_SIZE_SAMPLES + i ) / SYSTEM_SAMPLE_RATE_HZ;
+
+            const double dTremolo = 0.5 + 0.5 * sin ( dTwoPi * 2 * dTime );
+
+            vecfAudio[i] = static_cast<float> ( 0.1 * dTremolo *
+                ( sin ( dTwoPi * 220 * dTime ) +
+                  sin ( dTwoPi * 277 * dTime ) +
+                  sin ( dTwoPi * 330 * dTime ) ) +
+                0.01 * ( 2.0 * rand() / RAND_MAX - 1.0 ) );
+        }
+
+        opus_custom_encode_float ( OpusEncoderMono,
+                                   &vecfAudio[0],
+                                   SYSTEM_FRAME_SIZE_SAMPLES,
+                                   &vecbyPreEncFrames[iFrame * LOAD_GEN_NUM_CODED_BYTES],
+                                   LOAD_GEN_NUM_CODED_BYTES );
+    }
+
+    opus_custom_encoder_destroy ( OpusEncoderMono );
+    opus_custom_mode_destroy ( OpusMode );
+}
+
+void CLoadGenerator::OnTimer()
+{
+    // one frame per virtual client and timer tick, each client starts at a
+    // different position in the pre-encoded frames
+    for ( int i = 0; i < vecpVirtualClients.Size(); i++ )
+    {
+        const int iFrame = ( iCurFrame + i * LOAD_GEN_FRAME_OFFSET ) %
+            LOAD_GEN_NUM_PRE_ENC_FRAMES;
+
+        vecpVirtualClients[i]->ProcessFrame (
+            &vecbyPreEncFrames[iFrame * LOAD_GEN_NUM_CODED_BYTES] );
+    }
+
+    iCurFrame = ( iCurFrame + 1 ) % LOAD_GEN_NUM_PRE_ENC_FRAMES;
+}
+
+void CLoadGenerator::OnTimerStartClient()
+{
+    if ( vecpVirtualClients.Size() < iNumClients )
+    {
+        vecpVirtualClients.Add ( new CVirtualClient ( vecpVirtualClients.Size(),
+                                                      ServerAddr,
+                                                      &TimeOutWheel,
+                                                      &PreciseTime ) );
+    }
+
+    if ( vecpVirtualClients.Size() >= iNumClients )
+    {
+        // all clients are started, keep the full load for some time
+        TimerStartClient.stop();
+        QTimer::singleShot ( LOAD_GEN_HOLD_TIME_MS, this, SLOT ( OnQuit() ) );
+    }
+}
+
+void CLoadGenerator::OnTimerPing()
+{
+    for ( int i = 0; i < vecpVirtualClients.Size(); i++ )
+    {
+        if ( vecpVirtualClients[i]->IsConnected() )
+        {
+            vecpVirtualClients[i]->SendPing();
+        }
+    }
+}
+
+void CLoadGenerator::OnTimerStat()
+{
+    // one line per update with the statistic of all virtual clients since the
+    // last update, the number of clients is increased during the test so that
+    // the output directly gives the capacity curve of the server
+    const int    iTimeS         = static_cast<int> ( ElapsedTime.elapsed() / 1000 );
+    int          iNumConnected  = 0;
+    int          iNumServerFull = 0;
+    CLoadGenStat Stat;
+
+    for ( int i = 0; i < vecpVirtualClients.Size(); i++ )
+    {
+        if ( vecpVirtualClients[i]->IsConnected() )
+        {
+            iNumConnected++;
+        }
+        else if ( vecpVirtualClients[i]->IsServerFull() )
+        {
+            iNumServerFull++;
+        }
+
+        Stat.Add ( vecpVirtualClients[i]->GetAndResetStat() );
+    }
+
+    tsConsole << iTimeS << " s: " << vecpVirtualClients.Size() << " clients, " <<
+        iNumConnected << " connected, " << iNumServerFull << " rejected, " <<
+        Stat.ToString() << endl;
+}
+
+void CLoadGenerator::PrintClientSummary()
+{
+    tsConsole << "- statistic per virtual client:" << endl;
+
+    for ( int i = 0; i < vecpVirtualClients.Size(); i++ )
+    {
+        tsConsole << "client " << vecpVirtualClients[i]->GetClientID() + 1 <<
+            ": " << vecpVirtualClients[i]->GetTotalStat().ToString() << endl;
+    }
+}
+
+void CLoadGenerator::OnQuit()
+{
+    HighPrecisionTimer.Stop();
+    TimerPing.stop();
+    TimerStat.stop();
+
+    PrintClientSummary();
+
+    for ( int i = 0; i < vecpVirtualClients.Size(); i++ )
+    {
+        vecpVirtualClients[i]->Disconnect();
+    }
+
+    QCoreApplication::quit();
+}
@@ -0,0 +1,204 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2013
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+\******************************************************************************/
+
+
+#if !defined ( LOADGENERATOR_HOIHGE76GEKJH98_3_4344_BB23945IUHF1912__INCLUDED_ )
+#define LOADGENERATOR_HOIHGE76GEKJH98_3_4344_BB23945IUHF1912__INCLUDED_
+
+#include <QObject>
+#include <QCoreApplication>
+#include <QTimer>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QString>
+#include <math.h>
+#include <algorithm>
+#include "opus_custom.h"
+#include "global.h"
+#include "socket.h"
+#include "channel.h"
+#include "protocol.h"
+#include "util.h"
+#include "client.h"
+#include "server.h"
+
+
+/* Definitions ****************************************************************/
+// maximum number of virtual clients (each client needs its own socket, i.e.,
+// we have to stay below the file descriptor limit of the process)
+#define LOAD_GEN_MAX_NUM_CLIENTS        400
+
+// the virtual clients are started one after the other with this interval so
+// that the statistic shows the behaviour of the server for each number of
+// connected clients (capacity curve)
+#define LOAD_GEN_START_INTERVAL_MS      1000 // ms
+
+// time after all virtual clients are started until the load test is finished
+#define LOAD_GEN_HOLD_TIME_MS           30000 // ms
+
+// update time of the statistic output
+#define LOAD_GEN_STAT_UPDATE_TIME_MS    1000 // ms
+
+// the virtual clients send a mono OPUS stream with normal quality
+#define LOAD_GEN_NUM_CODED_BYTES        OPUS_NUM_BYTES_MONO_NORMAL_QUALITY
+
+// number of pre-encoded frames which are sent in a loop (one second)
+#define LOAD_GEN_NUM_PRE_ENC_FRAMES     ( SYSTEM_SAMPLE_RATE_HZ / SYSTEM_FRAME_SIZE_SAMPLES )
+
+// each virtual client starts at a different position in the pre-encoded
+// frames so that the server does not mix identical signals
+#define LOAD_GEN_FRAME_OFFSET           37
+
+
+/* Classes ********************************************************************/
+// Statistic of a virtual client -----------------------------------------------
+class CLoadGenStat
+{
+public:
+    CLoadGenStat() { Reset(); }
+
+    void Reset();
+    void Add ( const CLoadGenStat& Stat );
+    QString ToString() const;
+
+    int    iNumFrames;
+    int    iNumLostFrames;
+    int    iNumPings;
+    int    iPingTimeSumMs;
+    int    iPingTimeMaxMs;
+    int    iNumBufSamples;
+    int    iSockBufSum;
+    int    iSockBufMax;
+    int    iServerSockBufSum;
+    int    iServerSockBufMax;
+    double dArrivalJitterSumMs;
+};
+
+
+// Virtual client ---------------------------------------------------------------
+// A lightweight client without sound card and codec: it uses the real channel
+// and protocol objects (i.e., it does the same connect handshake as a normal
+// client) but sends pre-encoded audio frames and does not decode the received
+// audio, only the jitter buffer is read out.
+class CVirtualClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    CVirtualClient ( const int             iNClientID,
+                     const CHostAddress&   NServerAddr,
+                     CChannelTimeOutWheel* pTimeOutWheel,
+                     CPreciseTime*         pNPreciseTime );
+
+    void ProcessFrame ( const uint8_t* pbyCodedFrame );
+    void SendPing() { ConnLessProtocol.CreateCLPingMes ( ServerAddr, pPreciseTime->elapsed() ); }
+    CLoadGenStat GetAndResetStat();
+    void Disconnect();
+
+    bool IsConnected() { return Channel.IsConnected(); }
+    bool IsServerFull() const { return bServerFull; }
+    int  GetClientID() const { return iClientID; }
+
+    const CLoadGenStat& GetTotalStat() const { return TotalStat; }
+
+protected:
+    int              iClientID;
+    CHostAddress     ServerAddr;
+    CChannelCoreInfo ChannelInfo;
+    CChannel         Channel;
+    CSocket          Socket;
+    CProtocol        ConnLessProtocol;
+    CPreciseTime*    pPreciseTime;
+    CVector<uint8_t> vecbyNetwData;
+    int              iServerSockBufNumFrames;
+    bool             bServerFull;
+
+    // statistic of the current update interval and of the entire test
+    CLoadGenStat     CurStat;
+    CLoadGenStat     TotalStat;
+
+public slots:
+    void OnSendProtMessage ( CVector<uint8_t> vecMessage )
+        { Socket.SendPacket ( vecMessage, ServerAddr ); }
+
+    void OnSendCLProtMessage ( CHostAddress     InetAddr,
+                               CVector<uint8_t> vecMessage )
+        { Socket.SendPacket ( vecMessage, InetAddr ); }
+
+    void OnDetectedCLMessage ( CVector<uint8_t> vecbyMesBodyData,
+                               int              iRecID )
+        { ConnLessProtocol.ParseConnectionLessMessageBody ( vecbyMesBodyData, iRecID, ServerAddr ); }
+
+    void OnReqJittBufSize() { Channel.CreateJitBufMes ( AUTO_NET_BUF_SIZE_FOR_PROTOCOL ); }
+    void OnJittBufSizeChanged ( int iNewJitBufSize ) { iServerSockBufNumFrames = iNewJitBufSize; }
+    void OnReqChanInfo() { Channel.SetRemoteInfo ( ChannelInfo ); }
+    void OnNewConnection();
+    void OnCLPingReceived ( CHostAddress InetAddr, int iMs );
+    void OnServerFull() { bServerFull = true; }
+};
+
+
+// Load generator ---------------------------------------------------------------
+// Connects the given number of virtual clients to a server to measure the
+// capacity of the server. All virtual clients run in one thread: the sockets
+// are served by the event loop of the application and the audio frames of all
+// clients are sent in the same timer callback.
+class CLoadGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    CLoadGenerator ( const int      iNNumClients,
+                     const QString& strServerAddress );
+
+    virtual ~CLoadGenerator();
+
+protected:
+    void PreEncodeFrames();
+    void PrintClientSummary();
+
+    int                      iNumClients;
+    CHostAddress             ServerAddr;
+    CVector<CVirtualClient*> vecpVirtualClients;
+    CVector<uint8_t>         vecbyPreEncFrames;
+    int                      iCurFrame;
+
+    CChannelTimeOutWheel     TimeOutWheel;
+    CPreciseTime             PreciseTime;
+    CHighPrecisionTimer      HighPrecisionTimer;
+    QTimer                   TimerStartClient;
+    QTimer                   TimerPing;
+    QTimer                   TimerStat;
+    QElapsedTimer            ElapsedTime;
+    QTextStream              tsConsole;
+
+public slots:
+    void OnTimer();
+    void OnTimerStartClient();
+    void OnTimerPing();
+    void OnTimerStat();
+    void OnQuit();
+};
+
+#endif /* !defined ( LOADGENERATOR_HOIHGE76GEKJH98_3_4344_BB23945IUHF1912__INCLUDED_ ) */
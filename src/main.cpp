@@ -30,6 +30,8 @@
 #include "clientdlg.h"
 #include "serverdlg.h"
 #include "settings.h"
+#include "headlessclient.h"
+#include "loadgenerator.h"
 #include "testbench.h"
 
 
@@ -39,6 +41,9 @@ QApplication* pApp        = NULL;
 QDialog*      pMainWindow = NULL;
 
 
+// if the protocol fuzzer is built, the fuzzing engine provides the main
+// function (see testbench.h)
+#ifndef PROTOCOL_FUZZER
 int main ( int argc, char** argv )
 {
 #ifdef _WIN32
@@ -61,7 +66,10 @@ int main ( int argc, char** argv )
     bool    bShowComplRegConnList     = false;
     bool    bShowAnalyzerConsole      = false;
     bool    bCentServPingServerInList = false;
+    bool    bMeasureDelay             = false;
     int     iNumServerChannels        = DEFAULT_USED_NUM_CHANNELS;
+    int     iNumServerSockets         = 1;
+    int     iNumLoadGenClients        = 0;
     quint16 iPortNumber               = LLCON_DEFAULT_PORT_NUMBER;
     QString strIniFileName            = "";
     QString strHTMLStatusFileName     = "";
@@ -71,6 +79,9 @@ int main ( int argc, char** argv )
     QString strCentralServer          = "";
     QString strServerInfo             = "";
     QString strWelcomeMessage         = "";
+    QString strServerAddress          = "";
+    QString strAudioInFileName        = "";
+    QString strAudioOutFileName       = "";
 
     // QT docu: argv()[0] is the program name, argv()[1] is the first
     // argument and argv()[argc()-1] is the last argument.
@@ -121,6 +132,25 @@ int main ( int argc, char** argv )
         }
 
 
+        // Number of server sockets --------------------------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "-t",
+                                  "--numsockets",
+                                  1,
+                                  MAX_NUM_SERVER_SOCKETS,
+                                  rDbleArgument ) )
+        {
+            iNumServerSockets = static_cast<int> ( rDbleArgument );
+
+            tsConsole << "- number of server sockets: "
+                << iNumServerSockets << endl;
+
+            continue;
+        }
+
 
         // Start minimized -----------------------------------------------------
         if ( GetFlagArgument ( argv,
@@ -334,6 +364,83 @@ int main ( int argc, char** argv )
         }
 
 
+        // Server address (headless client) ------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "-r",
+                                 "--serveraddress",
+                                 strArgument ) )
+        {
+            strServerAddress = strArgument;
+            tsConsole << "- server address: " << strServerAddress << endl;
+            continue;
+        }
+
+
+        // Load test with virtual clients --------------------------------------
+        if ( GetNumericArgument ( tsConsole,
+                                  argc,
+                                  argv,
+                                  i,
+                                  "-v",
+                                  "--loadtest",
+                                  1,
+                                  LOAD_GEN_MAX_NUM_CLIENTS,
+                                  rDbleArgument ) )
+        {
+            iNumLoadGenClients = static_cast<int> ( rDbleArgument );
+
+            tsConsole << "- load test with virtual clients: "
+                << iNumLoadGenClients << endl;
+
+            continue;
+        }
+
+
+        // Audio input file ----------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "-f",
+                                 "--audioin",
+                                 strArgument ) )
+        {
+            strAudioInFileName = strArgument;
+            tsConsole << "- audio input file: " << strAudioInFileName << endl;
+            continue;
+        }
+
+
+        // Audio output file ---------------------------------------------------
+        if ( GetStringArgument ( tsConsole,
+                                 argc,
+                                 argv,
+                                 i,
+                                 "-k",
+                                 "--audioout",
+                                 strArgument ) )
+        {
+            strAudioOutFileName = strArgument;
+            tsConsole << "- audio output file: " << strAudioOutFileName << endl;
+            continue;
+        }
+
+
+        // Measure overall delay (headless client) -----------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "-x",
+                               "--measuredelay" ) )
+        {
+            bMeasureDelay = true;
+            tsConsole << "- overall delay measurement enabled" << endl;
+            continue;
+        }
+
+
         // Help (usage) flag ---------------------------------------------------
         if ( ( !strcmp ( argv[i], "--help" ) ) ||
              ( !strcmp ( argv[i], "-h" ) ) ||
@@ -366,6 +473,18 @@ int main ( int argc, char** argv )
         strCentralServer = DEFAULT_SERVER_ADDRESS;
     }
 
+    // per definition: the load test runs without GUI and, if no server
+    // address is given, against the server on the local computer
+    if ( bIsClient && ( iNumLoadGenClients > 0 ) )
+    {
+        bUseGUI = false;
+
+        if ( strServerAddress.isEmpty() )
+        {
+            strServerAddress = "127.0.0.1";
+        }
+    }
+
 
     // Application/GUI setup ---------------------------------------------------
     // Application object
@@ -375,13 +494,16 @@ int main ( int argc, char** argv )
     // set application priority class -> high priority
     SetPriorityClass ( GetCurrentProcess(), HIGH_PRIORITY_CLASS );
 
-#ifdef ENABLE_RECEIVE_SOCKET_IN_SEPARATE_THREAD
     // Since we have a higher priority for the entire application, we can give
-    // the GUI thread the lowest possible priority which is still above the
-    // Windows "normal" priority so that it does not slow down the sound card
-    // and network working threads.
-    QThread::currentThread()->setPriority ( QThread::LowestPriority );
-#endif
+    // the GUI thread of the client the lowest possible priority which is still
+    // above the Windows "normal" priority so that it does not slow down the
+    // sound card and network working threads (the server processes the audio
+    // in its main thread, therefore we must not do this for the server and
+    // the load generator).
+    if ( bIsClient && ( iNumLoadGenClients == 0 ) )
+    {
+        QThread::currentThread()->setPriority ( QThread::LowestPriority );
+    }
 
     // For accessible support we need to add a plugin to qt. The plugin has to
     // be located in the install directory of the software by the installer.
@@ -397,36 +519,78 @@ int main ( int argc, char** argv )
 // TEST -> activate the following line to activate the test bench,
 //CTestbench Testbench ( "127.0.0.1", LLCON_DEFAULT_PORT_NUMBER );
 
+// TEST -> activate the following lines to run the offline protocol parser
+// benchmark (the application quits afterwards),
+//CProtocolParserBench ProtocolParserBench;
+//ProtocolParserBench.RunBenchmark ( tsConsole );
+//return 0;
+
 
     try
     {
-        if ( bIsClient )
+        if ( bIsClient && ( iNumLoadGenClients > 0 ) )
+        {
+            // Load generator:
+            // virtual clients for testing the capacity of a server (no sound
+            // card and no settings file are used)
+            tsConsole << CAboutDlg::GetVersionAndNameStr ( false ) << endl;
+
+            CLoadGenerator LoadGenerator ( iNumLoadGenClients,
+                                           strServerAddress );
+
+            app.exec();
+        }
+        else if ( bIsClient )
         {
             // Client:
-            // actual client object
-            CClient Client ( iPortNumber );
+            // actual client object (if audio files are given, the sound card
+            // is not used)
+            CClient Client ( iPortNumber,
+                             strAudioInFileName,
+                             strAudioOutFileName );
 
             // load settings from init-file
             CSettings Settings ( &Client, strIniFileName );
             Settings.Load();
 
-            // GUI object
-            CClientDlg ClientDlg ( &Client,
-                                   &Settings,
-                                   bConnectOnStartup,
-                                   bDisalbeLEDs,
-                                   bShowComplRegConnList,
-                                   bShowAnalyzerConsole,
-                                   0,
-                                   Qt::Window );
-
-            // set main window
-            pMainWindow = &ClientDlg;
-            pApp        = &app; // Needed for post-event routine
-
-            // show dialog
-            ClientDlg.show();
-            app.exec();
+            if ( bUseGUI )
+            {
+                // GUI object
+                CClientDlg ClientDlg ( &Client,
+                                       &Settings,
+                                       bConnectOnStartup,
+                                       bDisalbeLEDs,
+                                       bShowComplRegConnList,
+                                       bShowAnalyzerConsole,
+                                       0,
+                                       Qt::Window );
+
+                // set main window
+                pMainWindow = &ClientDlg;
+                pApp        = &app; // Needed for post-event routine
+
+                // show dialog
+                ClientDlg.show();
+                app.exec();
+            }
+            else
+            {
+                // the headless client connects to the given server or to the
+                // last server of the settings file (the settings are not
+                // saved in this mode)
+                if ( strServerAddress.isEmpty() )
+                {
+                    strServerAddress = Client.vstrIPAddress[0];
+                }
+
+                tsConsole << CAboutDlg::GetVersionAndNameStr ( false ) << endl;
+
+                CHeadlessClient HeadlessClient ( &Client,
+                                                 strServerAddress,
+                                                 bMeasureDelay );
+
+                app.exec();
+            }
         }
         else
         {
@@ -441,7 +605,8 @@ int main ( int argc, char** argv )
                              strCentralServer,
                              strServerInfo,
                              strWelcomeMessage,
-                             bCentServPingServerInList );
+                             bCentServPingServerInList,
+                             iNumServerSockets );
 
             if ( bUseGUI )
             {
@@ -509,6 +674,7 @@ int main ( int argc, char** argv )
 
     return 0;
 }
+#endif
 
 
 /******************************************************************************\
@@ -525,14 +691,19 @@ QString UsageArguments ( char **argv )
         "                        only)\n"
         "  -d, --disableleds     disable LEDs in main window (client only)\n"
         "  -e, --centralserver   address of the central server (server only)\n"
+        "  -f, --audioin         audio input WAV file (16 bit, 48 kHz) or - for\n"
+        "                        stdin instead of the sound card (client only)\n"
         "  -g, --pingservers     ping servers in list to keep NAT port open\n"
         "                        (central server only)\n"
         "  -h, -?, --help        this help text\n"
         "  -i, --inifile         initialization file name (client only)\n"
+        "  -k, --audioout        audio output WAV file instead of the sound card\n"
+        "                        (client only)\n"
         "  -l, --log             enable logging, set file name\n"
         "  -m, --htmlstatus      enable HTML status file, set file name (server\n"
         "                        only)\n"
-        "  -n, --nogui           disable GUI (server only)\n"
+        "  -n, --nogui           disable GUI (for the client, the connection\n"
+        "                        statistic is written to the console)\n"
         "  -o, --serverinfo      infos of the server(s) in the format:\n"
         "                        [name];[city];[country as QLocale ID]; ...\n"
         "                        [server1 address];[server1 name]; ...\n"
@@ -540,9 +711,20 @@ QString UsageArguments ( char **argv )
         "                        [server1 country as QLocale ID]; ...\n"
         "                        [server2 address]; ... (server only)\n"
         "  -p, --port            local port number (server only)\n"
+        "  -r, --serveraddress   server address to connect to (client without\n"
+        "                        GUI or load test only)\n"
         "  -s, --server          start server\n"
+        "  -t, --numsockets      number of sockets on the server port, each\n"
+        "                        with its own receive thread (server only,\n"
+        "                        Linux only)\n"
         "  -u, --numchannels     maximum number of channels (server only)\n"
+        "  -v, --loadtest        server load test with the given number of\n"
+        "                        virtual clients (client only, the server\n"
+        "                        address is set with -r, default is the local\n"
+        "                        computer)\n"
         "  -w, --welcomemessage  welcome message on connect (server only)\n"
+        "  -x, --measuredelay    measure the overall delay instead of\n"
+        "                        estimating it (client without GUI only)\n"
         "  -y, --history         enable connection history and set file\n"
         "                        name (server only)\n"
         "  -z, --startminimized  start minimizied (server only)\n"
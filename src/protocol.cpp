@@ -44,6 +44,17 @@ MESSAGES (with connection)
 
     note: the cnt value is the same as of the message to be acknowledged
 
+    If the other side supports the windowed transfer (see
+    PROTMESSID_PROTOCOL_FEATURES), the following data is appended:
+
+    +--------------------------+
+    | 1 byte next expected cnt |
+    +--------------------------+
+
+    - "next expected cnt": all messages with a cnt value before this value
+                           (modulo 256) are received (cumulative
+                           acknowledgement)
+
 
 - PROTMESSID_JITT_BUF_SIZE: Jitter buffer size
 
@@ -94,6 +105,28 @@ MESSAGES (with connection)
         ... ------------------+---------------------------+
 
 
+- PROTMESSID_CONN_CLIENTS_LIST_DELTA: Changes of the connected clients list
+
+    +----------------------+---------------------+------------------------+ ...
+    | 2 bytes base version | 2 bytes new version | 1 byte number removed  | ...
+    +----------------------+---------------------+------------------------+ ...
+        ... -------------------------------+ ...
+        ...  1 byte channel ID per removed | ...
+        ... -------------------------------+ ...
+
+    for each added or changed client append the data as defined in
+    PROTMESSID_CONN_CLIENTS_LIST
+
+    - "base version": list version the changes are based on, 0xFFFF if the
+                      message contains the complete list
+    - "new version":  list version after applying the changes
+
+    note: this message is only sent if the other side supports it (see
+          PROTMESSID_PROTOCOL_FEATURES), if the base version does not match
+          the own list version, the complete list is requested with
+          PROTMESSID_REQ_CONN_CLIENTS_LIST
+
+
 - PROTMESSID_REQ_CONN_CLIENTS_LIST: Request connected clients list
 
     note: does not have any data -> n = 0
@@ -158,7 +191,15 @@ MESSAGES (with connection)
     - "version":         version of the audio coder, if not used this value
                          shall be set to 0
     - "audiocod arg":    argument for the audio coder, if not used this value
-                         shall be set to 0
+                         shall be set to 0, for OPUS it is the number of bytes
+                         of the redundant frame for forward error correction
+                         (only if the other side supports
+                         PROT_FEATURE_AUDIO_FEC), in this case each base
+                         network frame is composed of:
+                          - the coded audio frame
+                          - a low bit rate coding of the previous audio frame
+                            ("audiocod arg" bytes)
+                          - 1 byte sequence number of the frame
 
 
 - PROTMESSID_REQ_NETW_TRANSPORT_PROPS: Request properties for network transport
@@ -172,6 +213,58 @@ MESSAGES (with connection)
     note: does not have any data -> n = 0
 
 
+- PROTMESSID_PROTOCOL_FEATURES: Supported protocol features
+
+    +--------------------+-----------------------+
+    | 2 bytes session ID | 4 bytes feature flags |
+    +--------------------+-----------------------+
+
+    - "session ID":    random number which changes on each protocol reset, it
+                       is used to detect that the other side was reset
+    - "feature flags": bit mask of the supported features (PROT_FEATURE_x):
+                        - bit 0: windowed transfer, i.e., several messages may
+                                 be unacknowledged at the same time and the
+                                 messages are delivered in the order of the cnt
+                                 values
+                        - bit 1: message container (see
+                                 PROTMESSID_MESS_CONTAINER)
+                        - bit 2: delta updates of the connected clients list
+                                 (see PROTMESSID_CONN_CLIENTS_LIST_DELTA)
+                        - bit 3: forward error correction of the audio
+                                 stream (see PROTMESSID_NETW_TRANSPORT_PROPS)
+                        - bit 4: the own signal of a client can be excluded
+                                 from its mix (see PROTMESSID_LOCAL_MONITORING)
+
+    note: this is the first message sent after a protocol reset, old versions
+          which do not know it simply acknowledge it
+
+
+- PROTMESSID_MESS_CONTAINER: Several complete protocol messages (including
+                             acknowledgements) in one network packet
+
+    +---------------------------+---------------------------+ ...
+    | complete message frame 1  | complete message frame 2  | ...
+    +---------------------------+---------------------------+ ...
+
+    note: the container is only sent if the other side supports it (see
+          PROTMESSID_PROTOCOL_FEATURES), it is not acknowledged and its cnt is
+          always 0, the contained messages are acknowledged as usual
+
+
+- PROTMESSID_LOCAL_MONITORING: The client monitors its own signal locally
+
+    +------------------+
+    | 1 byte enabled   |
+    +------------------+
+
+    - "enabled": 1 if the client mixes its own signal locally into its output,
+                 in this case the server excludes the own signal of the client
+                 from the personal mix of this client, 0 otherwise
+
+    note: this message is only sent to servers which support
+          PROT_FEATURE_LOCAL_MONITORING, the setting is reset on disconnection
+
+
 CONNECTION LESS MESSAGES
 ------------------------
 
@@ -246,9 +339,55 @@ CONNECTION LESS MESSAGES
       of the PROTMESSID_CLM_REGISTER_SERVER message is used
 
 
+- PROTMESSID_CLM_SERVER_LIST_PART: Part of a server list in compact format
+
+    +-----------------+----------------------+-----------------------+ ...
+    | 2 bytes list ID | 1 byte part index    | 1 byte number of parts | ...
+    +-----------------+----------------------+-----------------------+ ...
+        ... ---------------------------+--------------------------------+ ...
+        ...  1 byte number of strings  | string table entries           | ...
+        ... ---------------------------+--------------------------------+ ...
+
+    each string table entry:
+
+    +------------------+----------------------+
+    | 2 bytes number n | n bytes UTF-8 string |
+    +------------------+----------------------+
+
+    for each server of this part append following data:
+
+    +--------------------+--------------+-----------------+ ...
+    | 4 bytes IP address | 2 bytes port | 2 bytes country | ...
+    +--------------------+--------------+-----------------+ ...
+        ... ----------------------------------+--------------+ ...
+        ...  1 byte maximum connected clients | 1 byte flags | ...
+        ... ----------------------------------+--------------+ ...
+        ... ------------------+----------------------------------+ ...
+        ...  2 bytes number n | n bytes UTF-8 string server name | ...
+        ... ------------------+----------------------------------+ ...
+        ... -------------------------+-------------------------+
+        ...  1 byte topic string idx | 1 byte city string idx  |
+        ... -------------------------+-------------------------+
+
+    - "list ID": all parts of one server list have the same ID
+    - "flags": bit 0: server is permanent online
+               bit 1: topic string index is present
+               bit 2: city string index is present
+    - the topic and city are indices in the string table of the part, each
+      part can be decoded on its own
+    - the parts are sized so that the network packet is not fragmented
+
+
 - PROTMESSID_CLM_REQ_SERVER_LIST: Request server list
 
-    note: does not have any data -> n = 0
+    +-----------------------------------+
+    | 1 byte supported list format      |
+    +-----------------------------------+
+
+    - "supported list format": 0: only PROTMESSID_CLM_SERVER_LIST
+                               1: PROTMESSID_CLM_SERVER_LIST_PART supported
+
+    note: old versions send this message without any data (n = 0)
 
 
 - PROTMESSID_CLM_SEND_EMPTY_MESSAGE: Send "empty message" message
@@ -263,6 +402,26 @@ CONNECTION LESS MESSAGES
     note: does not have any data -> n = 0
 
 
+- PROTMESSID_CLM_AUDIO_DELAY_MEAS: Measurement of the audio delay
+
+    +-----------------------------+----------------------------+
+    | 4 bytes transmit time in ms | 2 bytes jitter buffer fill |
+    +-----------------------------+----------------------------+
+
+    - "transmit time":      time stamp of the client, the server returns it
+                            unchanged
+    - "jitter buffer fill": number of audio frames in the jitter buffer of the
+                            channel at the server when the server answers, the
+                            client sends 0
+
+    note: the client adds the round trip time of this message, the jitter
+          buffer fills of both sides and the fixed buffer delays to get the
+          overall delay without touching the audio signal, the message is
+          not acknowledged so that the round trip time is not falsified by
+          re-transmissions, the server only answers connected clients and
+          old servers ignore this message
+
+
  ******************************************************************************
  *
  * This program is free software; you can redistribute it and/or modify it under
@@ -285,10 +444,25 @@ CONNECTION LESS MESSAGES
 
 
 /* Implementation *************************************************************/
-CProtocol::CProtocol()
+CProtocol::CProtocol() :
+    iCLServerListSendID      ( 0 ),
+    iCLServerListRecID       ( -1 ),
+    iCLServerListRecNumParts ( 0 ),
+    iSessionID               ( 0 ),
+    iNumParseDefer           ( 0 )
 {
+    // buffer for messages which are received ahead of the expected one (the
+    // buffer is indexed by the 8 bit counter value)
+    vecRecMessBuf.Init ( 256 );
+
+    // the time base for the re-transmission time out
+    ElapsedTimer.start();
+
     Reset();
 
+    // the timer is started for the next re-transmission time out
+    TimerSendMess.setSingleShot ( true );
+
 
     // Connections -------------------------------------------------------------
     QObject::connect ( &TimerSendMess, SIGNAL ( timeout() ),
@@ -304,21 +478,47 @@ void CProtocol::Reset()
     iOldRecID  = PROTMESSID_ILLEGAL;
     iOldRecCnt = 0;
 
+    // a new connection starts without a connected clients list
+    vecConClientList.Init ( 0 );
+    iConClientListVersion = INVALID_CONN_CLIENTS_LIST_VERSION;
+
     // delete complete "send message queue"
     SendMessQueue.clear();
+    PendingSendFrames.clear();
+
+    // the other side does not know about our features after a reset, we use a
+    // new session ID so that the other side can detect the reset
+    const int iOldSessionID = iSessionID;
+
+    do
+    {
+        iSessionID = rand() & 0xFFFF;
+    }
+    while ( iSessionID == iOldSessionID );
+
+    bProtFeaturesSent  = false;
+    bProtFeaturesAckn  = false;
+    iPeerFeatures      = 0;
+    iPeerSessionID     = -1; // invalid session ID
+    iNextExpRecCnt     = 0;
+
+    for ( int i = 0; i < vecRecMessBuf.Size(); i++ )
+    {
+        vecRecMessBuf[i].bIsValid = false;
+    }
+
+    // initial re-transmission time out (no round trip time measured yet)
+    iSmoothedRTTMs    = -1;
+    iRTTVarianceMs    = 0;
+    iRetransTimeoutMs = SEND_MESS_TIMEOUT_MS;
 }
 
 void CProtocol::EnqueueMessage ( CVector<uint8_t>& vecMessage,
                                  const int         iCnt,
                                  const int         iID )
 {
-    bool bListWasEmpty;
-
     Mutex.lock();
     {
-        // check if list is empty so that we have to initiate a send process
-        bListWasEmpty = SendMessQueue.empty();
-
         // create send message object for the queue
         CSendMessage SendMessageObj ( vecMessage, iCnt, iID );
 
@@ -327,55 +527,231 @@ void CProtocol::EnqueueMessage ( CVector<uint8_t>& vecMessage,
     }
     Mutex.unlock();
 
-    // if list was empty, initiate send process
-    if ( bListWasEmpty )
-    {
-        SendMessage();
-    }
+    // the message is sent immediately if it is inside the send window
+    SendMessage();
 }
 
 void CProtocol::SendMessage()
 {
-    CVector<uint8_t> vecMessage;
-    bool             bSendMess = false;
+/*
+    Sends all messages in the send window which were not yet sent or for which
+    the re-transmission time out is expired. If the other side does not support
+    the windowed transfer, the send window is one message (stop-and-wait).
+*/
+    std::list<CVector<uint8_t> > MessagesToSend;
+    int                          iNextTimeOutMs = -1; // no time out pending
 
     Mutex.lock();
     {
-        // we have to check that list is not empty, since in another thread the
-        // last element of the list might have been erased
-        if ( !SendMessQueue.empty() )
+        const qint64 iCurTimeMs = ElapsedTimer.elapsed();
+
+        // we only open the window if the other side knows that we support the
+        // windowed transfer, too
+        int iWindowSize = 1;
+
+        if ( ( iPeerFeatures & PROT_FEATURE_WINDOWED_TRANSFER ) && bProtFeaturesAckn )
+        {
+            iWindowSize = PROT_SEND_WINDOW_SIZE;
+        }
+
+        std::list<CSendMessage>::iterator it = SendMessQueue.begin();
+
+        for ( int i = 0; ( i < iWindowSize ) && ( it != SendMessQueue.end() ); i++, it++ )
         {
-            vecMessage.Init ( SendMessQueue.front().vecMessage.Size() );
-            vecMessage = SendMessQueue.front().vecMessage;
+            // exponential back off for re-transmissions
+            int iTimeOutMs = iRetransTimeoutMs;
+
+            for ( int j = 1; ( j < it->iNumSent ) && ( iTimeOutMs < SEND_MESS_MAX_TIMEOUT_MS ); j++ )
+            {
+                iTimeOutMs *= 2;
+            }
+
+            if ( iTimeOutMs > SEND_MESS_MAX_TIMEOUT_MS )
+            {
+                iTimeOutMs = SEND_MESS_MAX_TIMEOUT_MS;
+            }
+
+            int iRemainingTimeMs =
+                iTimeOutMs - static_cast<int> ( iCurTimeMs - it->iSendTimeMs );
+
+            if ( ( it->iNumSent == 0 ) || ( iRemainingTimeMs <= 0 ) )
+            {
+                // (re-)transmit message
+                MessagesToSend.push_back ( it->vecMessage );
+
+                // the time out of the next re-transmission is doubled (this is
+                // not true for the first transmission)
+                if ( it->iNumSent > 0 )
+                {
+                    iTimeOutMs *= 2;
+
+                    if ( iTimeOutMs > SEND_MESS_MAX_TIMEOUT_MS )
+                    {
+                        iTimeOutMs = SEND_MESS_MAX_TIMEOUT_MS;
+                    }
+                }
+
+                it->iNumSent++;
+                it->iSendTimeMs  = iCurTimeMs;
+                iRemainingTimeMs = iTimeOutMs;
+            }
+
+            if ( ( iNextTimeOutMs < 0 ) || ( iRemainingTimeMs < iNextTimeOutMs ) )
+            {
+                iNextTimeOutMs = iRemainingTimeMs;
+            }
+        }
+    }
+    Mutex.unlock();
+
+    // send messages (outside the mutex since the connected slots may call
+    // functions of the protocol)
+    SendFrames ( MessagesToSend );
+
+    if ( iNextTimeOutMs >= 0 )
+    {
+        // start time-out timer for the next re-transmission
+        TimerSendMess.start ( iNextTimeOutMs );
+    }
+    else
+    {
+        // no message to send, stop timer
+        TimerSendMess.stop();
+    }
+}
 
-            bSendMess = true;
+void CProtocol::SendFrames ( std::list<CVector<uint8_t> >& Frames )
+{
+/*
+    If the other side supports message containers, all frames which fit into
+    one network packet are sent together. While a received message is parsed,
+    the frames are collected so that the acknowledgement and the answers to
+    the message are sent in one packet.
+    note: must be called without locked mutex
+*/
+    bool bUseContainer;
+    bool bDefer;
+
+    Mutex.lock();
+    {
+        bUseContainer = ( iPeerFeatures & PROT_FEATURE_MESS_CONTAINER ) != 0;
+        bDefer        = bUseContainer && ( iNumParseDefer > 0 );
+
+        if ( bDefer )
+        {
+            PendingSendFrames.splice ( PendingSendFrames.end(), Frames );
         }
     }
     Mutex.unlock();
 
-    if ( bSendMess )
+    if ( bDefer )
     {
-        // send message
-        emit MessReadyForSending ( vecMessage );
+        return;
+    }
+
+    std::list<CVector<uint8_t> >::iterator it = Frames.begin();
+
+    while ( it != Frames.end() )
+    {
+        // find the frames which fit into one container
+        std::list<CVector<uint8_t> >::iterator itEnd = it;
+
+        int iContainerLen = 0;
+        int iNumFrames    = 0;
+
+        while ( bUseContainer && ( itEnd != Frames.end() ) &&
+                ( MESS_LEN_WITHOUT_DATA_BYTE + iContainerLen + itEnd->Size() <=
+                  PROT_MAX_CONTAINER_SIZE_BYTES ) )
+        {
+            iContainerLen += itEnd->Size();
+            iNumFrames++;
+            itEnd++;
+        }
 
-        // start time-out timer if not active
-        if ( !TimerSendMess.isActive() )
+        if ( iNumFrames <= 1 )
         {
-            TimerSendMess.start ( SEND_MESS_TIMEOUT_MS );
+            // a single frame is sent as it is
+            emit MessReadyForSending ( *it );
+            it++;
+        }
+        else
+        {
+            CVector<uint8_t> vecContainer;
+            CMessWriter      MessWriter ( vecContainer, iContainerLen );
+
+            for ( ; it != itEnd; it++ )
+            {
+                MessWriter.PutBytes ( *it );
+            }
+
+            // the container is not acknowledged, therefore the counter is
+            // not used
+            GenMessageFrame ( vecContainer, 0, PROTMESSID_MESS_CONTAINER );
+
+            emit MessReadyForSending ( vecContainer );
         }
     }
+}
+
+bool CProtocol::IsPeerFeatureSupported ( const int iFeature )
+{
+    QMutexLocker locker ( &Mutex );
+
+    return ( iPeerFeatures & iFeature ) != 0;
+}
+
+void CProtocol::UpdateRetransmitTimeout ( const int iRoundTripTimeMs )
+{
+/*
+    note: must be called with locked mutex
+    The re-transmission time out is calculated from the smoothed round trip
+    time and its variation as done for TCP (RFC 6298).
+*/
+    if ( iSmoothedRTTMs < 0 )
+    {
+        // first measurement
+        iSmoothedRTTMs = iRoundTripTimeMs;
+        iRTTVarianceMs = iRoundTripTimeMs / 2;
+    }
     else
     {
-        // no message to send, stop timer
-        TimerSendMess.stop();
+        iRTTVarianceMs = ( 3 * iRTTVarianceMs +
+            abs ( iSmoothedRTTMs - iRoundTripTimeMs ) ) / 4;
+
+        iSmoothedRTTMs = ( 7 * iSmoothedRTTMs + iRoundTripTimeMs ) / 8;
+    }
+
+    iRetransTimeoutMs = iSmoothedRTTMs + 4 * iRTTVarianceMs;
+
+    if ( iRetransTimeoutMs < SEND_MESS_MIN_TIMEOUT_MS )
+    {
+        iRetransTimeoutMs = SEND_MESS_MIN_TIMEOUT_MS;
+    }
+
+    if ( iRetransTimeoutMs > SEND_MESS_MAX_TIMEOUT_MS )
+    {
+        iRetransTimeoutMs = SEND_MESS_MAX_TIMEOUT_MS;
     }
 }
 
-void CProtocol::CreateAndSendMessage ( const int               iID,
-                                       const CVector<uint8_t>& vecData )
+int CProtocol::GetNextSendCounter()
 {
-    CVector<uint8_t> vecNewMessage;
-    int              iCurCounter;
+    int  iCurCounter;
+    bool bSendProtFeatures;
+
+    // the first message after a reset informs the other side about our
+    // supported protocol features
+    Mutex.lock();
+    {
+        bSendProtFeatures = !bProtFeaturesSent;
+        bProtFeaturesSent = true;
+    }
+    Mutex.unlock();
+
+    if ( bSendProtFeatures )
+    {
+        CreateProtFeaturesMes();
+    }
 
     Mutex.lock();
     {
@@ -387,175 +763,550 @@ void CProtocol::CreateAndSendMessage ( const int               iID,
     }
     Mutex.unlock();
 
-    // build complete message
-    GenMessageFrame ( vecNewMessage, iCurCounter, iID, vecData );
+    return iCurCounter;
+}
+
+void CProtocol::CreateAndSendMessage ( const int         iID,
+                                       CVector<uint8_t>& vecMessage )
+{
+    const int iCurCounter = GetNextSendCounter();
+
+    // complete message (the body is already written in the vector)
+    GenMessageFrame ( vecMessage, iCurCounter, iID );
+
+    // enqueue message
+    EnqueueMessage ( vecMessage, iCurCounter, iID );
+}
+
+void CProtocol::CreateBroadcastMes ( const CBroadcastMessage& BroadcastMes )
+{
+    const int iCurCounter = GetNextSendCounter();
+
+    // the frame is complete except of the counter and the CRC
+    CVector<uint8_t> vecMessage ( BroadcastMes.vecMessage );
+
+    vecMessage[4] = static_cast<uint8_t> ( iCurCounter & 255 );
+
+    // only the header is processed, the body part of the CRC was calculated
+    // once on preparing the broadcast message
+    CCRC CRCObj;
+
+    CRCObj.AddBytes ( &vecMessage[0], MESS_HEADER_LENGTH_BYTE );
+
+    CRCObj.SetState ( CCRC::ApplyOperator ( BroadcastMes.pZeroBytesOperator,
+                                            CRCObj.GetState() ) ^
+                      BroadcastMes.iBodyCRCState );
+
+    const uint32_t iCRC        = CRCObj.GetCRC();
+    const int      iLenCRCCalc = vecMessage.Size() - 2;
+
+    vecMessage[iLenCRCCalc]     = static_cast<uint8_t> ( iCRC & 255 );
+    vecMessage[iLenCRCCalc + 1] = static_cast<uint8_t> ( ( iCRC >> 8 ) & 255 );
 
     // enqueue message
-    EnqueueMessage ( vecNewMessage, iCurCounter, iID );
+    EnqueueMessage ( vecMessage, iCurCounter, BroadcastMes.iID );
+}
+
+void CProtocol::CreateAndSendMessage ( const int iID )
+{
+    // message without body data
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, 0 );
+
+    CreateAndSendMessage ( iID, vecMessage );
 }
 
 void CProtocol::CreateAndImmSendAcknMess ( const int& iID,
                                            const int& iCnt )
 {
+    int  iCurNextExpRecCnt;
+    bool bPeerIsWindowed;
+
+    Mutex.lock();
+    {
+        bPeerIsWindowed   = ( iPeerFeatures & PROT_FEATURE_WINDOWED_TRANSFER ) != 0;
+        iCurNextExpRecCnt = iNextExpRecCnt;
+    }
+    Mutex.unlock();
+
+    // for the windowed transfer we append the next expected counter value
+    // (cumulative acknowledgement)
     CVector<uint8_t> vecAcknMessage;
-    CVector<uint8_t> vecData ( 2 ); // 2 bytes of data
-    int              iPos = 0; // init position pointer
+    CMessWriter      MessWriter ( vecAcknMessage, bPeerIsWindowed ? 3 : 2 );
 
     // build data vector
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iID ), 2 );
+    MessWriter.PutVal ( static_cast<uint32_t> ( iID ), 2 );
+
+    if ( bPeerIsWindowed )
+    {
+        MessWriter.PutVal ( static_cast<uint32_t> ( iCurNextExpRecCnt ), 1 );
+    }
 
     // build complete message
-    GenMessageFrame ( vecAcknMessage, iCnt, PROTMESSID_ACKN, vecData );
+    GenMessageFrame ( vecAcknMessage, iCnt, PROTMESSID_ACKN );
 
-    // immediately send acknowledge message
-    emit MessReadyForSending ( vecAcknMessage );
+    // immediately send acknowledge message (if we are parsing a received
+    // message, it is sent together with the answers)
+    std::list<CVector<uint8_t> > MessagesToSend ( 1, vecAcknMessage );
+
+    SendFrames ( MessagesToSend );
 }
 
-void CProtocol::CreateAndImmSendConLessMessage ( const int               iID,
-                                                 const CVector<uint8_t>& vecData,
-                                                 const CHostAddress&     InetAddr )
+void CProtocol::CreateAndImmSendConLessMessage ( const int           iID,
+                                                 CVector<uint8_t>&   vecMessage,
+                                                 const CHostAddress& InetAddr )
 {
-    CVector<uint8_t> vecNewMessage;
-
-    // build complete message (counter per definition=0 for connection less
+    // complete message (counter per definition=0 for connection less
     // messages)
-    GenMessageFrame ( vecNewMessage, 0, iID, vecData );
+    GenMessageFrame ( vecMessage, 0, iID );
 
     // immediately send message
-    emit CLMessReadyForSending ( InetAddr, vecNewMessage );
+    emit CLMessReadyForSending ( InetAddr, vecMessage );
+}
+
+void CProtocol::CreateAndImmSendConLessMessage ( const int           iID,
+                                                 const CHostAddress& InetAddr )
+{
+    // message without body data
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, 0 );
+
+    CreateAndImmSendConLessMessage ( iID, vecMessage, InetAddr );
 }
 
 bool CProtocol::ParseMessageBody ( const CVector<uint8_t>& vecbyMesBodyData,
                                    const int               iRecCounter,
                                    const int               iRecID )
 {
+/*
+    return code: false -> ok; true -> error
+*/
+    // the messages which are generated while parsing (acknowledgements and
+    // answers) are collected and sent together afterwards
+    Mutex.lock();
+    iNumParseDefer++;
+    Mutex.unlock();
+
+    const bool bRet = ParseMessageBodyIntern ( vecbyMesBodyData,
+                                               iRecCounter,
+                                               iRecID );
+
+    std::list<CVector<uint8_t> > MessagesToSend;
+
+    Mutex.lock();
+    {
+        iNumParseDefer--;
+
+        if ( iNumParseDefer == 0 )
+        {
+            MessagesToSend.swap ( PendingSendFrames );
+        }
+    }
+    Mutex.unlock();
+
+    SendFrames ( MessagesToSend );
+
+    return bRet;
+}
+
+bool CProtocol::ParseMessageBodyIntern ( const CVector<uint8_t>& vecbyMesBodyData,
+                                         const int               iRecCounter,
+                                         const int               iRecID )
+{
 /*
     return code: false -> ok; true -> error
 */
     bool bRet = false;
-    bool bSendNextMess;
+
+    // a message container is not acknowledged, the contained messages are
+    // parsed one after the other
+    if ( iRecID == PROTMESSID_MESS_CONTAINER )
+    {
+        return ParseMessageContainer ( vecbyMesBodyData );
+    }
 
 /*
 // TEST channel implementation: randomly delete protocol messages (50 % loss)
 if ( rand() < ( RAND_MAX / 2 ) ) return false;
 */
 
-    // In case we received a message and returned an answer but our answer
-    // did not make it to the receiver, he will resend his message. We check
-    // here if the message is the same as the old one, and if this is the
-    // case, just resend our old answer again
-    if ( ( iOldRecID == iRecID ) && ( iOldRecCnt == iRecCounter ) )
+    // special treatment for acknowledge messages
+    if ( iRecID == PROTMESSID_ACKN )
     {
-        // acknowledgments are not acknowledged
-        if ( iRecID != PROTMESSID_ACKN )
+        CMessReader MessReader ( vecbyMesBodyData );
+
+        // check size
+        if ( MessReader.GetRemaining() < 2 )
         {
-            // resend acknowledgement
-            CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+            return true; // return error code
         }
-    }
-    else
-    {
-        // special treatment for acknowledge messages
-        if ( iRecID == PROTMESSID_ACKN )
+
+        // extract data from stream
+        const int iData = static_cast<int> ( MessReader.GetVal ( 2 ) );
+
+        // optional next expected counter value of the windowed transfer
+        int iAcknNextExpCnt = -1; // not available
+
+        if ( MessReader.GetRemaining() >= 1 )
+        {
+            iAcknNextExpCnt = static_cast<int> ( MessReader.GetVal ( 1 ) );
+        }
+
+        bool bSendNextMess = false;
+
+        Mutex.lock();
         {
-            // extract data from stream and emit signal for received value
-            int       iPos = 0;
-            const int iData =
-                static_cast<int> ( GetValFromStream ( vecbyMesBodyData, iPos, 2 ) );
+            const qint64 iCurTimeMs = ElapsedTimer.elapsed();
 
-            Mutex.lock();
+            std::list<CSendMessage>::iterator it = SendMessQueue.begin();
+
+            while ( it != SendMessQueue.end() )
             {
-                // check if this is the correct acknowledgment
-                bSendNextMess = false;
-                if ( !SendMessQueue.empty() )
+                bool bIsAckn = false;
+
+                // only messages which were already sent can be acknowledged
+                if ( it->iNumSent > 0 )
                 {
-                    if ( ( SendMessQueue.front().iCnt == iRecCounter ) &&
-                         ( SendMessQueue.front().iID == iData ) )
+                    if ( ( it->iCnt == iRecCounter ) && ( it->iID == iData ) )
+                    {
+                        bIsAckn = true;
+
+                        // measure the round trip time only on messages which
+                        // were not re-transmitted (otherwise we do not know
+                        // which transmission is acknowledged)
+                        if ( it->iNumSent == 1 )
+                        {
+                            UpdateRetransmitTimeout ( static_cast<int> (
+                                iCurTimeMs - it->iSendTimeMs ) );
+                        }
+                    }
+                    else if ( iAcknNextExpCnt >= 0 )
                     {
-                        // message acknowledged, remove from queue
-                        SendMessQueue.pop_front();
+                        // all messages before the next expected counter value
+                        // are received by the other side
+                        const int iDist = ( iAcknNextExpCnt - it->iCnt ) & 255;
 
-                        // send next message in queue
-                        bSendNextMess = true;
+                        bIsAckn = ( iDist >= 1 ) && ( iDist <= PROT_RECEIVE_WINDOW_SIZE );
                     }
                 }
-            }
-            Mutex.unlock();
-
-            if ( bSendNextMess )
-            {
-                SendMessage();
-            }
-        }
-        else
-        {
-            // check which type of message we received and do action
-            switch ( iRecID )
-            {
-            case PROTMESSID_JITT_BUF_SIZE:
-                bRet = EvaluateJitBufMes ( vecbyMesBodyData );
-                break;
 
-            case PROTMESSID_REQ_JITT_BUF_SIZE:
-                bRet = EvaluateReqJitBufMes();
-                break;
+                if ( bIsAckn )
+                {
+                    if ( it->iID == PROTMESSID_PROTOCOL_FEATURES )
+                    {
+                        // the other side knows our features now
+                        bProtFeaturesAckn = true;
+                    }
 
-            case PROTMESSID_CHANNEL_GAIN:
-                bRet = EvaluateChanGainMes ( vecbyMesBodyData );
-                break;
+                    // message acknowledged, remove from queue
+                    it = SendMessQueue.erase ( it );
+
+                    // send next messages in queue
+                    bSendNextMess = true;
+                }
+                else
+                {
+                    it++;
+                }
+            }
+        }
+        Mutex.unlock();
+
+        if ( bSendNextMess )
+        {
+            SendMessage();
+        }
+
+        return false; // no error
+    }
+
+    // a protocol features message of a new session of the other side
+    // (re-)starts the transfer
+    if ( iRecID == PROTMESSID_PROTOCOL_FEATURES )
+    {
+        CMessReader MessReader ( vecbyMesBodyData );
+
+        if ( MessReader.GetRemaining() >= 2 )
+        {
+            const int iRecSessionID = static_cast<int> ( MessReader.GetVal ( 2 ) );
+
+            Mutex.lock();
+            const bool bIsNewSession = ( iRecSessionID != iPeerSessionID );
+            Mutex.unlock();
+
+            if ( bIsNewSession )
+            {
+                bRet = EvaluateProtFeaturesMes ( vecbyMesBodyData, iRecCounter );
+
+                // immediately send acknowledge message
+                CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+
+                iOldRecID  = iRecID;
+                iOldRecCnt = iRecCounter;
+
+                return bRet;
+            }
+        }
+    }
+
+    Mutex.lock();
+    const bool bPeerIsWindowed = ( iPeerFeatures & PROT_FEATURE_WINDOWED_TRANSFER ) != 0;
+    Mutex.unlock();
+
+    if ( bPeerIsWindowed )
+    {
+        // the messages are delivered in the order of the counter values
+        return ParseMessageBodyInOrder ( vecbyMesBodyData, iRecCounter, iRecID );
+    }
+
+    // In case we received a message and returned an answer but our answer
+    // did not make it to the receiver, he will resend his message. We check
+    // here if the message is the same as the old one, and if this is the
+    // case, just resend our old answer again
+    if ( ( iOldRecID == iRecID ) && ( iOldRecCnt == iRecCounter ) )
+    {
+        // resend acknowledgement
+        CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+    }
+    else
+    {
+        bRet = EvaluateMessage ( vecbyMesBodyData, iRecCounter, iRecID );
+
+        // immediately send acknowledge message
+        CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+
+        // save current message ID and counter to find out if message
+        // was resent
+        iOldRecID  = iRecID;
+        iOldRecCnt = iRecCounter;
+    }
+
+    return bRet;
+}
+
+bool CProtocol::ParseMessageContainer ( const CVector<uint8_t>& vecbyMesBodyData )
+{
+/*
+    return code: false -> ok; true -> error
+*/
+    bool             bRet      = false;
+    int              iPos      = 0;
+    const int        iTotLenBy = vecbyMesBodyData.Size();
+    int              iRecCounter, iRecID;
+    CVector<uint8_t> vecbyCurMesBodyData;
+
+    while ( iTotLenBy - iPos >= MESS_LEN_WITHOUT_DATA_BYTE )
+    {
+        const uint8_t* pbyFrame = &vecbyMesBodyData.front() + iPos;
+
+        // the length of the frame is stored in the header (after TAG, ID
+        // and cnt)
+        CMessReader LenReader ( pbyFrame + 5, 2 );
+
+        const int iFrameLenBy =
+            MESS_LEN_WITHOUT_DATA_BYTE + static_cast<int> ( LenReader.GetVal ( 2 ) );
+
+        if ( ( iFrameLenBy > iTotLenBy - iPos ) ||
+             ParseMessageFrame ( pbyFrame,
+                                 iFrameLenBy,
+                                 vecbyCurMesBodyData,
+                                 iRecCounter,
+                                 iRecID ) )
+        {
+            return true; // return error code
+        }
+
+        iPos += iFrameLenBy;
+
+        // nested containers and connection less messages are not allowed
+        if ( ( iRecID == PROTMESSID_MESS_CONTAINER ) ||
+             IsConnectionLessMessageID ( iRecID ) )
+        {
+            bRet = true;
+        }
+        else
+        {
+            if ( ParseMessageBodyIntern ( vecbyCurMesBodyData,
+                                          iRecCounter,
+                                          iRecID ) )
+            {
+                bRet = true;
+            }
+        }
+    }
+
+    if ( iPos != iTotLenBy )
+    {
+        bRet = true; // unused bytes at the end of the container
+    }
+
+    return bRet;
+}
+
+bool CProtocol::ParseMessageBodyInOrder ( const CVector<uint8_t>& vecbyMesBodyData,
+                                          const int               iRecCounter,
+                                          const int               iRecID )
+{
+/*
+    Windowed transfer: several messages may be on the way at the same time and
+    can be re-ordered or lost. Messages ahead of the next expected counter
+    value are stored until the gap is closed, messages before it were already
+    delivered (our acknowledgement got lost) and are only acknowledged again.
+*/
+    bool bRet  = false;
+    bool bAckn = true;
+
+    Mutex.lock();
+    {
+        const int iDist = ( iRecCounter - iNextExpRecCnt ) & 255;
+
+        if ( iDist < PROT_RECEIVE_WINDOW_SIZE )
+        {
+            // store the message if we do not already have it
+            CRecMessage& RecMess = vecRecMessBuf[iRecCounter];
+
+            if ( !RecMess.bIsValid )
+            {
+                RecMess.vecMessBody.Init ( vecbyMesBodyData.Size() );
+                RecMess.vecMessBody = vecbyMesBodyData;
+                RecMess.iID         = iRecID;
+                RecMess.bIsValid    = true;
+            }
+        }
+        else if ( iDist < 256 - PROT_RECEIVE_WINDOW_SIZE )
+        {
+            // far ahead of the window, this should not happen, do not
+            // acknowledge the message so that it is re-transmitted later
+            bAckn = false;
+        }
+    }
+    Mutex.unlock();
+
+    // deliver all messages which are now in order
+    CVector<uint8_t> vecbyCurMesBodyData;
+    int              iCurID;
+    int              iCurCnt;
+    bool             bMessAvailable = true;
+
+    while ( bMessAvailable )
+    {
+        Mutex.lock();
+        {
+            CRecMessage& RecMess = vecRecMessBuf[iNextExpRecCnt];
+
+            bMessAvailable = RecMess.bIsValid;
+
+            if ( bMessAvailable )
+            {
+                vecbyCurMesBodyData.Init ( RecMess.vecMessBody.Size() );
+                vecbyCurMesBodyData = RecMess.vecMessBody;
+                iCurID              = RecMess.iID;
+                iCurCnt             = iNextExpRecCnt;
+                RecMess.bIsValid    = false;
+                iNextExpRecCnt      = ( iNextExpRecCnt + 1 ) & 255;
+            }
+        }
+        Mutex.unlock();
+
+        if ( bMessAvailable )
+        {
+            const bool bCurRet =
+                EvaluateMessage ( vecbyCurMesBodyData, iCurCnt, iCurID );
+
+            if ( iCurCnt == iRecCounter )
+            {
+                bRet = bCurRet;
+            }
+        }
+    }
+
+    if ( bAckn )
+    {
+        // immediately send acknowledge message
+        CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+    }
+
+    return bRet;
+}
+
+bool CProtocol::EvaluateMessage ( const CVector<uint8_t>& vecbyMesBodyData,
+                                  const int               iRecCounter,
+                                  const int               iRecID )
+{
+/*
+    return code: false -> ok; true -> error
+*/
+    bool bRet = false;
+
+    // check which type of message we received and do action
+    switch ( iRecID )
+    {
+    case PROTMESSID_JITT_BUF_SIZE:
+        bRet = EvaluateJitBufMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_REQ_JITT_BUF_SIZE:
+        bRet = EvaluateReqJitBufMes();
+        break;
+
+    case PROTMESSID_CHANNEL_GAIN:
+        bRet = EvaluateChanGainMes ( vecbyMesBodyData );
+        break;
 
 // #### COMPATIBILITY OLD VERSION, TO BE REMOVED ####
 case PROTMESSID_CONN_CLIENTS_LIST_NAME:
     bRet = EvaluateConClientListNameMes ( vecbyMesBodyData );
     break;
 
-            case PROTMESSID_CONN_CLIENTS_LIST:
-                bRet = EvaluateConClientListMes ( vecbyMesBodyData );
-                break;
+    case PROTMESSID_CONN_CLIENTS_LIST:
+        bRet = EvaluateConClientListMes ( vecbyMesBodyData );
+        break;
 
-            case PROTMESSID_REQ_CONN_CLIENTS_LIST:
-                bRet = EvaluateReqConnClientsList();
-                break;
+    case PROTMESSID_REQ_CONN_CLIENTS_LIST:
+        bRet = EvaluateReqConnClientsList();
+        break;
 
 // #### COMPATIBILITY OLD VERSION, TO BE REMOVED ####
 case PROTMESSID_CHANNEL_NAME:
     bRet = EvaluateChanNameMes ( vecbyMesBodyData );
     break;
 
-            case PROTMESSID_CHANNEL_INFOS:
-                bRet = EvaluateChanInfoMes ( vecbyMesBodyData );
-                break;
+    case PROTMESSID_CHANNEL_INFOS:
+        bRet = EvaluateChanInfoMes ( vecbyMesBodyData );
+        break;
 
-            case PROTMESSID_REQ_CHANNEL_INFOS:
-                bRet = EvaluateReqChanInfoMes();
-                break;
+    case PROTMESSID_REQ_CHANNEL_INFOS:
+        bRet = EvaluateReqChanInfoMes();
+        break;
 
-            case PROTMESSID_CHAT_TEXT:
-                bRet = EvaluateChatTextMes ( vecbyMesBodyData );
-                break;
+    case PROTMESSID_CHAT_TEXT:
+        bRet = EvaluateChatTextMes ( vecbyMesBodyData );
+        break;
 
-            case PROTMESSID_NETW_TRANSPORT_PROPS:
-                bRet = EvaluateNetwTranspPropsMes ( vecbyMesBodyData );
-                break;
+    case PROTMESSID_NETW_TRANSPORT_PROPS:
+        bRet = EvaluateNetwTranspPropsMes ( vecbyMesBodyData );
+        break;
 
-            case PROTMESSID_REQ_NETW_TRANSPORT_PROPS:
-                bRet = EvaluateReqNetwTranspPropsMes();
-                break;
+    case PROTMESSID_REQ_NETW_TRANSPORT_PROPS:
+        bRet = EvaluateReqNetwTranspPropsMes();
+        break;
 
 // #### COMPATIBILITY OLD VERSION, TO BE REMOVED ####
 case PROTMESSID_OPUS_SUPPORTED:
     bRet = EvaluateOpusSupportedMes();
     break;
-            }
 
-            // immediately send acknowledge message
-            CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+    case PROTMESSID_PROTOCOL_FEATURES:
+        bRet = EvaluateProtFeaturesMes ( vecbyMesBodyData, iRecCounter );
+        break;
 
-            // save current message ID and counter to find out if message
-            // was resent
-            iOldRecID  = iRecID;
-            iOldRecCnt = iRecCounter;
-        }
+    case PROTMESSID_CONN_CLIENTS_LIST_DELTA:
+        bRet = EvaluateConClientListDeltaMes ( vecbyMesBodyData );
+        break;
+
+    case PROTMESSID_LOCAL_MONITORING:
+        bRet = EvaluateLocalMonitoringMes ( vecbyMesBodyData );
+        break;
     }
 
     return bRet;
@@ -625,8 +1376,12 @@ if ( rand() < ( RAND_MAX / 2 ) ) return false;
             bRet = EvaluateCLServerListMes ( InetAddr, vecbyMesBodyData );
             break;
 
+        case PROTMESSID_CLM_SERVER_LIST_PART:
+            bRet = EvaluateCLServerListPartMes ( InetAddr, vecbyMesBodyData );
+            break;
+
         case PROTMESSID_CLM_REQ_SERVER_LIST:
-            bRet = EvaluateCLReqServerListMes ( InetAddr );
+            bRet = EvaluateCLReqServerListMes ( InetAddr, vecbyMesBodyData );
             break;
 
         case PROTMESSID_CLM_SEND_EMPTY_MESSAGE:
@@ -644,6 +1399,10 @@ if ( rand() < ( RAND_MAX / 2 ) ) return false;
         case PROTMESSID_CLM_DISCONNECTION:
             bRet = EvaluateCLDisconnectionMes ( InetAddr );
             break;
+
+        case PROTMESSID_CLM_AUDIO_DELAY_MEAS:
+            bRet = EvaluateCLAudioDelayMeasMes ( InetAddr, vecbyMesBodyData );
+            break;
         }
     }
     else
@@ -660,18 +1419,18 @@ if ( rand() < ( RAND_MAX / 2 ) ) return false;
 \******************************************************************************/
 void CProtocol::CreateJitBufMes ( const int iJitBufSize )
 {
-    CVector<uint8_t> vecData ( 2 ); // 2 bytes of data
-    int              iPos = 0;      // init position pointer
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, 2 ); // 2 bytes of data
 
     // build data vector
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iJitBufSize ), 2 );
+    MessWriter.PutVal ( static_cast<uint32_t> ( iJitBufSize ), 2 );
 
-    CreateAndSendMessage ( PROTMESSID_JITT_BUF_SIZE, vecData );
+    CreateAndSendMessage ( PROTMESSID_JITT_BUF_SIZE, vecMessage );
 }
 
 bool CProtocol::EvaluateJitBufMes ( const CVector<uint8_t>& vecData )
 {
-    int iPos = 0; // init position pointer
+    CMessReader MessReader ( vecData );
 
     // check size
     if ( vecData.Size() != 2 )
@@ -681,7 +1440,7 @@ bool CProtocol::EvaluateJitBufMes ( const CVector<uint8_t>& vecData )
 
     // extract jitter buffer size
     const int iData =
-        static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+        static_cast<int> ( MessReader.GetVal ( 2 ) );
 
     if ( ( ( iData < MIN_NET_BUF_SIZE_NUM_BL ) ||
            ( iData > MAX_NET_BUF_SIZE_NUM_BL ) ) &&
@@ -698,8 +1457,7 @@ bool CProtocol::EvaluateJitBufMes ( const CVector<uint8_t>& vecData )
 
 void CProtocol::CreateReqJitBufMes()
 {
-    CreateAndSendMessage ( PROTMESSID_REQ_JITT_BUF_SIZE,
-                           CVector<uint8_t> ( 0 ) );
+    CreateAndSendMessage ( PROTMESSID_REQ_JITT_BUF_SIZE );
 }
 
 bool CProtocol::EvaluateReqJitBufMes()
@@ -712,24 +1470,24 @@ bool CProtocol::EvaluateReqJitBufMes()
 
 void CProtocol::CreateChanGainMes ( const int iChanID, const double dGain )
 {
-    CVector<uint8_t> vecData ( 3 ); // 3 bytes of data
-    int              iPos = 0;      // init position pointer
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, 3 ); // 3 bytes of data
 
     // build data vector
     // channel ID
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iChanID ), 1 );
+    MessWriter.PutVal ( static_cast<uint32_t> ( iChanID ), 1 );
 
     // actual gain, we convert from double with range 0..1 to integer
     const int iCurGain = static_cast<int> ( dGain * ( 1 << 15 ) );
 
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iCurGain ), 2 );
+    MessWriter.PutVal ( static_cast<uint32_t> ( iCurGain ), 2 );
 
-    CreateAndSendMessage ( PROTMESSID_CHANNEL_GAIN, vecData );
+    CreateAndSendMessage ( PROTMESSID_CHANNEL_GAIN, vecMessage );
 }
 
 bool CProtocol::EvaluateChanGainMes ( const CVector<uint8_t>& vecData )
 {
-    int iPos = 0; // init position pointer
+    CMessReader MessReader ( vecData );
 
     // check size
     if ( vecData.Size() != 3 )
@@ -739,11 +1497,11 @@ bool CProtocol::EvaluateChanGainMes ( const CVector<uint8_t>& vecData )
 
     // channel ID
     const int iCurID =
-        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+        static_cast<int> ( MessReader.GetVal ( 1 ) );
 
     // gain (read integer value)
     const int iData =
-        static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+        static_cast<int> ( MessReader.GetVal ( 2 ) );
 
     // we convert the gain from integer to double with range 0..1
     const double dNewGain = static_cast<double> ( iData ) / ( 1 << 15 );
@@ -758,66 +1516,67 @@ void CProtocol::CreateConClientListNameMes ( const CVector<CChannelInfo>& vecCha
 {
     const int iNumClients = vecChanInfo.Size();
 
-    // build data vector
-    CVector<uint8_t> vecData ( 0 );
-    int              iPos = 0; // init position pointer
+    // convert name strings to utf-8 and calculate the size of the message
+    // body so that the message can be allocated at once
+    CVector<QByteArray> vecstrUTF8Name ( iNumClients );
+    int                 iEntrLen = 0;
 
     for ( int i = 0; i < iNumClients; i++ )
     {
-        // convert name string to utf-8
-        const QByteArray strUTF8Name = vecChanInfo[i].strName.toUtf8();
+        vecstrUTF8Name[i] = vecChanInfo[i].strName.toUtf8();
 
         // size of current list entry
-        const int iCurListEntrLen =
+        iEntrLen +=
             1 /* chan ID */ + 4 /* IP addr. */ +
-            2 /* utf-8 str. size */ + strUTF8Name.size();
+            2 /* utf-8 str. size */ + vecstrUTF8Name[i].size();
+    }
 
-        // make space for new data
-        vecData.Enlarge ( iCurListEntrLen );
+    // build data vector (the body is directly written in the message)
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, iEntrLen );
 
+    for ( int i = 0; i < iNumClients; i++ )
+    {
         // channel ID (1 byte)
-        PutValOnStream ( vecData, iPos,
+        MessWriter.PutVal (
             static_cast<uint32_t> ( vecChanInfo[i].iChanID ), 1 );
 
         // IP address (4 bytes)
-        PutValOnStream ( vecData, iPos,
+        MessWriter.PutVal (
             static_cast<uint32_t> ( vecChanInfo[i].iIpAddr ), 4 );
 
         // name string
-        PutStringUTF8OnStream ( vecData, iPos, strUTF8Name );
+        MessWriter.PutStringUTF8 ( vecstrUTF8Name[i] );
     }
 
-    CreateAndSendMessage ( PROTMESSID_CONN_CLIENTS_LIST_NAME, vecData );
+    CreateAndSendMessage ( PROTMESSID_CONN_CLIENTS_LIST_NAME, vecMessage );
 }
 
 bool CProtocol::EvaluateConClientListNameMes ( const CVector<uint8_t>& vecData )
 {
-    int                   iPos     = 0; // init position pointer
     const int             iDataLen = vecData.Size();
     CVector<CChannelInfo> vecChanInfo ( 0 );
+    CMessReader           MessReader ( vecData );
 
-    while ( iPos < iDataLen )
+    while ( MessReader.GetRemaining() > 0 )
     {
         // check size (the next 5 bytes)
-        if ( ( iDataLen - iPos ) < 5 )
+        if ( MessReader.GetRemaining() < 5 )
         {
             return true; // return error code
         }
 
         // channel ID (1 byte)
         const int iChanID =
-            static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+            static_cast<int> ( MessReader.GetVal ( 1 ) );
 
         // IP address (4 bytes)
         const int iIpAddr =
-            static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
+            static_cast<int> ( MessReader.GetVal ( 4 ) );
 
         // name
         QString strCurStr;
-        if ( GetStringFromStream ( vecData,
-                                   iPos,
-                                   MAX_LEN_FADER_TAG,
-                                   strCurStr ) )
+        if ( MessReader.GetString ( MAX_LEN_FADER_TAG, strCurStr ) )
         {
             return true; // return error code
         }
@@ -827,7 +1586,7 @@ bool CProtocol::EvaluateConClientListNameMes ( const CVector<uint8_t>& vecData )
     }
 
     // check size: all data is read, the position must now be at the end
-    if ( iPos != iDataLen )
+    if ( MessReader.GetPos() != iDataLen )
     {
         return true; // return error code
     }
@@ -842,237 +1601,483 @@ void CProtocol::CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInf
 {
     const int iNumClients = vecChanInfo.Size();
 
-    // build data vector
-    CVector<uint8_t> vecData ( 0 );
-    int              iPos = 0; // init position pointer
+    // convert strings to utf-8 and calculate the size of the message body so
+    // that the message can be allocated at once
+    CVector<QByteArray> vecstrUTF8Name ( iNumClients );
+    CVector<QByteArray> vecstrUTF8City ( iNumClients );
+    int                 iEntrLen = 0;
 
     for ( int i = 0; i < iNumClients; i++ )
     {
-        // convert strings to utf-8
-        const QByteArray strUTF8Name = vecChanInfo[i].strName.toUtf8();
-        const QByteArray strUTF8City = vecChanInfo[i].strCity.toUtf8();
+        vecstrUTF8Name[i] = vecChanInfo[i].strName.toUtf8();
+        vecstrUTF8City[i] = vecChanInfo[i].strCity.toUtf8();
 
         // size of current list entry
-        const int iCurListEntrLen =
-            1 /* chan ID */ + 2 /* country */ +
-            4 /* instrument */ + 1 /* skill level */ +
-            4 /* IP address */ +
-            2 /* utf-8 str. size */ + strUTF8Name.size() +
-            2 /* utf-8 str. size */ + strUTF8City.size();
-
-        // make space for new data
-        vecData.Enlarge ( iCurListEntrLen );
-
-        // channel ID (1 byte)
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecChanInfo[i].iChanID ), 1 );
-
-        // country (2 bytes)
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecChanInfo[i].eCountry ), 2 );
-
-        // instrument (4 bytes)
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecChanInfo[i].iInstrument ), 4 );
-
-        // skill level (1 byte)
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecChanInfo[i].eSkillLevel ), 1 );
-
-        // IP address (4 bytes)
-        PutValOnStream ( vecData, iPos,
-            static_cast<uint32_t> ( vecChanInfo[i].iIpAddr ), 4 );
+        iEntrLen += GetConClientListEntrLen ( vecstrUTF8Name[i],
+                                              vecstrUTF8City[i] );
+    }
 
-        // name
-        PutStringUTF8OnStream ( vecData, iPos, strUTF8Name );
+    // build data vector (the body is directly written in the message)
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, iEntrLen );
 
-        // city
-        PutStringUTF8OnStream ( vecData, iPos, strUTF8City );
+    for ( int i = 0; i < iNumClients; i++ )
+    {
+        PutConClientListEntry ( MessWriter,
+                                vecChanInfo[i],
+                                vecstrUTF8Name[i],
+                                vecstrUTF8City[i] );
     }
 
-    CreateAndSendMessage ( PROTMESSID_CONN_CLIENTS_LIST, vecData );
+    CreateAndSendMessage ( PROTMESSID_CONN_CLIENTS_LIST, vecMessage );
 }
 
 bool CProtocol::EvaluateConClientListMes ( const CVector<uint8_t>& vecData )
 {
-    int                   iPos     = 0; // init position pointer
     const int             iDataLen = vecData.Size();
     CVector<CChannelInfo> vecChanInfo ( 0 );
+    CMessReader           MessReader ( vecData );
 
-    while ( iPos < iDataLen )
+    while ( MessReader.GetRemaining() > 0 )
     {
-        // check size (the next 12 bytes)
-        if ( ( iDataLen - iPos ) < 12 )
-        {
-            return true; // return error code
-        }
-
-        // channel ID (1 byte)
-        const int iChanID =
-            static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
-
-        // country (2 bytes)
-        const QLocale::Country eCountry =
-            static_cast<QLocale::Country> ( GetValFromStream ( vecData, iPos, 2 ) );
-
-        // instrument (4 bytes)
-        const int iInstrument =
-            static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
-
-        // skill level (1 byte)
-        const ESkillLevel eSkillLevel =
-            static_cast<ESkillLevel> ( GetValFromStream ( vecData, iPos, 1 ) );
-
-        // IP address (4 bytes)
-        const int iIpAddr =
-            static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
-
-        // name
-        QString strCurName;
-        if ( GetStringFromStream ( vecData,
-                                   iPos,
-                                   MAX_LEN_FADER_TAG,
-                                   strCurName ) )
-        {
-            return true; // return error code
-        }
+        CChannelInfo CurChanInfo;
 
-        // city
-        QString strCurCity;
-        if ( GetStringFromStream ( vecData,
-                                   iPos,
-                                   MAX_LEN_SERVER_CITY,
-                                   strCurCity ) )
+        if ( GetConClientListEntry ( MessReader, CurChanInfo ) )
         {
             return true; // return error code
         }
 
         // add channel information to vector
-        vecChanInfo.Add ( CChannelInfo ( iChanID,
-                                         iIpAddr,
-                                         strCurName,
-                                         eCountry,
-                                         strCurCity,
-                                         iInstrument,
-                                         eSkillLevel ) );
+        vecChanInfo.Add ( CurChanInfo );
     }
 
     // check size: all data is read, the position must now be at the end
-    if ( iPos != iDataLen )
+    if ( MessReader.GetPos() != iDataLen )
     {
         return true; // return error code
     }
 
+    // we got the complete list without a version, a following delta message
+    // can only be applied if it contains the complete list, too
+    vecConClientList.Init ( vecChanInfo.Size() );
+    vecConClientList      = vecChanInfo;
+    iConClientListVersion = INVALID_CONN_CLIENTS_LIST_VERSION;
+
     // invoke message action
     emit ConClientListMesReceived ( vecChanInfo );
 
     return false; // no error
 }
 
-void CProtocol::CreateReqConnClientsList()
-{
-    CreateAndSendMessage ( PROTMESSID_REQ_CONN_CLIENTS_LIST, CVector<uint8_t> ( 0 ) );
-}
-
-bool CProtocol::EvaluateReqConnClientsList()
+void CProtocol::CreateConClientListDeltaMes ( const int                    iBaseVersion,
+                                              const int                    iNewVersion,
+                                              const CVector<CChannelInfo>& vecChangedChanInfo,
+                                              const CVector<int>&          vecRemovedChanIDs )
 {
-    // invoke message action
-    emit ReqConnClientsList();
-
-    return false; // no error
-}
+    const int iNumChanged = vecChangedChanInfo.Size();
+    const int iNumRemoved = vecRemovedChanIDs.Size();
+
+    // convert strings to utf-8 and calculate the size of the message body so
+    // that the message can be allocated at once
+    CVector<QByteArray> vecstrUTF8Name ( iNumChanged );
+    CVector<QByteArray> vecstrUTF8City ( iNumChanged );
+    int                 iEntrLen =
+        2 /* base version */ + 2 /* new version */ +
+        1 /* number of removed */ + iNumRemoved /* chan IDs */;
+
+    for ( int i = 0; i < iNumChanged; i++ )
+    {
+        vecstrUTF8Name[i] = vecChangedChanInfo[i].strName.toUtf8();
+        vecstrUTF8City[i] = vecChangedChanInfo[i].strCity.toUtf8();
 
-void CProtocol::CreateChanNameMes ( const QString strName )
-{
-    int iPos = 0; // init position pointer
+        // size of current list entry
+        iEntrLen += GetConClientListEntrLen ( vecstrUTF8Name[i],
+                                              vecstrUTF8City[i] );
+    }
 
-    // convert name string to utf-8
-    const QByteArray strUTF8Name = strName.toUtf8();
+    // build data vector (the body is directly written in the message)
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, iEntrLen );
 
-    const int iStrUTF8Len = strUTF8Name.size(); // get utf-8 string size
+    // list versions (2 bytes each)
+    MessWriter.PutVal ( static_cast<uint32_t> ( iBaseVersion ), 2 );
+    MessWriter.PutVal ( static_cast<uint32_t> ( iNewVersion ), 2 );
 
-    // size of current list entry
-    const int iEntrLen = 2 /* utf-8 string size */ + iStrUTF8Len;
+    // removed channel IDs (1 byte number and 1 byte per channel ID)
+    MessWriter.PutVal ( static_cast<uint32_t> ( iNumRemoved ), 1 );
 
-    // build data vector
-    CVector<uint8_t> vecData ( iEntrLen );
+    for ( int i = 0; i < iNumRemoved; i++ )
+    {
+        MessWriter.PutVal ( static_cast<uint32_t> ( vecRemovedChanIDs[i] ), 1 );
+    }
 
-    // name string
-    PutStringUTF8OnStream ( vecData, iPos, strUTF8Name );
+    // added or changed channels
+    for ( int i = 0; i < iNumChanged; i++ )
+    {
+        PutConClientListEntry ( MessWriter,
+                                vecChangedChanInfo[i],
+                                vecstrUTF8Name[i],
+                                vecstrUTF8City[i] );
+    }
 
-    CreateAndSendMessage ( PROTMESSID_CHANNEL_NAME, vecData );
+    CreateAndSendMessage ( PROTMESSID_CONN_CLIENTS_LIST_DELTA, vecMessage );
 }
 
-bool CProtocol::EvaluateChanNameMes ( const CVector<uint8_t>& vecData )
+bool CProtocol::EvaluateConClientListDeltaMes ( const CVector<uint8_t>& vecData )
 {
-    int iPos = 0; // init position pointer
+    const int             iDataLen = vecData.Size();
+    CVector<CChannelInfo> vecChangedChanInfo ( 0 );
+    CVector<int>          vecRemovedChanIDs ( 0 );
+    CMessReader           MessReader ( vecData );
 
-    // channel name
-    QString strName;
-    if ( GetStringFromStream ( vecData,
-                               iPos,
-                               MAX_LEN_FADER_TAG,
-                               strName ) )
+    // check size (versions and number of removed channels)
+    if ( iDataLen < 5 )
     {
         return true; // return error code
     }
 
-    // check size: all data is read, the position must now be at the end
-    if ( iPos != vecData.Size() )
+    // list versions (2 bytes each)
+    const int iBaseVersion = static_cast<int> ( MessReader.GetVal ( 2 ) );
+    const int iNewVersion  = static_cast<int> ( MessReader.GetVal ( 2 ) );
+
+    // removed channel IDs (1 byte number and 1 byte per channel ID)
+    const int iNumRemoved = static_cast<int> ( MessReader.GetVal ( 1 ) );
+
+    if ( MessReader.GetRemaining() < iNumRemoved )
     {
         return true; // return error code
     }
 
-    // invoke message action
-    emit ChangeChanName ( strName );
+    for ( int i = 0; i < iNumRemoved; i++ )
+    {
+        vecRemovedChanIDs.Add ( static_cast<int> ( MessReader.GetVal ( 1 ) ) );
+    }
 
-    return false; // no error
-}
+    // added or changed channels
+    while ( MessReader.GetRemaining() > 0 )
+    {
+        CChannelInfo CurChanInfo;
 
-void CProtocol::CreateChanInfoMes ( const CChannelCoreInfo ChanInfo )
-{
-    int iPos = 0; // init position pointer
+        if ( GetConClientListEntry ( MessReader, CurChanInfo ) )
+        {
+            return true; // return error code
+        }
 
-    // convert strings to utf-8
-    const QByteArray strUTF8Name = ChanInfo.strName.toUtf8();
-    const QByteArray strUTF8City = ChanInfo.strCity.toUtf8();
+        vecChangedChanInfo.Add ( CurChanInfo );
+    }
 
-    // size of current list entry
-    const int iEntrLen =
-        2 /* country */ +
-        4 /* instrument */ + 1 /* skill level */ +
-        2 /* utf-8 str. size */ + strUTF8Name.size() +
-        2 /* utf-8 str. size */ + strUTF8City.size();
+    // check size: all data is read, the position must now be at the end
+    if ( MessReader.GetPos() != iDataLen )
+    {
+        return true; // return error code
+    }
 
-    // build data vector
-    CVector<uint8_t> vecData ( iEntrLen );
+    if ( iBaseVersion == FULL_CONN_CLIENTS_LIST_VERSION )
+    {
+        // the message contains the complete list
+        vecConClientList.Init ( vecChangedChanInfo.Size() );
+        vecConClientList = vecChangedChanInfo;
+    }
+    else if ( iBaseVersion == iConClientListVersion )
+    {
+        // apply the changes on our current list, first copy all entries
+        // which are not removed
+        CVector<CChannelInfo> vecNewConClientList ( 0 );
 
-    // country (2 bytes)
-    PutValOnStream ( vecData, iPos,
-        static_cast<uint32_t> ( ChanInfo.eCountry ), 2 );
+        for ( int j = 0; j < vecConClientList.Size(); j++ )
+        {
+            bool bIsRemoved = false;
 
-    // instrument (4 bytes)
-    PutValOnStream ( vecData, iPos,
-        static_cast<uint32_t> ( ChanInfo.iInstrument ), 4 );
+            for ( int i = 0; i < iNumRemoved; i++ )
+            {
+                if ( vecConClientList[j].iChanID == vecRemovedChanIDs[i] )
+                {
+                    bIsRemoved = true;
+                }
+            }
 
-    // skill level (1 byte)
-    PutValOnStream ( vecData, iPos,
-        static_cast<uint32_t> ( ChanInfo.eSkillLevel ), 1 );
+            if ( !bIsRemoved )
+            {
+                vecNewConClientList.Add ( vecConClientList[j] );
+            }
+        }
+
+        vecConClientList.Init ( vecNewConClientList.Size() );
+        vecConClientList = vecNewConClientList;
+
+        for ( int i = 0; i < vecChangedChanInfo.Size(); i++ )
+        {
+            bool bFound = false;
+
+            for ( int j = 0; j < vecConClientList.Size(); j++ )
+            {
+                if ( vecConClientList[j].iChanID == vecChangedChanInfo[i].iChanID )
+                {
+                    vecConClientList[j] = vecChangedChanInfo[i];
+                    bFound              = true;
+                    break;
+                }
+            }
+
+            if ( !bFound )
+            {
+                vecConClientList.Add ( vecChangedChanInfo[i] );
+            }
+        }
+    }
+    else
+    {
+        // we missed a change (or we never got the complete list), request the
+        // complete list which is sent as a delta message based on no version
+        iConClientListVersion = INVALID_CONN_CLIENTS_LIST_VERSION;
+
+        CreateReqConnClientsList();
+
+        return false; // no error
+    }
+
+    iConClientListVersion = iNewVersion;
+
+    // invoke message action (the receiver always gets the complete list)
+    emit ConClientListMesReceived ( vecConClientList );
+
+    return false; // no error
+}
+
+void CProtocol::CreateLocalMonitoringMes ( const bool bEnabled )
+{
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, 1 ); // 1 byte of data
+
+    // build data vector
+    MessWriter.PutVal ( static_cast<uint32_t> ( bEnabled ? 1 : 0 ), 1 );
+
+    CreateAndSendMessage ( PROTMESSID_LOCAL_MONITORING, vecMessage );
+}
+
+bool CProtocol::EvaluateLocalMonitoringMes ( const CVector<uint8_t>& vecData )
+{
+    CMessReader MessReader ( vecData );
+
+    // check size
+    if ( vecData.Size() != 1 )
+    {
+        return true; // return error code
+    }
+
+    // extract enabled flag
+    const int iData =
+        static_cast<int> ( MessReader.GetVal ( 1 ) );
+
+    if ( iData > 1 )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit LocalMonitoringChanged ( iData == 1 );
+
+    return false; // no error
+}
+
+int CProtocol::GetConClientListEntrLen ( const QByteArray& strUTF8Name,
+                                         const QByteArray& strUTF8City )
+{
+    return 1 /* chan ID */ + 2 /* country */ +
+           4 /* instrument */ + 1 /* skill level */ +
+           4 /* IP address */ +
+           2 /* utf-8 str. size */ + strUTF8Name.size() +
+           2 /* utf-8 str. size */ + strUTF8City.size();
+}
+
+void CProtocol::PutConClientListEntry ( CMessWriter&        MessWriter,
+                                        const CChannelInfo& ChanInfo,
+                                        const QByteArray&   strUTF8Name,
+                                        const QByteArray&   strUTF8City )
+{
+    // channel ID (1 byte)
+    MessWriter.PutVal (
+        static_cast<uint32_t> ( ChanInfo.iChanID ), 1 );
+
+    // country (2 bytes)
+    MessWriter.PutVal (
+        static_cast<uint32_t> ( ChanInfo.eCountry ), 2 );
+
+    // instrument (4 bytes)
+    MessWriter.PutVal (
+        static_cast<uint32_t> ( ChanInfo.iInstrument ), 4 );
+
+    // skill level (1 byte)
+    MessWriter.PutVal (
+        static_cast<uint32_t> ( ChanInfo.eSkillLevel ), 1 );
+
+    // IP address (4 bytes)
+    MessWriter.PutVal (
+        static_cast<uint32_t> ( ChanInfo.iIpAddr ), 4 );
+
+    // name
+    MessWriter.PutStringUTF8 ( strUTF8Name );
+
+    // city
+    MessWriter.PutStringUTF8 ( strUTF8City );
+}
+
+bool CProtocol::GetConClientListEntry ( CMessReader&  MessReader,
+                                        CChannelInfo& ChanInfo )
+{
+/*
+    return code: false -> ok; true -> error
+*/
+    // check size (the next 12 bytes)
+    if ( MessReader.GetRemaining() < 12 )
+    {
+        return true; // return error code
+    }
+
+    // channel ID (1 byte)
+    const int iChanID =
+        static_cast<int> ( MessReader.GetVal ( 1 ) );
+
+    // country (2 bytes)
+    const QLocale::Country eCountry =
+        static_cast<QLocale::Country> ( MessReader.GetVal ( 2 ) );
+
+    // instrument (4 bytes)
+    const int iInstrument =
+        static_cast<int> ( MessReader.GetVal ( 4 ) );
+
+    // skill level (1 byte)
+    const ESkillLevel eSkillLevel =
+        static_cast<ESkillLevel> ( MessReader.GetVal ( 1 ) );
+
+    // IP address (4 bytes)
+    const int iIpAddr =
+        static_cast<int> ( MessReader.GetVal ( 4 ) );
+
+    // name
+    QString strCurName;
+    if ( MessReader.GetString ( MAX_LEN_FADER_TAG, strCurName ) )
+    {
+        return true; // return error code
+    }
+
+    // city
+    QString strCurCity;
+    if ( MessReader.GetString ( MAX_LEN_SERVER_CITY, strCurCity ) )
+    {
+        return true; // return error code
+    }
+
+    ChanInfo = CChannelInfo ( iChanID,
+                              iIpAddr,
+                              strCurName,
+                              eCountry,
+                              strCurCity,
+                              iInstrument,
+                              eSkillLevel );
+
+    return false; // no error
+}
+
+void CProtocol::CreateReqConnClientsList()
+{
+    CreateAndSendMessage ( PROTMESSID_REQ_CONN_CLIENTS_LIST );
+}
+
+bool CProtocol::EvaluateReqConnClientsList()
+{
+    // invoke message action
+    emit ReqConnClientsList();
+
+    return false; // no error
+}
+
+void CProtocol::CreateChanNameMes ( const QString strName )
+{
+    // convert name string to utf-8
+    const QByteArray strUTF8Name = strName.toUtf8();
+
+    const int iStrUTF8Len = strUTF8Name.size(); // get utf-8 string size
+
+    // size of current list entry
+    const int iEntrLen = 2 /* utf-8 string size */ + iStrUTF8Len;
+
+    // build data vector (the body is directly written in the message)
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, iEntrLen );
+
+    // name string
+    MessWriter.PutStringUTF8 ( strUTF8Name );
+
+    CreateAndSendMessage ( PROTMESSID_CHANNEL_NAME, vecMessage );
+}
+
+bool CProtocol::EvaluateChanNameMes ( const CVector<uint8_t>& vecData )
+{
+    CMessReader MessReader ( vecData );
+
+    // channel name
+    QString strName;
+    if ( MessReader.GetString ( MAX_LEN_FADER_TAG, strName ) )
+    {
+        return true; // return error code
+    }
+
+    // check size: all data is read, the position must now be at the end
+    if ( MessReader.GetPos() != vecData.Size() )
+    {
+        return true; // return error code
+    }
+
+    // invoke message action
+    emit ChangeChanName ( strName );
+
+    return false; // no error
+}
+
+void CProtocol::CreateChanInfoMes ( const CChannelCoreInfo ChanInfo )
+{
+    // convert strings to utf-8
+    const QByteArray strUTF8Name = ChanInfo.strName.toUtf8();
+    const QByteArray strUTF8City = ChanInfo.strCity.toUtf8();
+
+    // size of current list entry
+    const int iEntrLen =
+        2 /* country */ +
+        4 /* instrument */ + 1 /* skill level */ +
+        2 /* utf-8 str. size */ + strUTF8Name.size() +
+        2 /* utf-8 str. size */ + strUTF8City.size();
+
+    // build data vector (the body is directly written in the message)
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, iEntrLen );
+
+    // country (2 bytes)
+    MessWriter.PutVal (
+        static_cast<uint32_t> ( ChanInfo.eCountry ), 2 );
+
+    // instrument (4 bytes)
+    MessWriter.PutVal (
+        static_cast<uint32_t> ( ChanInfo.iInstrument ), 4 );
+
+    // skill level (1 byte)
+    MessWriter.PutVal (
+        static_cast<uint32_t> ( ChanInfo.eSkillLevel ), 1 );
 
     // name
-    PutStringUTF8OnStream ( vecData, iPos, strUTF8Name );
+    MessWriter.PutStringUTF8 ( strUTF8Name );
 
     // city
-    PutStringUTF8OnStream ( vecData, iPos, strUTF8City );
+    MessWriter.PutStringUTF8 ( strUTF8City );
 
-    CreateAndSendMessage ( PROTMESSID_CHANNEL_INFOS, vecData );
+    CreateAndSendMessage ( PROTMESSID_CHANNEL_INFOS, vecMessage );
 }
 
 bool CProtocol::EvaluateChanInfoMes ( const CVector<uint8_t>& vecData )
 {
-    int              iPos     = 0; // init position pointer
     const int        iDataLen = vecData.Size();
     CChannelCoreInfo ChanInfo;
+    CMessReader      MessReader ( vecData );
 
     // check size (the first 7 bytes)
     if ( iDataLen < 7 )
@@ -1082,36 +2087,30 @@ bool CProtocol::EvaluateChanInfoMes ( const CVector<uint8_t>& vecData )
 
     // country (2 bytes)
     ChanInfo.eCountry =
-        static_cast<QLocale::Country> ( GetValFromStream ( vecData, iPos, 2 ) );
+        static_cast<QLocale::Country> ( MessReader.GetVal ( 2 ) );
 
     // instrument (4 bytes)
     ChanInfo.iInstrument =
-        static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
+        static_cast<int> ( MessReader.GetVal ( 4 ) );
 
     // skill level (1 byte)
     ChanInfo.eSkillLevel =
-        static_cast<ESkillLevel> ( GetValFromStream ( vecData, iPos, 1 ) );
+        static_cast<ESkillLevel> ( MessReader.GetVal ( 1 ) );
 
     // name
-    if ( GetStringFromStream ( vecData,
-                               iPos,
-                               MAX_LEN_FADER_TAG,
-                               ChanInfo.strName ) )
+    if ( MessReader.GetString ( MAX_LEN_FADER_TAG, ChanInfo.strName ) )
     {
         return true; // return error code
     }
 
     // city
-    if ( GetStringFromStream ( vecData,
-                               iPos,
-                               MAX_LEN_SERVER_CITY,
-                               ChanInfo.strCity ) )
+    if ( MessReader.GetString ( MAX_LEN_SERVER_CITY, ChanInfo.strCity ) )
     {
         return true; // return error code
     }
 
     // check size: all data is read, the position must now be at the end
-    if ( iPos != iDataLen )
+    if ( MessReader.GetPos() != iDataLen )
     {
         return true; // return error code
     }
@@ -1124,7 +2123,7 @@ bool CProtocol::EvaluateChanInfoMes ( const CVector<uint8_t>& vecData )
 
 void CProtocol::CreateReqChanInfoMes()
 {
-    CreateAndSendMessage ( PROTMESSID_REQ_CHANNEL_INFOS, CVector<uint8_t> ( 0 ) );
+    CreateAndSendMessage ( PROTMESSID_REQ_CHANNEL_INFOS );
 }
 
 bool CProtocol::EvaluateReqChanInfoMes()
@@ -1137,8 +2136,6 @@ bool CProtocol::EvaluateReqChanInfoMes()
 
 void CProtocol::CreateChatTextMes ( const QString strChatText )
 {
-    int iPos = 0; // init position pointer
-
     // convert chat text string to utf-8
     const QByteArray strUTF8ChatText = strChatText.toUtf8();
 
@@ -1147,31 +2144,43 @@ void CProtocol::CreateChatTextMes ( const QString strChatText )
     // size of message body
     const int iEntrLen = 2 /* utf-8 string size */ + iStrUTF8Len;
 
-    // build data vector
-    CVector<uint8_t> vecData ( iEntrLen );
+    // build data vector (the body is directly written in the message)
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, iEntrLen );
 
     // chat text
-    PutStringUTF8OnStream ( vecData, iPos, strUTF8ChatText );
+    MessWriter.PutStringUTF8 ( strUTF8ChatText );
+
+    CreateAndSendMessage ( PROTMESSID_CHAT_TEXT, vecMessage );
+}
+
+void CProtocol::PrepareChatTextBroadcastMes ( CBroadcastMessage& BroadcastMes,
+                                              const QString      strChatText )
+{
+    // same body as in CreateChatTextMes
+    const QByteArray strUTF8ChatText = strChatText.toUtf8();
+
+    CMessWriter MessWriter ( BroadcastMes.vecMessage,
+                             2 /* utf-8 string size */ + strUTF8ChatText.size() );
 
-    CreateAndSendMessage ( PROTMESSID_CHAT_TEXT, vecData );
+    MessWriter.PutStringUTF8 ( strUTF8ChatText );
+
+    PrepareBroadcastMes ( BroadcastMes, PROTMESSID_CHAT_TEXT );
 }
 
 bool CProtocol::EvaluateChatTextMes ( const CVector<uint8_t>& vecData )
 {
-    int iPos = 0; // init position pointer
+    CMessReader MessReader ( vecData );
 
     // chat text
     QString strChatText;
-    if ( GetStringFromStream ( vecData,
-                               iPos,
-                               MAX_LEN_CHAT_TEXT_PLUS_HTML,
-                               strChatText ) )
+    if ( MessReader.GetString ( MAX_LEN_CHAT_TEXT_PLUS_HTML, strChatText ) )
     {
         return true; // return error code
     }
 
     // check size: all data is read, the position must now be at the end
-    if ( iPos != vecData.Size() )
+    if ( MessReader.GetPos() != vecData.Size() )
     {
         return true; // return error code
     }
@@ -1184,8 +2193,6 @@ bool CProtocol::EvaluateChatTextMes ( const CVector<uint8_t>& vecData )
 
 void CProtocol::CreateNetwTranspPropsMes ( const CNetworkTransportProps& NetTrProps )
 {
-    int iPos = 0; // init position pointer
-
     // size of current message body
     const int iEntrLen =
         4 /* netw size */ +
@@ -1196,44 +2203,45 @@ void CProtocol::CreateNetwTranspPropsMes ( const CNetworkTransportProps& NetTrPr
         2 /* version */ +
         4 /* audiocod arg */;
 
-    // build data vector
-    CVector<uint8_t> vecData ( iEntrLen );
+    // build data vector (the body is directly written in the message)
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, iEntrLen );
 
     // length of the base network packet (frame) in bytes (4 bytes)
-    PutValOnStream ( vecData, iPos,
+    MessWriter.PutVal (
         static_cast<uint32_t> ( NetTrProps.iBaseNetworkPacketSize ), 4 );
 
     // block size factor (2 bytes)
-    PutValOnStream ( vecData, iPos,
+    MessWriter.PutVal (
         static_cast<uint32_t> ( NetTrProps.iBlockSizeFact ), 2 );
 
     // number of channels of the audio signal, e.g. "2" is stereo (1 byte)
-    PutValOnStream ( vecData, iPos,
+    MessWriter.PutVal (
         static_cast<uint32_t> ( NetTrProps.iNumAudioChannels ), 1 );
 
     // sample rate of the audio stream (4 bytes)
-    PutValOnStream ( vecData, iPos,
+    MessWriter.PutVal (
         static_cast<uint32_t> ( NetTrProps.iSampleRate ), 4 );
 
     // audio coding type (2 bytes)
-    PutValOnStream ( vecData, iPos,
+    MessWriter.PutVal (
         static_cast<uint32_t> ( NetTrProps.eAudioCodingType ), 2 );
 
     // version (2 bytes)
-    PutValOnStream ( vecData, iPos,
+    MessWriter.PutVal (
         static_cast<uint32_t> ( NetTrProps.iVersion ), 2 );
 
     // argument for the audio coder (4 bytes)
-    PutValOnStream ( vecData, iPos,
+    MessWriter.PutVal (
         static_cast<uint32_t> ( NetTrProps.iAudioCodingArg ), 4 );
 
-    CreateAndSendMessage ( PROTMESSID_NETW_TRANSPORT_PROPS, vecData );
+    CreateAndSendMessage ( PROTMESSID_NETW_TRANSPORT_PROPS, vecMessage );
 }
 
 bool CProtocol::EvaluateNetwTranspPropsMes ( const CVector<uint8_t>& vecData )
 {
-    int                    iPos = 0; // init position pointer
     CNetworkTransportProps ReceivedNetwTranspProps;
+    CMessReader            MessReader ( vecData );
 
     // size of current message body
     const int iEntrLen =
@@ -1253,7 +2261,7 @@ bool CProtocol::EvaluateNetwTranspPropsMes ( const CVector<uint8_t>& vecData )
 
     // length of the base network packet (frame) in bytes (4 bytes)
     ReceivedNetwTranspProps.iBaseNetworkPacketSize =
-        static_cast<uint32_t> ( GetValFromStream ( vecData, iPos, 4 ) );
+        static_cast<uint32_t> ( MessReader.GetVal ( 4 ) );
 
     // at least CELT_MINIMUM_NUM_BYTES bytes are required for the CELC codec
     if ( ( ReceivedNetwTranspProps.iBaseNetworkPacketSize < CELT_MINIMUM_NUM_BYTES ) ||
@@ -1264,7 +2272,7 @@ bool CProtocol::EvaluateNetwTranspPropsMes ( const CVector<uint8_t>& vecData )
 
     // block size factor (2 bytes)
     ReceivedNetwTranspProps.iBlockSizeFact =
-        static_cast<uint16_t> ( GetValFromStream ( vecData, iPos, 2 ) );
+        static_cast<uint16_t> ( MessReader.GetVal ( 2 ) );
 
     if ( ( ReceivedNetwTranspProps.iBlockSizeFact != FRAME_SIZE_FACTOR_PREFERRED ) &&
          ( ReceivedNetwTranspProps.iBlockSizeFact != FRAME_SIZE_FACTOR_DEFAULT ) &&
@@ -1276,7 +2284,7 @@ bool CProtocol::EvaluateNetwTranspPropsMes ( const CVector<uint8_t>& vecData )
     // number of channels of the audio signal, only mono (1 channel) or
     // stereo (2 channels) allowed (1 byte)
     ReceivedNetwTranspProps.iNumAudioChannels =
-        static_cast<uint32_t> ( GetValFromStream ( vecData, iPos, 1 ) );
+        static_cast<uint32_t> ( MessReader.GetVal ( 1 ) );
 
     if ( ( ReceivedNetwTranspProps.iNumAudioChannels != 1 ) &&
          ( ReceivedNetwTranspProps.iNumAudioChannels != 2 ) )
@@ -1286,11 +2294,11 @@ bool CProtocol::EvaluateNetwTranspPropsMes ( const CVector<uint8_t>& vecData )
 
     // sample rate of the audio stream (4 bytes)
     ReceivedNetwTranspProps.iSampleRate =
-        static_cast<uint32_t> ( GetValFromStream ( vecData, iPos, 4 ) );
+        static_cast<uint32_t> ( MessReader.GetVal ( 4 ) );
 
     // audio coding type (2 bytes) with error check
     const int iRecCodingType =
-        static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+        static_cast<int> ( MessReader.GetVal ( 2 ) );
 
     if ( ( iRecCodingType != CT_NONE ) &&
          ( iRecCodingType != CT_CELT ) &&
@@ -1304,11 +2312,11 @@ bool CProtocol::EvaluateNetwTranspPropsMes ( const CVector<uint8_t>& vecData )
 
     // version (2 bytes)
     ReceivedNetwTranspProps.iVersion =
-        static_cast<uint32_t> ( GetValFromStream ( vecData, iPos, 2 ) );
+        static_cast<uint32_t> ( MessReader.GetVal ( 2 ) );
 
     // argument for the audio coder (4 bytes)
     ReceivedNetwTranspProps.iAudioCodingArg =
-        static_cast<int32_t> ( GetValFromStream ( vecData, iPos, 4 ) );
+        static_cast<int32_t> ( MessReader.GetVal ( 4 ) );
 
     // invoke message action
     emit NetTranspPropsReceived ( ReceivedNetwTranspProps );
@@ -1318,8 +2326,7 @@ bool CProtocol::EvaluateNetwTranspPropsMes ( const CVector<uint8_t>& vecData )
 
 void CProtocol::CreateReqNetwTranspPropsMes()
 {
-    CreateAndSendMessage ( PROTMESSID_REQ_NETW_TRANSPORT_PROPS,
-                           CVector<uint8_t> ( 0 ) );
+    CreateAndSendMessage ( PROTMESSID_REQ_NETW_TRANSPORT_PROPS );
 }
 
 bool CProtocol::EvaluateReqNetwTranspPropsMes()
@@ -1332,8 +2339,7 @@ bool CProtocol::EvaluateReqNetwTranspPropsMes()
 
 void CProtocol::CreateOpusSupportedMes()
 {
-    CreateAndSendMessage ( PROTMESSID_OPUS_SUPPORTED,
-                           CVector<uint8_t> ( 0 ) );
+    CreateAndSendMessage ( PROTMESSID_OPUS_SUPPORTED );
 }
 
 bool CProtocol::EvaluateOpusSupportedMes()
@@ -1344,27 +2350,103 @@ bool CProtocol::EvaluateOpusSupportedMes()
     return false; // no error
 }
 
+void CProtocol::CreateProtFeaturesMes()
+{
+    int iCurSessionID;
+
+    Mutex.lock();
+    {
+        iCurSessionID     = iSessionID;
+        bProtFeaturesAckn = false;
+    }
+    Mutex.unlock();
+
+    // build data vector (6 bytes long)
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, 6 );
+
+    // session ID (2 bytes)
+    MessWriter.PutVal ( static_cast<uint32_t> ( iCurSessionID ), 2 );
+
+    // feature flags (4 bytes)
+    MessWriter.PutVal ( static_cast<uint32_t> ( PROT_FEATURES_OWN ), 4 );
+
+    CreateAndSendMessage ( PROTMESSID_PROTOCOL_FEATURES, vecMessage );
+}
+
+bool CProtocol::EvaluateProtFeaturesMes ( const CVector<uint8_t>& vecData,
+                                          const int               iRecCounter )
+{
+    CMessReader MessReader ( vecData );
+
+    // check size (future versions may append data)
+    if ( vecData.Size() < 6 )
+    {
+        return true; // return error code
+    }
+
+    // session ID (2 bytes)
+    const int iRecSessionID = static_cast<int> ( MessReader.GetVal ( 2 ) );
+
+    // feature flags (4 bytes)
+    const int iRecFeatures = static_cast<int> ( MessReader.GetVal ( 4 ) );
+
+    bool bResendProtFeatures = false;
+
+    Mutex.lock();
+    {
+        if ( iRecSessionID != iPeerSessionID )
+        {
+            // The other side was reset (or this is the first message of the
+            // other side): synchronize to its counter and drop everything we
+            // received before. If the other side was reset, it does not know
+            // our features anymore.
+            bResendProtFeatures = ( iPeerSessionID >= 0 ) && bProtFeaturesSent;
+
+            iPeerSessionID = iRecSessionID;
+            iNextExpRecCnt = ( iRecCounter + 1 ) & 255;
+
+            for ( int i = 0; i < vecRecMessBuf.Size(); i++ )
+            {
+                vecRecMessBuf[i].bIsValid = false;
+            }
+        }
+
+        iPeerFeatures = iRecFeatures;
+    }
+    Mutex.unlock();
+
+    if ( bResendProtFeatures )
+    {
+        CreateProtFeaturesMes();
+    }
+
+    // the features of the other side are known now
+    emit ProtFeaturesReceived();
+
+    return false; // no error
+}
+
 
 // Connection less messages ----------------------------------------------------
 void CProtocol::CreateCLPingMes ( const CHostAddress& InetAddr, const int iMs )
 {
-    int iPos = 0; // init position pointer
-
     // build data vector (4 bytes long)
-    CVector<uint8_t> vecData ( 4 );
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, 4 );
 
     // transmit time (4 bytes)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iMs ), 4 );
+    MessWriter.PutVal ( static_cast<uint32_t> ( iMs ), 4 );
 
     CreateAndImmSendConLessMessage ( PROTMESSID_CLM_PING_MS,
-                                     vecData,
+                                     vecMessage,
                                      InetAddr );
 }
 
 bool CProtocol::EvaluateCLPingMes ( const CHostAddress& InetAddr,
                                     const CVector<uint8_t>& vecData )
 {
-    int iPos = 0; // init position pointer
+    CMessReader MessReader ( vecData );
 
     // check size
     if ( vecData.Size() != 4 )
@@ -1374,7 +2456,7 @@ bool CProtocol::EvaluateCLPingMes ( const CHostAddress& InetAddr,
 
     // invoke message action
     emit CLPingReceived ( InetAddr,
-                          static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) ) );
+                          static_cast<int> ( MessReader.GetVal ( 4 ) ) );
 
     return false; // no error
 }
@@ -1383,26 +2465,25 @@ void CProtocol::CreateCLPingWithNumClientsMes ( const CHostAddress& InetAddr,
                                                 const int           iMs,
                                                 const int           iNumClients )
 {
-    int iPos = 0; // init position pointer
-
     // build data vector (5 bytes long)
-    CVector<uint8_t> vecData ( 5 );
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, 5 );
 
     // transmit time (4 bytes)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iMs ), 4 );
+    MessWriter.PutVal ( static_cast<uint32_t> ( iMs ), 4 );
 
     // current number of connected clients (1 byte)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( iNumClients ), 1 );
+    MessWriter.PutVal ( static_cast<uint32_t> ( iNumClients ), 1 );
 
     CreateAndImmSendConLessMessage ( PROTMESSID_CLM_PING_MS_WITHNUMCLIENTS,
-                                     vecData,
+                                     vecMessage,
                                      InetAddr );
 }
 
 bool CProtocol::EvaluateCLPingWithNumClientsMes ( const CHostAddress&     InetAddr,
                                                   const CVector<uint8_t>& vecData )
 {
-    int iPos = 0; // init position pointer
+    CMessReader MessReader ( vecData );
 
     // check size
     if ( vecData.Size() != 5 )
@@ -1412,11 +2493,11 @@ bool CProtocol::EvaluateCLPingWithNumClientsMes ( const CHostAddress&     InetAd
 
     // transmit time
     const int iCurMs =
-        static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
+        static_cast<int> ( MessReader.GetVal ( 4 ) );
 
     // current number of connected clients
     const int iCurNumClients =
-        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+        static_cast<int> ( MessReader.GetVal ( 1 ) );
 
     // invoke message action
     emit CLPingWithNumClientsReceived ( InetAddr, iCurMs, iCurNumClients );
@@ -1427,7 +2508,6 @@ bool CProtocol::EvaluateCLPingWithNumClientsMes ( const CHostAddress&     InetAd
 void CProtocol::CreateCLServerFullMes ( const CHostAddress& InetAddr )
 {
     CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SERVER_FULL,
-                                     CVector<uint8_t> ( 0 ),
                                      InetAddr );
 }
 
@@ -1442,8 +2522,6 @@ bool CProtocol::EvaluateCLServerFullMes()
 void CProtocol::CreateCLRegisterServerMes ( const CHostAddress&    InetAddr,
                                             const CServerCoreInfo& ServerInfo )
 {
-    int iPos = 0; // init position pointer
-
     // convert server info strings to utf-8
     const QByteArray strUTF8Name  = ServerInfo.strName.toUtf8();
     const QByteArray strUTF8Topic = ServerInfo.strTopic.toUtf8();
@@ -1459,45 +2537,46 @@ void CProtocol::CreateCLRegisterServerMes ( const CHostAddress&    InetAddr,
         2 /* topic utf-8 string size */ + strUTF8Topic.size() +
         2 /* city utf-8 string size */ + strUTF8City.size();
 
-    // build data vector
-    CVector<uint8_t> vecData ( iEntrLen );
+    // build data vector (the body is directly written in the message)
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, iEntrLen );
 
     // port number (2 bytes)
-    PutValOnStream ( vecData, iPos,
+    MessWriter.PutVal (
         static_cast<uint32_t> ( ServerInfo.iLocalPortNumber ), 2 );
 
     // country (2 bytes)
-    PutValOnStream ( vecData, iPos,
+    MessWriter.PutVal (
         static_cast<uint32_t> ( ServerInfo.eCountry ), 2 );
 
     // maximum number of connected clients (1 byte)
-    PutValOnStream ( vecData, iPos,
+    MessWriter.PutVal (
         static_cast<uint32_t> ( ServerInfo.iMaxNumClients ), 1 );
 
     // "is permanent" flag (1 byte)
-    PutValOnStream ( vecData, iPos,
+    MessWriter.PutVal (
         static_cast<uint32_t> ( ServerInfo.bPermanentOnline ), 1 );
 
     // name
-    PutStringUTF8OnStream ( vecData, iPos, strUTF8Name );
+    MessWriter.PutStringUTF8 ( strUTF8Name );
 
     // topic
-    PutStringUTF8OnStream ( vecData, iPos, strUTF8Topic );
+    MessWriter.PutStringUTF8 ( strUTF8Topic );
 
     // city
-    PutStringUTF8OnStream ( vecData, iPos, strUTF8City );
+    MessWriter.PutStringUTF8 ( strUTF8City );
 
     CreateAndImmSendConLessMessage ( PROTMESSID_CLM_REGISTER_SERVER,
-                                     vecData,
+                                     vecMessage,
                                      InetAddr );
 }
 
 bool CProtocol::EvaluateCLRegisterServerMes ( const CHostAddress&     InetAddr,
                                               const CVector<uint8_t>& vecData )
 {
-    int             iPos     = 0; // init position pointer
     const int       iDataLen = vecData.Size();
     CServerCoreInfo RecServerInfo;
+    CMessReader     MessReader ( vecData );
 
     // check size (the first 6 bytes)
     if ( iDataLen < 6 )
@@ -1507,49 +2586,40 @@ bool CProtocol::EvaluateCLRegisterServerMes ( const CHostAddress&     InetAddr,
 
     // port number (2 bytes)
     RecServerInfo.iLocalPortNumber =
-        static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+        static_cast<int> ( MessReader.GetVal ( 2 ) );
 
     // country (2 bytes)
     RecServerInfo.eCountry =
-        static_cast<QLocale::Country> ( GetValFromStream ( vecData, iPos, 2 ) );
+        static_cast<QLocale::Country> ( MessReader.GetVal ( 2 ) );
 
     // maximum number of connected clients (1 byte)
     RecServerInfo.iMaxNumClients =
-        static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+        static_cast<int> ( MessReader.GetVal ( 1 ) );
 
     // "is permanent" flag (1 byte)
     RecServerInfo.bPermanentOnline =
-        static_cast<bool> ( GetValFromStream ( vecData, iPos, 1 ) );
+        static_cast<bool> ( MessReader.GetVal ( 1 ) );
 
     // server name
-    if ( GetStringFromStream ( vecData,
-                               iPos,
-                               MAX_LEN_SERVER_NAME,
-                               RecServerInfo.strName ) )
+    if ( MessReader.GetString ( MAX_LEN_SERVER_NAME, RecServerInfo.strName ) )
     {
         return true; // return error code
     }
 
     // server topic
-    if ( GetStringFromStream ( vecData,
-                               iPos,
-                               MAX_LEN_SERVER_TOPIC,
-                               RecServerInfo.strTopic ) )
+    if ( MessReader.GetString ( MAX_LEN_SERVER_TOPIC, RecServerInfo.strTopic ) )
     {
         return true; // return error code
     }
 
     // server city
-    if ( GetStringFromStream ( vecData,
-                               iPos,
-                               MAX_LEN_SERVER_CITY,
-                               RecServerInfo.strCity ) )
+    if ( MessReader.GetString ( MAX_LEN_SERVER_CITY, RecServerInfo.strCity ) )
     {
         return true; // return error code
     }
 
     // check size: all data is read, the position must now be at the end
-    if ( iPos != iDataLen )
+    if ( MessReader.GetPos() != iDataLen )
     {
         return true; // return error code
     }
@@ -1563,7 +2633,6 @@ bool CProtocol::EvaluateCLRegisterServerMes ( const CHostAddress&     InetAddr,
 void CProtocol::CreateCLUnregisterServerMes ( const CHostAddress& InetAddr )
 {
     CreateAndImmSendConLessMessage ( PROTMESSID_CLM_UNREGISTER_SERVER,
-                                     CVector<uint8_t> ( 0 ),
                                      InetAddr );
 }
 
@@ -1580,127 +2649,124 @@ void CProtocol::CreateCLServerListMes ( const CHostAddress&        InetAddr,
 {
     const int iNumServers = vecServerInfo.Size();
 
-    // build data vector
-    CVector<uint8_t> vecData ( 0 );
-    int              iPos = 0; // init position pointer
+    // convert server list strings to utf-8 and calculate the size of the
+    // message body so that the message can be allocated at once
+    CVector<QByteArray> vecstrUTF8Name  ( iNumServers );
+    CVector<QByteArray> vecstrUTF8Topic ( iNumServers );
+    CVector<QByteArray> vecstrUTF8City  ( iNumServers );
+    int                 iEntrLen = 0;
 
     for ( int i = 0; i < iNumServers; i++ )
     {
-        // convert server list strings to utf-8
-        const QByteArray strUTF8Name  = vecServerInfo[i].strName.toUtf8();
-        const QByteArray strUTF8Topic = vecServerInfo[i].strTopic.toUtf8();
-        const QByteArray strUTF8City  = vecServerInfo[i].strCity.toUtf8();
+        vecstrUTF8Name[i]  = vecServerInfo[i].strName.toUtf8();
+        vecstrUTF8Topic[i] = vecServerInfo[i].strTopic.toUtf8();
+        vecstrUTF8City[i]  = vecServerInfo[i].strCity.toUtf8();
 
         // size of current list entry
-        const int iCurListEntrLen =
+        iEntrLen +=
             4 /* IP address */ +
             2 /* port number */ +
             2 /* country */ +
             1 /* maximum number of connected clients */ +
             1 /* is permanent flag */ +
-            2 /* name utf-8 string size */ + strUTF8Name.size() +
-            2 /* topic utf-8 string size */ + strUTF8Topic.size() +
-            2 /* city utf-8 string size */ + strUTF8City.size();
+            2 /* name utf-8 string size */ + vecstrUTF8Name[i].size() +
+            2 /* topic utf-8 string size */ + vecstrUTF8Topic[i].size() +
+            2 /* city utf-8 string size */ + vecstrUTF8City[i].size();
+    }
 
-        // make space for new data
-        vecData.Enlarge ( iCurListEntrLen );
+    // build data vector (the body is directly written in the message)
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, iEntrLen );
 
+    for ( int i = 0; i < iNumServers; i++ )
+    {
         // IP address (4 bytes)
-        PutValOnStream ( vecData, iPos, static_cast<uint32_t> (
+        MessWriter.PutVal ( static_cast<uint32_t> (
             vecServerInfo[i].HostAddr.InetAddr.toIPv4Address() ), 4 );
 
         // port number (2 bytes)
-        PutValOnStream ( vecData, iPos,
+        MessWriter.PutVal (
             static_cast<uint32_t> ( vecServerInfo[i].HostAddr.iPort ), 2 );
 
         // country (2 bytes)
-        PutValOnStream ( vecData, iPos,
+        MessWriter.PutVal (
             static_cast<uint32_t> ( vecServerInfo[i].eCountry ), 2 );
 
         // maximum number of connected clients (1 byte)
-        PutValOnStream ( vecData, iPos,
+        MessWriter.PutVal (
             static_cast<uint32_t> ( vecServerInfo[i].iMaxNumClients ), 1 );
 
         // "is permanent" flag (1 byte)
-        PutValOnStream ( vecData, iPos,
+        MessWriter.PutVal (
             static_cast<uint32_t> ( vecServerInfo[i].bPermanentOnline ), 1 );
 
         // name
-        PutStringUTF8OnStream ( vecData, iPos, strUTF8Name );
+        MessWriter.PutStringUTF8 ( vecstrUTF8Name[i] );
 
         // topic
-        PutStringUTF8OnStream ( vecData, iPos, strUTF8Topic );
+        MessWriter.PutStringUTF8 ( vecstrUTF8Topic[i] );
 
         // city
-        PutStringUTF8OnStream ( vecData, iPos, strUTF8City );
+        MessWriter.PutStringUTF8 ( vecstrUTF8City[i] );
     }
 
     CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SERVER_LIST,
-                                     vecData,
+                                     vecMessage,
                                      InetAddr );
 }
 
 bool CProtocol::EvaluateCLServerListMes ( const CHostAddress&     InetAddr,
                                           const CVector<uint8_t>& vecData )
 {
-    int                  iPos     = 0; // init position pointer
     const int            iDataLen = vecData.Size();
     CVector<CServerInfo> vecServerInfo ( 0 );
+    CMessReader          MessReader ( vecData );
 
-    while ( iPos < iDataLen )
+    while ( MessReader.GetRemaining() > 0 )
     {
         // check size (the next 10 bytes)
-        if ( ( iDataLen - iPos ) < 10 )
+        if ( MessReader.GetRemaining() < 10 )
         {
             return true; // return error code
         }
 
         // IP address (4 bytes)
         const quint32 iIpAddr =
-            static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
+            static_cast<int> ( MessReader.GetVal ( 4 ) );
 
         // port number (2 bytes)
         const quint16 iPort =
-            static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+            static_cast<int> ( MessReader.GetVal ( 2 ) );
 
         // country (2 bytes)
         const QLocale::Country eCountry =
-            static_cast<QLocale::Country> ( GetValFromStream ( vecData, iPos, 2 ) );
+            static_cast<QLocale::Country> ( MessReader.GetVal ( 2 ) );
 
         // maximum number of connected clients (1 byte)
         const int iMaxNumClients =
-            static_cast<int> ( GetValFromStream ( vecData, iPos, 1 ) );
+            static_cast<int> ( MessReader.GetVal ( 1 ) );
 
         // "is permanent" flag (1 byte)
         const bool bPermanentOnline =
-            static_cast<bool> ( GetValFromStream ( vecData, iPos, 1 ) );
+            static_cast<bool> ( MessReader.GetVal ( 1 ) );
 
         // server name
         QString strName;
-        if ( GetStringFromStream ( vecData,
-                                   iPos,
-                                   MAX_LEN_SERVER_NAME,
-                                   strName ) )
+        if ( MessReader.GetString ( MAX_LEN_SERVER_NAME, strName ) )
         {
             return true; // return error code
         }
 
         // server topic
         QString strTopic;
-        if ( GetStringFromStream ( vecData,
-                                   iPos,
-                                   MAX_LEN_SERVER_TOPIC,
-                                   strTopic ) )
+        if ( MessReader.GetString ( MAX_LEN_SERVER_TOPIC, strTopic ) )
         {
             return true; // return error code
         }
 
         // server city
         QString strCity;
-        if ( GetStringFromStream ( vecData,
-                                   iPos,
-                                   MAX_LEN_SERVER_CITY,
-                                   strCity ) )
+        if ( MessReader.GetString ( MAX_LEN_SERVER_CITY, strCity ) )
         {
             return true; // return error code
         }
@@ -1718,7 +2784,7 @@ bool CProtocol::EvaluateCLServerListMes ( const CHostAddress&     InetAddr,
     }
 
     // check size: all data is read, the position must now be at the end
-    if ( iPos != iDataLen )
+    if ( MessReader.GetPos() != iDataLen )
     {
         return true; // return error code
     }
@@ -1729,45 +2795,449 @@ bool CProtocol::EvaluateCLServerListMes ( const CHostAddress&     InetAddr,
     return false; // no error
 }
 
-void CProtocol::CreateCLReqServerListMes ( const CHostAddress& InetAddr )
+void CProtocol::CreateCLServerListPartsMes ( const CHostAddress&        InetAddr,
+                                             const CVector<CServerInfo> vecServerInfo )
 {
-    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_REQ_SERVER_LIST,
-                                     CVector<uint8_t> ( 0 ),
-                                     InetAddr );
-}
+    const int iNumServers = vecServerInfo.Size();
 
-bool CProtocol::EvaluateCLReqServerListMes ( const CHostAddress& InetAddr )
-{
-    // invoke message action
-    emit CLReqServerList ( InetAddr );
+    // convert server list strings to utf-8
+    CVector<QByteArray> vecstrUTF8Name  ( iNumServers );
+    CVector<QByteArray> vecstrUTF8Topic ( iNumServers );
+    CVector<QByteArray> vecstrUTF8City  ( iNumServers );
 
-    return false; // no error
-}
+    for ( int i = 0; i < iNumServers; i++ )
+    {
+        vecstrUTF8Name[i]  = vecServerInfo[i].strName.toUtf8();
+        vecstrUTF8Topic[i] = vecServerInfo[i].strTopic.toUtf8();
+        vecstrUTF8City[i]  = vecServerInfo[i].strCity.toUtf8();
+    }
 
-void CProtocol::CreateCLSendEmptyMesMes ( const CHostAddress& InetAddr,
-                                          const CHostAddress& TargetInetAddr )
+    // split the list in parts which fit in one network packet (an empty list
+    // is sent as one empty part)
+    CVector<int>        veciPartFirstServer ( 0 );
+    QList<QByteArray>   StringTable;
+    int                 iPartLenBy;
+    int                 iCurServer = 0;
+
+    do
+    {
+        veciPartFirstServer.Add ( iCurServer );
+
+        iCurServer = GetCLServerListPart ( vecstrUTF8Name,
+                                           vecstrUTF8Topic,
+                                           vecstrUTF8City,
+                                           iCurServer,
+                                           StringTable,
+                                           iPartLenBy );
+    }
+    while ( ( iCurServer < iNumServers ) &&
+            ( veciPartFirstServer.Size() < MAX_NUM_SERVER_LIST_PARTS ) );
+
+    const int iNumParts = veciPartFirstServer.Size();
+
+    // all parts of this list get the same ID
+    iCLServerListSendID = ( iCLServerListSendID + 1 ) & 0xFFFF;
+
+    for ( int iPart = 0; iPart < iNumParts; iPart++ )
+    {
+        const int iFirstServer = veciPartFirstServer[iPart];
+        const int iEndServer   = GetCLServerListPart ( vecstrUTF8Name,
+                                                       vecstrUTF8Topic,
+                                                       vecstrUTF8City,
+                                                       iFirstServer,
+                                                       StringTable,
+                                                       iPartLenBy );
+
+        // build data vector (the body is directly written in the message)
+        CVector<uint8_t> vecMessage;
+        CMessWriter      MessWriter ( vecMessage, iPartLenBy );
+
+        // list ID (2 bytes)
+        MessWriter.PutVal ( static_cast<uint32_t> ( iCLServerListSendID ), 2 );
+
+        // part index and number of parts (1 byte each)
+        MessWriter.PutVal ( static_cast<uint32_t> ( iPart ), 1 );
+        MessWriter.PutVal ( static_cast<uint32_t> ( iNumParts ), 1 );
+
+        // string table
+        MessWriter.PutVal ( static_cast<uint32_t> ( StringTable.size() ), 1 );
+
+        for ( int i = 0; i < StringTable.size(); i++ )
+        {
+            MessWriter.PutStringUTF8 ( StringTable[i] );
+        }
+
+        for ( int i = iFirstServer; i < iEndServer; i++ )
+        {
+            const int iTopicIdx = StringTable.indexOf ( vecstrUTF8Topic[i] );
+            const int iCityIdx  = StringTable.indexOf ( vecstrUTF8City[i] );
+
+            // IP address (4 bytes)
+            MessWriter.PutVal ( static_cast<uint32_t> (
+                vecServerInfo[i].HostAddr.InetAddr.toIPv4Address() ), 4 );
+
+            // port number (2 bytes)
+            MessWriter.PutVal (
+                static_cast<uint32_t> ( vecServerInfo[i].HostAddr.iPort ), 2 );
+
+            // country (2 bytes)
+            MessWriter.PutVal (
+                static_cast<uint32_t> ( vecServerInfo[i].eCountry ), 2 );
+
+            // maximum number of connected clients (1 byte)
+            MessWriter.PutVal (
+                static_cast<uint32_t> ( vecServerInfo[i].iMaxNumClients ), 1 );
+
+            // flags (1 byte), empty strings are not transmitted
+            uint32_t iFlags = 0;
+
+            if ( vecServerInfo[i].bPermanentOnline )
+            {
+                iFlags |= SERVER_LIST_FLAG_PERMANENT;
+            }
+
+            if ( !vecstrUTF8Topic[i].isEmpty() )
+            {
+                iFlags |= SERVER_LIST_FLAG_TOPIC;
+            }
+
+            if ( !vecstrUTF8City[i].isEmpty() )
+            {
+                iFlags |= SERVER_LIST_FLAG_CITY;
+            }
+
+            MessWriter.PutVal ( iFlags, 1 );
+
+            // name
+            MessWriter.PutStringUTF8 ( vecstrUTF8Name[i] );
+
+            // topic and city string table indices (1 byte each)
+            if ( iFlags & SERVER_LIST_FLAG_TOPIC )
+            {
+                MessWriter.PutVal ( static_cast<uint32_t> ( iTopicIdx ), 1 );
+            }
+
+            if ( iFlags & SERVER_LIST_FLAG_CITY )
+            {
+                MessWriter.PutVal ( static_cast<uint32_t> ( iCityIdx ), 1 );
+            }
+        }
+
+        CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SERVER_LIST_PART,
+                                         vecMessage,
+                                         InetAddr );
+    }
+}
+
+int CProtocol::GetCLServerListPart ( const CVector<QByteArray>& vecstrUTF8Name,
+                                     const CVector<QByteArray>& vecstrUTF8Topic,
+                                     const CVector<QByteArray>& vecstrUTF8City,
+                                     const int                  iFirstServer,
+                                     QList<QByteArray>&         StringTable,
+                                     int&                       iPartLenBy )
+{
+/*
+    Collects the servers starting at "iFirstServer" which fit in one part,
+    returns the index of the first server which does not fit anymore. The
+    string table and the size of the message body are returned, too.
+*/
+    const int iNumServers = vecstrUTF8Name.Size();
+    int       iCurServer  = iFirstServer;
+
+    StringTable.clear();
+
+    // list ID, part index, number of parts and number of strings
+    iPartLenBy = 2 + 1 + 1 + 1;
+
+    while ( iCurServer < iNumServers )
+    {
+        const QByteArray* pStrings[2] = { &vecstrUTF8Topic.at ( iCurServer ),
+                                          &vecstrUTF8City.at ( iCurServer ) };
+
+        int iEntrLen =
+            4 /* IP address */ +
+            2 /* port number */ +
+            2 /* country */ +
+            1 /* maximum number of connected clients */ +
+            1 /* flags */ +
+            2 /* name utf-8 string size */ + vecstrUTF8Name[iCurServer].size();
+
+        int iNumNewStrings = 0;
+
+        for ( int j = 0; j < 2; j++ )
+        {
+            if ( !pStrings[j]->isEmpty() )
+            {
+                iEntrLen += 1; // string table index
+
+                // new strings are added to the string table (topic and city
+                // of one server may be the same)
+                if ( ( StringTable.indexOf ( *pStrings[j] ) < 0 ) &&
+                     ( ( j == 0 ) || ( *pStrings[0] != *pStrings[1] ) ) )
+                {
+                    iEntrLen += 2 /* utf-8 string size */ + pStrings[j]->size();
+                    iNumNewStrings++;
+                }
+            }
+        }
+
+        // check if the server still fits in the part (at least one server is
+        // put in each part)
+        if ( ( iCurServer > iFirstServer ) &&
+             ( ( MESS_LEN_WITHOUT_DATA_BYTE + iPartLenBy + iEntrLen >
+                 MAX_SIZE_SERVER_LIST_PART_BYTES ) ||
+               ( StringTable.size() + iNumNewStrings > 255 ) ) )
+        {
+            break;
+        }
+
+        for ( int j = 0; j < 2; j++ )
+        {
+            if ( !pStrings[j]->isEmpty() && ( StringTable.indexOf ( *pStrings[j] ) < 0 ) )
+            {
+                StringTable.append ( *pStrings[j] );
+            }
+        }
+
+        iPartLenBy += iEntrLen;
+        iCurServer++;
+    }
+
+    return iCurServer;
+}
+
+bool CProtocol::EvaluateCLServerListPartMes ( const CHostAddress&     InetAddr,
+                                              const CVector<uint8_t>& vecData )
+{
+    const int            iDataLen = vecData.Size();
+    CVector<CServerInfo> vecServerInfo ( 0 );
+    CMessReader          MessReader ( vecData );
+
+    // check size (header of the part)
+    if ( iDataLen < 5 )
+    {
+        return true; // return error code
+    }
+
+    // list ID (2 bytes)
+    const int iListID = static_cast<int> ( MessReader.GetVal ( 2 ) );
+
+    // part index and number of parts (1 byte each)
+    const int iPart     = static_cast<int> ( MessReader.GetVal ( 1 ) );
+    const int iNumParts = static_cast<int> ( MessReader.GetVal ( 1 ) );
+
+    if ( ( iNumParts == 0 ) || ( iPart >= iNumParts ) )
+    {
+        return true; // return error code
+    }
+
+    // string table
+    const int        iNumStrings = static_cast<int> ( MessReader.GetVal ( 1 ) );
+    CVector<QString> vecstrTable ( iNumStrings );
+
+    for ( int i = 0; i < iNumStrings; i++ )
+    {
+        // the table contains topics and cities
+        if ( MessReader.GetString ( MAX_LEN_SERVER_TOPIC, vecstrTable[i] ) )
+        {
+            return true; // return error code
+        }
+    }
+
+    while ( MessReader.GetRemaining() > 0 )
+    {
+        // check size (the next 10 bytes)
+        if ( MessReader.GetRemaining() < 10 )
+        {
+            return true; // return error code
+        }
+
+        // IP address (4 bytes)
+        const quint32 iIpAddr =
+            static_cast<int> ( MessReader.GetVal ( 4 ) );
+
+        // port number (2 bytes)
+        const quint16 iPort =
+            static_cast<int> ( MessReader.GetVal ( 2 ) );
+
+        // country (2 bytes)
+        const QLocale::Country eCountry =
+            static_cast<QLocale::Country> ( MessReader.GetVal ( 2 ) );
+
+        // maximum number of connected clients (1 byte)
+        const int iMaxNumClients =
+            static_cast<int> ( MessReader.GetVal ( 1 ) );
+
+        // flags (1 byte)
+        const int iFlags =
+            static_cast<int> ( MessReader.GetVal ( 1 ) );
+
+        // server name
+        QString strName;
+        if ( MessReader.GetString ( MAX_LEN_SERVER_NAME, strName ) )
+        {
+            return true; // return error code
+        }
+
+        // server topic and city (optional string table indices)
+        QString strTopic;
+        QString strCity;
+
+        if ( iFlags & SERVER_LIST_FLAG_TOPIC )
+        {
+            if ( MessReader.GetRemaining() < 1 )
+            {
+                return true; // return error code
+            }
+
+            const int iIdx = static_cast<int> ( MessReader.GetVal ( 1 ) );
+
+            if ( iIdx >= iNumStrings )
+            {
+                return true; // return error code
+            }
+
+            strTopic = vecstrTable[iIdx];
+        }
+
+        if ( iFlags & SERVER_LIST_FLAG_CITY )
+        {
+            if ( MessReader.GetRemaining() < 1 )
+            {
+                return true; // return error code
+            }
+
+            const int iIdx = static_cast<int> ( MessReader.GetVal ( 1 ) );
+
+            // the string table is checked for the longer topic length,
+            // therefore the city length must be checked separately
+            if ( ( iIdx >= iNumStrings ) ||
+                 ( vecstrTable[iIdx].size() > MAX_LEN_SERVER_CITY ) )
+            {
+                return true; // return error code
+            }
+
+            strCity = vecstrTable[iIdx];
+        }
+
+        // add server information to vector
+        vecServerInfo.Add (
+            CServerInfo ( CHostAddress ( QHostAddress ( iIpAddr ), iPort ),
+                          iPort,
+                          strName,
+                          strTopic,
+                          eCountry,
+                          strCity,
+                          iMaxNumClients,
+                          ( iFlags & SERVER_LIST_FLAG_PERMANENT ) != 0 ) );
+    }
+
+    // check size: all data is read, the position must now be at the end
+    if ( MessReader.GetPos() != iDataLen )
+    {
+        return true; // return error code
+    }
+
+    // reassemble the list, a new list ID or sender drops the old parts
+    if ( ( iListID != iCLServerListRecID ) ||
+         !( InetAddr == CLServerListRecAddr ) ||
+         ( iNumParts != vecvecCLServerListRecParts.Size() ) )
+    {
+        iCLServerListRecID       = iListID;
+        CLServerListRecAddr      = InetAddr;
+        iCLServerListRecNumParts = 0;
+        vecvecCLServerListRecParts.Init ( iNumParts );
+        veciCLServerListRecPartOK.Init ( iNumParts, 0 );
+    }
+
+    if ( !veciCLServerListRecPartOK[iPart] )
+    {
+        vecvecCLServerListRecParts[iPart].Init ( vecServerInfo.Size() );
+        vecvecCLServerListRecParts[iPart] = vecServerInfo;
+        veciCLServerListRecPartOK[iPart]  = 1;
+        iCLServerListRecNumParts++;
+
+        if ( iCLServerListRecNumParts == iNumParts )
+        {
+            // all parts are received, combine them in one list
+            CVector<CServerInfo> vecCompleteServerInfo ( 0 );
+
+            for ( int i = 0; i < iNumParts; i++ )
+            {
+                for ( int j = 0; j < vecvecCLServerListRecParts[i].Size(); j++ )
+                {
+                    vecCompleteServerInfo.Add ( vecvecCLServerListRecParts[i][j] );
+                }
+            }
+
+            // invalidate the list so that a duplicate part does not deliver
+            // the list again
+            vecvecCLServerListRecParts.Init ( 0 );
+            veciCLServerListRecPartOK.Init ( 0 );
+
+            // invoke message action
+            emit CLServerListReceived ( InetAddr, vecCompleteServerInfo );
+        }
+    }
+
+    return false; // no error
+}
+
+void CProtocol::CreateCLReqServerListMes ( const CHostAddress& InetAddr )
+{
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, 1 ); // 1 byte of data
+
+    // we support the server list in parts (1 byte)
+    MessWriter.PutVal ( static_cast<uint32_t> ( SERVER_LIST_FORMAT_PARTS ), 1 );
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_REQ_SERVER_LIST,
+                                     vecMessage,
+                                     InetAddr );
+}
+
+bool CProtocol::EvaluateCLReqServerListMes ( const CHostAddress&     InetAddr,
+                                             const CVector<uint8_t>& vecData )
 {
-    int iPos = 0; // init position pointer
+    CMessReader MessReader ( vecData );
+
+    // old versions do not send the supported list format
+    int iListFormat = SERVER_LIST_FORMAT_LEGACY;
 
+    if ( MessReader.GetRemaining() >= 1 )
+    {
+        iListFormat = static_cast<int> ( MessReader.GetVal ( 1 ) );
+    }
+
+    // invoke message action
+    emit CLReqServerList ( InetAddr, iListFormat >= SERVER_LIST_FORMAT_PARTS );
+
+    return false; // no error
+}
+
+void CProtocol::CreateCLSendEmptyMesMes ( const CHostAddress& InetAddr,
+                                          const CHostAddress& TargetInetAddr )
+{
     // build data vector (6 bytes long)
-    CVector<uint8_t> vecData ( 6 );
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, 6 );
 
     // IP address (4 bytes)
-    PutValOnStream ( vecData, iPos, static_cast<uint32_t> (
+    MessWriter.PutVal ( static_cast<uint32_t> (
         TargetInetAddr.InetAddr.toIPv4Address() ), 4 );
 
     // port number (2 bytes)
-    PutValOnStream ( vecData, iPos,
+    MessWriter.PutVal (
         static_cast<uint32_t> ( TargetInetAddr.iPort ), 2 );
 
     CreateAndImmSendConLessMessage ( PROTMESSID_CLM_SEND_EMPTY_MESSAGE,
-                                     vecData,
+                                     vecMessage,
                                      InetAddr );
 }
 
 bool CProtocol::EvaluateCLSendEmptyMesMes ( const CVector<uint8_t>& vecData )
 {
-    int iPos = 0; // init position pointer
+    CMessReader MessReader ( vecData );
 
     // check size
     if ( vecData.Size() != 6 )
@@ -1777,11 +3247,11 @@ bool CProtocol::EvaluateCLSendEmptyMesMes ( const CVector<uint8_t>& vecData )
 
     // IP address (4 bytes)
     const quint32 iIpAddr =
-        static_cast<int> ( GetValFromStream ( vecData, iPos, 4 ) );
+        static_cast<int> ( MessReader.GetVal ( 4 ) );
 
     // port number (2 bytes)
     const quint16 iPort =
-        static_cast<int> ( GetValFromStream ( vecData, iPos, 2 ) );
+        static_cast<int> ( MessReader.GetVal ( 2 ) );
 
     // invoke message action
     emit CLSendEmptyMes ( CHostAddress ( QHostAddress ( iIpAddr ), iPort ) );
@@ -1794,14 +3264,12 @@ void CProtocol::CreateCLEmptyMes ( const CHostAddress& InetAddr )
     // special message: for this message there exist no Evaluate
     // function
     CreateAndImmSendConLessMessage ( PROTMESSID_CLM_EMPTY_MESSAGE,
-                                     CVector<uint8_t> ( 0 ),
                                      InetAddr );
 }
 
 void CProtocol::CreateCLDisconnection ( const CHostAddress& InetAddr )
 {
     CreateAndImmSendConLessMessage ( PROTMESSID_CLM_DISCONNECTION,
-                                     CVector<uint8_t> ( 0 ),
                                      InetAddr );
 }
 
@@ -1813,6 +3281,48 @@ bool CProtocol::EvaluateCLDisconnectionMes ( const CHostAddress& InetAddr )
     return false; // no error
 }
 
+void CProtocol::CreateCLAudioDelayMeasMes ( const CHostAddress& InetAddr,
+                                            const int           iMs,
+                                            const int           iJitBufFill )
+{
+    // build data vector (6 bytes long)
+    CVector<uint8_t> vecMessage;
+    CMessWriter      MessWriter ( vecMessage, 6 );
+
+    // transmit time (4 bytes)
+    MessWriter.PutVal ( static_cast<uint32_t> ( iMs ), 4 );
+
+    // jitter buffer fill (2 bytes)
+    MessWriter.PutVal ( static_cast<uint32_t> ( iJitBufFill ), 2 );
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_AUDIO_DELAY_MEAS,
+                                     vecMessage,
+                                     InetAddr );
+}
+
+bool CProtocol::EvaluateCLAudioDelayMeasMes ( const CHostAddress&     InetAddr,
+                                              const CVector<uint8_t>& vecData )
+{
+    CMessReader MessReader ( vecData );
+
+    // check size
+    if ( vecData.Size() != 6 )
+    {
+        return true; // return error code
+    }
+
+    // transmit time
+    const int iMs = static_cast<int> ( MessReader.GetVal ( 4 ) );
+
+    // jitter buffer fill
+    const int iJitBufFill = static_cast<int> ( MessReader.GetVal ( 2 ) );
+
+    // invoke message action
+    emit CLAudioDelayMeasReceived ( InetAddr, iMs, iJitBufFill );
+
+    return false; // no error
+}
+
 
 /******************************************************************************\
 * Message generation and parsing                                               *
@@ -1823,22 +3333,38 @@ bool CProtocol::ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
                                     int&                    iCnt,
                                     int&                    iID )
 {
-    int i;
-    int iLenBy;
-    int iCurPos;
+    // check that the vector contains the given number of bytes
+    if ( ( iNumBytesIn <= 0 ) || ( iNumBytesIn > vecbyData.Size() ) )
+    {
+        return true; // return error code
+    }
 
+    return ParseMessageFrame ( &vecbyData.front(),
+                               iNumBytesIn,
+                               vecbyMesBodyData,
+                               iCnt,
+                               iID );
+}
+
+bool CProtocol::ParseMessageFrame ( const uint8_t*    pbyData,
+                                    const int         iNumBytesIn,
+                                    CVector<uint8_t>& vecbyMesBodyData,
+                                    int&              iCnt,
+                                    int&              iID )
+{
     // vector must be at least "MESS_LEN_WITHOUT_DATA_BYTE" bytes long
     if ( iNumBytesIn < MESS_LEN_WITHOUT_DATA_BYTE )
     {
         return true; // return error code
     }
 
+    // we read directly from the input memory
+    CMessReader MessReader ( pbyData, iNumBytesIn );
 
-    // Decode header -----------------------------------------------------------
-    iCurPos = 0; // start from beginning
 
+    // Decode header -----------------------------------------------------------
     // 2 bytes TAG
-    const int iTag = static_cast<int> ( GetValFromStream ( vecbyData, iCurPos, 2 ) );
+    const int iTag = static_cast<int> ( MessReader.GetVal ( 2 ) );
 
     // check if tag is correct
     if ( iTag != 0 )
@@ -1847,13 +3373,13 @@ bool CProtocol::ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
     }
 
     // 2 bytes ID
-    iID = static_cast<int> ( GetValFromStream ( vecbyData, iCurPos, 2 ) );
+    iID = static_cast<int> ( MessReader.GetVal ( 2 ) );
 
     // 1 byte cnt
-    iCnt = static_cast<int> ( GetValFromStream ( vecbyData, iCurPos, 1 ) );
+    iCnt = static_cast<int> ( MessReader.GetVal ( 1 ) );
 
     // 2 bytes length
-    iLenBy = static_cast<int> ( GetValFromStream ( vecbyData, iCurPos, 2 ) );
+    const int iLenBy = static_cast<int> ( MessReader.GetVal ( 2 ) );
 
     // make sure the length is correct
     if ( iLenBy != iNumBytesIn - MESS_LEN_WITHOUT_DATA_BYTE )
@@ -1867,15 +3393,12 @@ bool CProtocol::ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
 
     const int iLenCRCCalc = MESS_HEADER_LENGTH_BYTE + iLenBy;
 
-    iCurPos = 0; // start from the beginning
+    CRCObj.AddBytes ( pbyData, iLenCRCCalc );
 
-    for ( i = 0; i < iLenCRCCalc; i++ )
-    {
-        CRCObj.AddByte ( static_cast<uint8_t> ( 
-            GetValFromStream ( vecbyData, iCurPos, 1 ) ) );
-    }
+    // the CRC is directly after the data
+    CMessReader CRCReader ( pbyData + iLenCRCCalc, 2 );
 
-    if ( CRCObj.GetCRC () != GetValFromStream ( vecbyData, iCurPos, 2 ) )
+    if ( CRCObj.GetCRC () != CRCReader.GetVal ( 2 ) )
     {
         return true; // return error code
     }
@@ -1884,76 +3407,40 @@ bool CProtocol::ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
     // Extract actual data -----------------------------------------------------
     vecbyMesBodyData.Init ( iLenBy );
 
-    iCurPos = MESS_HEADER_LENGTH_BYTE; // start from beginning of data
-
-    for ( i = 0; i < iLenBy; i++ )
+    if ( iLenBy > 0 )
     {
-        vecbyMesBodyData[i] = static_cast<uint8_t> (
-            GetValFromStream ( vecbyData, iCurPos, 1 ) );
+        memcpy ( &vecbyMesBodyData[0],
+                 pbyData + MESS_HEADER_LENGTH_BYTE,
+                 iLenBy );
     }
 
     return false; // no error
 }
 
-uint32_t CProtocol::GetValFromStream ( const CVector<uint8_t>& vecIn,
-                                       int&                    iPos,
-                                       const int               iNumOfBytes )
-{
-/*
-    note: iPos is automatically incremented in this function
-*/
-    // 4 bytes maximum since we return uint32
-    Q_ASSERT ( ( iNumOfBytes > 0 ) && ( iNumOfBytes <= 4 ) );
-    Q_ASSERT ( vecIn.Size() >= iPos + iNumOfBytes );
-
-    uint32_t iRet = 0;
-
-    for ( int i = 0; i < iNumOfBytes; i++ )
-    {
-        iRet |= vecIn[iPos] << ( i * 8 /* size of byte */ );
-        iPos++;
-    }
-
-    return iRet;
-}
-
-bool CProtocol::GetStringFromStream ( const CVector<uint8_t>& vecIn,
-                                      int&                    iPos,
-                                      const int               iMaxStringLen,
-                                      QString&                strOut )
+bool CProtocol::CMessReader::GetString ( const int iMaxStringLen,
+                                         QString&  strOut )
 {
-/*
-    note: iPos is automatically incremented in this function
-*/
-    const int iInLen = vecIn.Size();
-
     // check if at least two bytes are available
-    if ( ( iInLen - iPos ) < 2 )
+    if ( GetRemaining() < 2 )
     {
         return true; // return error code
     }
 
     // number of bytes for utf-8 string (2 bytes)
-    const int iStrUTF8Len =
-        static_cast<int> ( GetValFromStream ( vecIn, iPos, 2 ) );
+    const int iStrUTF8Len = static_cast<int> ( GetVal ( 2 ) );
 
     // (note that iPos was incremented by 2 in the above code!)
-    if ( ( iInLen - iPos ) < iStrUTF8Len )
+    if ( GetRemaining() < iStrUTF8Len )
     {
         return true; // return error code
     }
 
-    // string (n bytes)
-    QByteArray sStringUTF8;
+    // convert the utf-8 string (n bytes) directly from the input memory in
+    // the return string
+    strOut = QString::fromUtf8 (
+        reinterpret_cast<const char*> ( &pData[iPos] ), iStrUTF8Len );
 
-    for ( int i = 0; i < iStrUTF8Len; i++ )
-    {
-        // byte-by-byte copying of the string data
-        sStringUTF8.append ( static_cast<char> ( GetValFromStream ( vecIn, iPos, 1 ) ) );
-    }
-
-    // convert utf-8 byte array in the return string
-    strOut = QString::fromUtf8 ( sStringUTF8 );
+    iPos += iStrUTF8Len;
 
     // check length of actual string
     if ( strOut.size() > iMaxStringLen )
@@ -1964,104 +3451,74 @@ bool CProtocol::GetStringFromStream ( const CVector<uint8_t>& vecIn,
     return false; // no error
 }
 
-void CProtocol::GenMessageFrame ( CVector<uint8_t>&       vecOut,
-                                  const int               iCnt,
-                                  const int               iID,
-                                  const CVector<uint8_t>& vecData )
+void CProtocol::GenMessageFrame ( CVector<uint8_t>& vecMessage,
+                                  const int         iCnt,
+                                  const int         iID )
 {
-    int i;
-
-    // query length of data vector
-    const int iDataLenByte = vecData.Size();
-
-    // total length of message
-    const int iTotLenByte = MESS_LEN_WITHOUT_DATA_BYTE + iDataLenByte;
+/*
+    note: the message body was already written by a CMessWriter which also
+    allocated the complete message vector
+*/
+    // length of the data (the total length of the message is given by the
+    // size of the vector)
+    const int iDataLenByte = vecMessage.Size() - MESS_LEN_WITHOUT_DATA_BYTE;
 
-    // init message vector
-    vecOut.Init ( iTotLenByte );
+    Q_ASSERT ( iDataLenByte >= 0 );
 
 
     // Encode header -----------------------------------------------------------
     int iCurPos = 0; // init position pointer
 
     // 2 bytes TAG (all zero bits)
-    PutValOnStream ( vecOut, iCurPos,
-        static_cast<uint32_t> ( 0 ), 2 );
+    vecMessage[iCurPos++] = 0;
+    vecMessage[iCurPos++] = 0;
 
     // 2 bytes ID
-    PutValOnStream ( vecOut, iCurPos,
-        static_cast<uint32_t> ( iID ), 2 );
+    vecMessage[iCurPos++] = static_cast<uint8_t> ( iID & 255 );
+    vecMessage[iCurPos++] = static_cast<uint8_t> ( ( iID >> 8 ) & 255 );
 
     // 1 byte cnt
-    PutValOnStream ( vecOut, iCurPos,
-        static_cast<uint32_t> ( iCnt ), 1 );
+    vecMessage[iCurPos++] = static_cast<uint8_t> ( iCnt & 255 );
 
     // 2 bytes length
-    PutValOnStream ( vecOut, iCurPos,
-        static_cast<uint32_t> ( iDataLenByte ), 2 );
-
-    // encode data -----
-    for ( i = 0; i < iDataLenByte; i++ )
-    {
-        PutValOnStream ( vecOut, iCurPos,
-            static_cast<uint32_t> ( vecData[i] ), 1 );
-    }
+    vecMessage[iCurPos++] = static_cast<uint8_t> ( iDataLenByte & 255 );
+    vecMessage[iCurPos++] = static_cast<uint8_t> ( ( iDataLenByte >> 8 ) & 255 );
 
 
     // Encode CRC --------------------------------------------------------------
     CCRC CRCObj;
 
-    iCurPos = 0; // start from beginning
-
     const int iLenCRCCalc = MESS_HEADER_LENGTH_BYTE + iDataLenByte;
 
-    for ( i = 0; i < iLenCRCCalc; i++ )
-    {
-        CRCObj.AddByte ( static_cast<uint8_t> ( 
-            GetValFromStream ( vecOut, iCurPos, 1 ) ) );
-    }
+    CRCObj.AddBytes ( &vecMessage[0], iLenCRCCalc );
+
+    const uint32_t iCRC = CRCObj.GetCRC();
 
-    PutValOnStream ( vecOut, iCurPos,
-        static_cast<uint32_t> ( CRCObj.GetCRC() ), 2 );
+    vecMessage[iLenCRCCalc]     = static_cast<uint8_t> ( iCRC & 255 );
+    vecMessage[iLenCRCCalc + 1] = static_cast<uint8_t> ( ( iCRC >> 8 ) & 255 );
 }
 
-void CProtocol::PutValOnStream ( CVector<uint8_t>&  vecIn,
-                                 int&               iPos,
-                                 const uint32_t     iVal,
-                                 const int          iNumOfBytes )
+void CProtocol::PrepareBroadcastMes ( CBroadcastMessage& BroadcastMes,
+                                      const int          iID )
 {
-/*
-    note: iPos is automatically incremented in this function
-*/
-    // 4 bytes maximum since we use uint32
-    Q_ASSERT ( ( iNumOfBytes > 0 ) && ( iNumOfBytes <= 4 ) );
-    Q_ASSERT ( vecIn.Size() >= iPos + iNumOfBytes );
+    // complete the frame with a dummy counter which is replaced per peer
+    GenMessageFrame ( BroadcastMes.vecMessage, 0, iID );
 
-    for ( int i = 0; i < iNumOfBytes; i++ )
-    {
-        vecIn[iPos] =
-            ( iVal >> ( i * 8 /* size of byte */ ) ) & 255 /* 11111111 */;
+    BroadcastMes.iID = iID;
 
-        iPos++;
-    }
-}
+    // CRC contribution of the body on a zero start state
+    const int iDataLenByte =
+        BroadcastMes.vecMessage.Size() - MESS_LEN_WITHOUT_DATA_BYTE;
 
-void CProtocol::PutStringUTF8OnStream ( CVector<uint8_t>& vecIn,
-                                        int&              iPos,
-                                        const QByteArray& sStringUTF8 )
-{
-    // get the utf-8 string size
-    const int iStrUTF8Len = sStringUTF8.size();
+    CCRC CRCObj;
 
-    // number of bytes for utf-8 string (2 bytes)
-    PutValOnStream ( vecIn, iPos,
-        static_cast<uint32_t> ( iStrUTF8Len ), 2 );
+    CRCObj.SetState ( 0 );
 
-    // actual utf-8 string (n bytes)
-    for ( int j = 0; j < iStrUTF8Len; j++ )
-    {
-        // byte-by-byte copying of the utf-8 string data
-        PutValOnStream ( vecIn, iPos,
-            static_cast<uint32_t> ( sStringUTF8[j] ), 1 );
-    }
+    CRCObj.AddBytes ( &BroadcastMes.vecMessage[MESS_HEADER_LENGTH_BYTE],
+                      iDataLenByte );
+
+    BroadcastMes.iBodyCRCState = CRCObj.GetState();
+
+    // operator which transports the header state over the body length
+    CCRC::GetZeroBytesOperator ( iDataLenByte, BroadcastMes.pZeroBytesOperator );
 }
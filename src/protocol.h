@@ -28,7 +28,9 @@
 #include <QMutex>
 #include <QTimer>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <list>
+#include <string.h>
 #include "global.h"
 #include "util.h"
 
@@ -54,6 +56,10 @@
 #define PROTMESSID_CONN_CLIENTS_LIST          24 // channel infos for connected clients
 #define PROTMESSID_CHANNEL_INFOS              25 // set channel infos
 #define PROTMESSID_OPUS_SUPPORTED             26 // tells that OPUS codec is supported
+#define PROTMESSID_PROTOCOL_FEATURES          27 // supported protocol features
+#define PROTMESSID_MESS_CONTAINER             28 // several messages in one packet
+#define PROTMESSID_CONN_CLIENTS_LIST_DELTA    29 // changes of connected clients list
+#define PROTMESSID_LOCAL_MONITORING           30 // client monitors itself locally
 
 // message IDs of connection less messages (CLM)
 // DEFINITION -> start at 1000, end at 1999, see IsConnectionLessMessageID
@@ -67,14 +73,62 @@
 #define PROTMESSID_CLM_SEND_EMPTY_MESSAGE     1008 // an empty message shall be send
 #define PROTMESSID_CLM_EMPTY_MESSAGE          1009 // empty message
 #define PROTMESSID_CLM_DISCONNECTION          1010 // disconnection
+#define PROTMESSID_CLM_SERVER_LIST_PART       1011 // part of a server list
+#define PROTMESSID_CLM_AUDIO_DELAY_MEAS       1012 // for measuring the audio delay
 
 
 // lengths of message as defined in protocol.cpp file
 #define MESS_HEADER_LENGTH_BYTE         7 // TAG (2), ID (2), cnt (1), length (2)
 #define MESS_LEN_WITHOUT_DATA_BYTE      ( MESS_HEADER_LENGTH_BYTE + 2 /* CRC (2) */ )
 
-// time out for message re-send if no acknowledgement was received
+// time out for message re-send if no acknowledgement was received (this is the
+// initial value, the time out is adapted to the measured round trip time)
 #define SEND_MESS_TIMEOUT_MS            400 // ms
+#define SEND_MESS_MIN_TIMEOUT_MS        40 // ms
+#define SEND_MESS_MAX_TIMEOUT_MS        3000 // ms
+
+// maximum number of unacknowledged messages if the other side supports the
+// windowed transfer (otherwise we use stop-and-wait, i.e., a window of one)
+#define PROT_SEND_WINDOW_SIZE           8
+
+// range of cnt values ahead of the next expected message which are accepted
+// by the receiver (must be smaller than half of the cnt range of 256)
+#define PROT_RECEIVE_WINDOW_SIZE        64
+
+// maximum size of a message container, we stay below the typical path MTU so
+// that the network packet is not fragmented
+#define PROT_MAX_CONTAINER_SIZE_BYTES   1200
+
+// server list formats which are supported by the client (see
+// PROTMESSID_CLM_REQ_SERVER_LIST)
+#define SERVER_LIST_FORMAT_LEGACY       0
+#define SERVER_LIST_FORMAT_PARTS        1
+
+// server list in parts, the parts are sized like the message containers so
+// that the network packet is not fragmented
+#define MAX_SIZE_SERVER_LIST_PART_BYTES PROT_MAX_CONTAINER_SIZE_BYTES
+#define MAX_NUM_SERVER_LIST_PARTS       255
+
+// flags of a server list entry (see PROTMESSID_CLM_SERVER_LIST_PART)
+#define SERVER_LIST_FLAG_PERMANENT      0x01
+#define SERVER_LIST_FLAG_TOPIC          0x02
+#define SERVER_LIST_FLAG_CITY           0x04
+
+// protocol feature flags (see PROTMESSID_PROTOCOL_FEATURES)
+#define PROT_FEATURE_WINDOWED_TRANSFER  0x00000001
+#define PROT_FEATURE_MESS_CONTAINER     0x00000002
+#define PROT_FEATURE_CLIENT_LIST_DELTA  0x00000004
+#define PROT_FEATURE_AUDIO_FEC          0x00000008
+#define PROT_FEATURE_LOCAL_MONITORING   0x00000010
+#define PROT_FEATURES_OWN               ( PROT_FEATURE_WINDOWED_TRANSFER | \
+                                          PROT_FEATURE_MESS_CONTAINER |    \
+                                          PROT_FEATURE_CLIENT_LIST_DELTA | \
+                                          PROT_FEATURE_AUDIO_FEC |         \
+                                          PROT_FEATURE_LOCAL_MONITORING )
+
+// versions of the connected clients list (see PROTMESSID_CONN_CLIENTS_LIST_DELTA)
+#define FULL_CONN_CLIENTS_LIST_VERSION    0xFFFF // base version of a complete list
+#define INVALID_CONN_CLIENTS_LIST_VERSION -1
 
 
 /* Classes ********************************************************************/
@@ -85,6 +139,22 @@ class CProtocol : public QObject
 public:
     CProtocol();
 
+    // A message which is sent with identical content to a number of peers
+    // (e.g. the chat text on a server). The frame is serialized only once,
+    // per peer only the counter byte and the CRC are patched where the CRC
+    // of the body is combined with the CRC of the header so that the body
+    // is not processed again.
+    class CBroadcastMessage
+    {
+    public:
+        CBroadcastMessage() : iID ( PROTMESSID_ILLEGAL ), iBodyCRCState ( 0 ) {}
+
+        CVector<uint8_t> vecMessage;
+        int              iID;
+        uint16_t         iBodyCRCState;
+        uint16_t         pZeroBytesOperator[16];
+    };
+
     void Reset();
 
     void CreateJitBufMes ( const int iJitBufSize );
@@ -92,14 +162,23 @@ public:
     void CreateChanGainMes ( const int iChanID, const double dGain );
     void CreateConClientListNameMes ( const CVector<CChannelInfo>& vecChanInfo );
     void CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInfo );
+    void CreateConClientListDeltaMes ( const int                    iBaseVersion,
+                                       const int                    iNewVersion,
+                                       const CVector<CChannelInfo>& vecChangedChanInfo,
+                                       const CVector<int>&          vecRemovedChanIDs );
     void CreateReqConnClientsList();
     void CreateChanNameMes ( const QString strName );
     void CreateChanInfoMes ( const CChannelCoreInfo ChanInfo );
     void CreateReqChanInfoMes();
     void CreateChatTextMes ( const QString strChatText );
+    void CreateBroadcastMes ( const CBroadcastMessage& BroadcastMes );
+
+    static void PrepareChatTextBroadcastMes ( CBroadcastMessage& BroadcastMes,
+                                              const QString      strChatText );
     void CreateNetwTranspPropsMes ( const CNetworkTransportProps& NetTrProps );
     void CreateReqNetwTranspPropsMes();
     void CreateOpusSupportedMes();
+    void CreateLocalMonitoringMes ( const bool bEnabled );
 
     void CreateCLPingMes ( const CHostAddress& InetAddr, const int iMs );
     void CreateCLPingWithNumClientsMes ( const CHostAddress& InetAddr,
@@ -111,11 +190,16 @@ public:
     void CreateCLUnregisterServerMes ( const CHostAddress& InetAddr );
     void CreateCLServerListMes ( const CHostAddress&        InetAddr,
                                  const CVector<CServerInfo> vecServerInfo );
+    void CreateCLServerListPartsMes ( const CHostAddress&        InetAddr,
+                                      const CVector<CServerInfo> vecServerInfo );
     void CreateCLReqServerListMes ( const CHostAddress& InetAddr );
     void CreateCLSendEmptyMesMes ( const CHostAddress& InetAddr,
                                    const CHostAddress& TargetInetAddr );
     void CreateCLEmptyMes ( const CHostAddress& InetAddr );
     void CreateCLDisconnection ( const CHostAddress& InetAddr );
+    void CreateCLAudioDelayMeasMes ( const CHostAddress& InetAddr,
+                                     const int           iMs,
+                                     const int           iJitBufFill );
 
     bool ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
                              const int               iNumBytesIn,
@@ -138,6 +222,8 @@ public:
     bool IsConnectionLessMessageID ( const int iID ) const
         { return (iID >= 1000) & (iID < 2000); }
 
+    bool IsPeerFeatureSupported ( const int iFeature );
+
     // this function is public because we need it in the test bench
     void CreateAndImmSendAcknMess ( const int& iID,
                                     const int& iCnt );
@@ -147,60 +233,192 @@ protected:
     {
     public:
         CSendMessage() : vecMessage ( 0 ), iID ( PROTMESSID_ILLEGAL ),
-            iCnt ( 0 ) {}
+            iCnt ( 0 ), iNumSent ( 0 ), iSendTimeMs ( 0 ) {}
         CSendMessage ( const CVector<uint8_t>& nMess, const int iNCnt,
             const int iNID ) : vecMessage ( nMess ), iID ( iNID ),
-            iCnt ( iNCnt ) {}
+            iCnt ( iNCnt ), iNumSent ( 0 ), iSendTimeMs ( 0 ) {}
 
         CSendMessage& operator= ( const CSendMessage& NewSendMess )
         {
             vecMessage.Init ( NewSendMess.vecMessage.Size() );
             vecMessage = NewSendMess.vecMessage;
 
-            iID  = NewSendMess.iID;
-            iCnt = NewSendMess.iCnt;
+            iID         = NewSendMess.iID;
+            iCnt        = NewSendMess.iCnt;
+            iNumSent    = NewSendMess.iNumSent;
+            iSendTimeMs = NewSendMess.iSendTimeMs;
             return *this; 
         }
 
         CVector<uint8_t> vecMessage;
         int              iID, iCnt;
+        int              iNumSent;    // number of (re-)transmissions
+        qint64           iSendTimeMs; // time of the last transmission
+    };
+
+    // messages which were received ahead of the next expected one (windowed
+    // transfer only)
+    class CRecMessage
+    {
+    public:
+        CRecMessage() : vecMessBody ( 0 ), iID ( PROTMESSID_ILLEGAL ),
+            bIsValid ( false ) {}
+
+        CVector<uint8_t> vecMessBody;
+        int              iID;
+        bool             bIsValid;
+    };
+
+    // Writes the message body directly in the preallocated message frame
+    // (behind the header), the header and the CRC are filled in afterwards
+    // by "GenMessageFrame". Note that iPos is automatically incremented.
+    class CMessWriter
+    {
+    public:
+        CMessWriter ( CVector<uint8_t>& vecMessage, const int iDataLenByte ) :
+            iPos ( 0 ), iLen ( iDataLenByte )
+        {
+            vecMessage.Init ( MESS_LEN_WITHOUT_DATA_BYTE + iDataLenByte );
+            pData = &vecMessage[MESS_HEADER_LENGTH_BYTE];
+        }
+
+        void PutVal ( const uint32_t iVal, const int iNumOfBytes )
+        {
+            // 4 bytes maximum since we use uint32
+            Q_ASSERT ( ( iNumOfBytes > 0 ) && ( iNumOfBytes <= 4 ) );
+            Q_ASSERT ( iLen >= iPos + iNumOfBytes );
+
+            for ( int i = 0; i < iNumOfBytes; i++ )
+            {
+                pData[iPos++] = static_cast<uint8_t> (
+                    ( iVal >> ( i * 8 /* size of byte */ ) ) & 255 /* 11111111 */ );
+            }
+        }
+
+        void PutStringUTF8 ( const QByteArray& sStringUTF8 )
+        {
+            // get the utf-8 string size
+            const int iStrUTF8Len = sStringUTF8.size();
+
+            // number of bytes for utf-8 string (2 bytes)
+            PutVal ( static_cast<uint32_t> ( iStrUTF8Len ), 2 );
+
+            // actual utf-8 string (n bytes)
+            Q_ASSERT ( iLen >= iPos + iStrUTF8Len );
+
+            memcpy ( &pData[iPos], sStringUTF8.constData(), iStrUTF8Len );
+            iPos += iStrUTF8Len;
+        }
+
+        void PutBytes ( const CVector<uint8_t>& vecbyData )
+        {
+            const int iNumBytes = vecbyData.Size();
+
+            Q_ASSERT ( iLen >= iPos + iNumBytes );
+
+            if ( iNumBytes > 0 )
+            {
+                memcpy ( &pData[iPos], &vecbyData.front(), iNumBytes );
+                iPos += iNumBytes;
+            }
+        }
+
+    protected:
+        uint8_t* pData;
+        int      iPos;
+        int      iLen;
+    };
+
+    // Reads the values from a message body without copying the data. Note that
+    // iPos is automatically incremented.
+    class CMessReader
+    {
+    public:
+        CMessReader ( const uint8_t* pNData, const int iNLen ) :
+            pData ( pNData ), iPos ( 0 ), iLen ( iNLen ) {}
+
+        CMessReader ( const CVector<uint8_t>& vecData ) :
+            pData ( vecData.empty() ? NULL : &vecData.front() ),
+            iPos ( 0 ), iLen ( vecData.Size() ) {}
+
+        int GetPos() const { return iPos; }
+        int GetRemaining() const { return iLen - iPos; }
+
+        uint32_t GetVal ( const int iNumOfBytes )
+        {
+            // 4 bytes maximum since we return uint32
+            Q_ASSERT ( ( iNumOfBytes > 0 ) && ( iNumOfBytes <= 4 ) );
+            Q_ASSERT ( iLen >= iPos + iNumOfBytes );
+
+            uint32_t iRet = 0;
+
+            for ( int i = 0; i < iNumOfBytes; i++ )
+            {
+                iRet |= static_cast<uint32_t> ( pData[iPos++] ) <<
+                    ( i * 8 /* size of byte */ );
+            }
+
+            return iRet;
+        }
+
+        bool GetString ( const int iMaxStringLen, QString& strOut );
+
+    protected:
+        const uint8_t* pData;
+        int            iPos;
+        int            iLen;
     };
 
     void EnqueueMessage ( CVector<uint8_t>& vecMessage,
                           const int         iCnt,
                           const int         iID );
 
-    void GenMessageFrame ( CVector<uint8_t>&       vecOut,
-                           const int               iCnt,
-                           const int               iID,
-                           const CVector<uint8_t>& vecData );
+    static void GenMessageFrame ( CVector<uint8_t>& vecMessage,
+                                  const int         iCnt,
+                                  const int         iID );
 
-    void PutValOnStream ( CVector<uint8_t>& vecIn,
-                          int&              iPos,
-                          const uint32_t    iVal,
-                          const int         iNumOfBytes );
+    static void PrepareBroadcastMes ( CBroadcastMessage& BroadcastMes,
+                                      const int          iID );
 
-    void PutStringUTF8OnStream ( CVector<uint8_t>& vecIn,
-                                 int&              iPos,
-                                 const QByteArray& sStringUTF8 );
+    void SendMessage();
+    void SendFrames ( std::list<CVector<uint8_t> >& Frames );
+    void UpdateRetransmitTimeout ( const int iRoundTripTimeMs );
 
-    uint32_t GetValFromStream ( const CVector<uint8_t>& vecIn,
-                                int&                    iPos,
-                                const int               iNumOfBytes );
+    bool ParseMessageFrame ( const uint8_t*    pbyData,
+                             const int         iNumBytesIn,
+                             CVector<uint8_t>& vecbyMesBodyData,
+                             int&              iRecCounter,
+                             int&              iRecID );
 
-    bool GetStringFromStream ( const CVector<uint8_t>& vecIn,
-                               int&                    iPos,
-                               const int               iMaxStringLen,
-                               QString&                strOut );
+    bool ParseMessageBodyIntern ( const CVector<uint8_t>& vecbyMesBodyData,
+                                  const int               iRecCounter,
+                                  const int               iRecID );
 
-    void SendMessage();
+    bool ParseMessageContainer ( const CVector<uint8_t>& vecbyMesBodyData );
 
-    void CreateAndSendMessage ( const int               iID,
-                                const CVector<uint8_t>& vecData );
+    bool ParseMessageBodyInOrder ( const CVector<uint8_t>& vecbyMesBodyData,
+                                   const int               iRecCounter,
+                                   const int               iRecID );
 
-    void CreateAndImmSendConLessMessage ( const int               iID,
-                                          const CVector<uint8_t>& vecData,
-                                          const CHostAddress&     InetAddr );
+    bool EvaluateMessage ( const CVector<uint8_t>& vecbyMesBodyData,
+                           const int               iRecCounter,
+                           const int               iRecID );
+
+    void CreateProtFeaturesMes();
+
+    int GetNextSendCounter();
+
+    void CreateAndSendMessage ( const int         iID,
+                                CVector<uint8_t>& vecMessage );
+
+    void CreateAndSendMessage ( const int iID );
+
+    void CreateAndImmSendConLessMessage ( const int           iID,
+                                          CVector<uint8_t>&   vecMessage,
+                                          const CHostAddress& InetAddr );
+
+    void CreateAndImmSendConLessMessage ( const int           iID,
+                                          const CHostAddress& InetAddr );
 
     bool EvaluateJitBufMes             ( const CVector<uint8_t>& vecData );
     bool EvaluateReqJitBufMes();
@@ -215,6 +433,21 @@ protected:
     bool EvaluateNetwTranspPropsMes    ( const CVector<uint8_t>& vecData );
     bool EvaluateReqNetwTranspPropsMes();
     bool EvaluateOpusSupportedMes();
+    bool EvaluateProtFeaturesMes       ( const CVector<uint8_t>& vecData,
+                                         const int               iRecCounter );
+    bool EvaluateConClientListDeltaMes ( const CVector<uint8_t>& vecData );
+    bool EvaluateLocalMonitoringMes    ( const CVector<uint8_t>& vecData );
+
+    int  GetConClientListEntrLen ( const QByteArray& strUTF8Name,
+                                   const QByteArray& strUTF8City );
+
+    void PutConClientListEntry ( CMessWriter&        MessWriter,
+                                 const CChannelInfo& ChanInfo,
+                                 const QByteArray&   strUTF8Name,
+                                 const QByteArray&   strUTF8City );
+
+    bool GetConClientListEntry ( CMessReader&  MessReader,
+                                 CChannelInfo& ChanInfo );
 
     bool EvaluateCLPingMes               ( const CHostAddress&     InetAddr,
                                            const CVector<uint8_t>& vecData );
@@ -226,17 +459,55 @@ protected:
     bool EvaluateCLUnregisterServerMes   ( const CHostAddress&     InetAddr );
     bool EvaluateCLServerListMes         ( const CHostAddress&     InetAddr,
                                            const CVector<uint8_t>& vecData );
-    bool EvaluateCLReqServerListMes      ( const CHostAddress& InetAddr );
+    bool EvaluateCLServerListPartMes     ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+    bool EvaluateCLReqServerListMes      ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
+
+    int  GetCLServerListPart ( const CVector<QByteArray>& vecstrUTF8Name,
+                               const CVector<QByteArray>& vecstrUTF8Topic,
+                               const CVector<QByteArray>& vecstrUTF8City,
+                               const int                  iFirstServer,
+                               QList<QByteArray>&         StringTable,
+                               int&                       iPartLenBy );
     bool EvaluateCLSendEmptyMesMes       ( const CVector<uint8_t>& vecData );
     bool EvaluateCLDisconnectionMes      ( const CHostAddress& InetAddr );
+    bool EvaluateCLAudioDelayMeasMes     ( const CHostAddress&     InetAddr,
+                                           const CVector<uint8_t>& vecData );
 
     int                     iOldRecID;
     int                     iOldRecCnt;
 
-    // these two objects must be sequred by a mutex
+    // server list in parts: ID of the sent list and reassembly of the
+    // received list
+    int                     iCLServerListSendID;
+    int                     iCLServerListRecID;
+    CHostAddress            CLServerListRecAddr;
+    int                     iCLServerListRecNumParts;
+    CVector<CVector<CServerInfo> > vecvecCLServerListRecParts;
+    CVector<int>            veciCLServerListRecPartOK;
+
+    // the connected clients list is assembled from the delta messages
+    CVector<CChannelInfo>   vecConClientList;
+    int                     iConClientListVersion;
+
+    // these objects must be sequred by a mutex
     uint8_t                 iCounter;
     std::list<CSendMessage> SendMessQueue;
-
+    int                     iSessionID;
+    bool                    bProtFeaturesSent;
+    bool                    bProtFeaturesAckn;
+    int                     iPeerFeatures;
+    int                     iPeerSessionID;
+    int                     iNextExpRecCnt;
+    CVector<CRecMessage>    vecRecMessBuf;
+    int                     iSmoothedRTTMs;
+    int                     iRTTVarianceMs;
+    int                     iRetransTimeoutMs;
+    int                     iNumParseDefer;
+    std::list<CVector<uint8_t> > PendingSendFrames;
+
+    QElapsedTimer           ElapsedTimer;
     QTimer                  TimerSendMess;
     QMutex                  Mutex;
 
@@ -265,6 +536,8 @@ signals:
     void ChatTextReceived ( QString strChatText );
     void NetTranspPropsReceived ( CNetworkTransportProps NetworkTransportProps );
     void ReqNetTranspProps();
+    void LocalMonitoringChanged ( bool bEnabled );
+    void ProtFeaturesReceived();
 
     void CLPingReceived               ( CHostAddress         InetAddr,
                                         int                  iMs );
@@ -276,9 +549,13 @@ signals:
     void CLUnregisterServerReceived   ( CHostAddress         InetAddr );
     void CLServerListReceived         ( CHostAddress         InetAddr,
                                         CVector<CServerInfo> vecServerInfo );
-    void CLReqServerList              ( CHostAddress         InetAddr );
+    void CLReqServerList              ( CHostAddress         InetAddr,
+                                        bool                 bPartsSupported );
     void CLSendEmptyMes               ( CHostAddress         TargetInetAddr );
     void CLDisconnection              ( CHostAddress         InetAddr );
+    void CLAudioDelayMeasReceived     ( CHostAddress         InetAddr,
+                                        int                  iMs,
+                                        int                  iJitBufFill );
 };
 
 #endif /* !defined ( PROTOCOL_H__3B123453_4344_BB2392354455IUHF1912__INCLUDED_ ) */
@@ -201,9 +201,12 @@ CServer::CServer ( const int      iNewNumChan,
                    const QString& strCentralServer,
                    const QString& strServerInfo,
                    const QString& strNewWelcomeMessage,
-                   const bool     bNCentServPingServerInList ) :
+                   const bool     bNCentServPingServerInList,
+                   const int      iNumSockets ) :
     iNumChannels         ( iNewNumChan ),
-    Socket               ( this, iPortNumber ),
+    Socket               ( this, iPortNumber, iNumSockets > 1 ),
+    vecChanListPublished ( 0 ),
+    iChanListVersion     ( 0 ),
     bWriteStatusHTMLFile ( false ),
     ServerListManager    ( iPortNumber,
                            strCentralServer,
@@ -295,6 +298,45 @@ CServer::CServer ( const int      iNewNumChan,
         opus_custom_encoder_ctl ( OpusEncoderStereo[i],
                                   OPUS_SET_COMPLEXITY ( 1 ) );
 #endif
+
+        // init audio encoders/decoders for the redundant frames of the forward
+        // error correction (the bit rate is set when the network transport
+        // properties of the channel change since it is defined by the client)
+        OpusEncoderFecMono[i] = opus_custom_encoder_create ( OpusMode[i],
+                                                             1,
+                                                             &iOpusError );
+
+        OpusDecoderFecMono[i] = opus_custom_decoder_create ( OpusMode[i],
+                                                             1,
+                                                             &iOpusError );
+
+        OpusEncoderFecStereo[i] = opus_custom_encoder_create ( OpusMode[i],
+                                                               2,
+                                                               &iOpusError );
+
+        OpusDecoderFecStereo[i] = opus_custom_decoder_create ( OpusMode[i],
+                                                               2,
+                                                               &iOpusError );
+
+        opus_custom_encoder_ctl ( OpusEncoderFecMono[i],
+                                  OPUS_SET_VBR ( 0 ) );
+
+        opus_custom_encoder_ctl ( OpusEncoderFecMono[i],
+                                  OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+
+        opus_custom_encoder_ctl ( OpusEncoderFecStereo[i],
+                                  OPUS_SET_VBR ( 0 ) );
+
+        opus_custom_encoder_ctl ( OpusEncoderFecStereo[i],
+                                  OPUS_SET_APPLICATION ( OPUS_APPLICATION_RESTRICTED_LOWDELAY ) );
+
+#ifdef USE_LOW_COMPLEXITY_CELT_ENC
+        opus_custom_encoder_ctl ( OpusEncoderFecMono[i],
+                                  OPUS_SET_COMPLEXITY ( 1 ) );
+
+        opus_custom_encoder_ctl ( OpusEncoderFecStereo[i],
+                                  OPUS_SET_COMPLEXITY ( 1 ) );
+#endif
     }
 
     // define colors for chat window identifiers
@@ -349,6 +391,17 @@ CServer::CServer ( const int      iNewNumChan,
     for ( i = 0; i < iNumChannels; i++ )
     {
         vecChannels[i].SetEnable ( true );
+
+        // the gains and the per tick relevant state are stored in server
+        // wide structures
+        vecChannels[i].SetServerState ( i, &GainMatrix, &HotChanState );
+        vecChannels[i].SetTimeOutWheel ( &TimeOutWheel );
+    }
+
+    // no client has received a connected clients list yet
+    for ( i = 0; i < MAX_NUM_CHANNELS; i++ )
+    {
+        vecChanListVersionSent[i] = INVALID_CONN_CLIENTS_LIST_VERSION;
     }
 
 
@@ -378,8 +431,8 @@ CServer::CServer ( const int      iNewNumChan,
         this, SLOT ( OnCLUnregisterServerReceived ( CHostAddress ) ) );
 
     QObject::connect ( &ConnLessProtocol,
-        SIGNAL ( CLReqServerList ( CHostAddress ) ),
-        this, SLOT ( OnCLReqServerList ( CHostAddress ) ) );
+        SIGNAL ( CLReqServerList ( CHostAddress, bool ) ),
+        this, SLOT ( OnCLReqServerList ( CHostAddress, bool ) ) );
 
     QObject::connect ( &ConnLessProtocol,
         SIGNAL ( CLSendEmptyMes ( CHostAddress ) ),
@@ -389,6 +442,14 @@ CServer::CServer ( const int      iNewNumChan,
         SIGNAL ( CLDisconnection ( CHostAddress ) ),
         this, SLOT ( OnCLDisconnection ( CHostAddress ) ) );
 
+    QObject::connect ( &ConnLessProtocol,
+        SIGNAL ( CLAudioDelayMeasReceived ( CHostAddress, int, int ) ),
+        this, SLOT ( OnCLAudioDelayMeasReceived ( CHostAddress, int, int ) ) );
+
+    QObject::connect ( this,
+        SIGNAL ( UnknownAddrPacketReceived ( CVector<uint8_t>, int, CHostAddress, qint64 ) ),
+        this, SLOT ( OnUnknownAddrPacketReceived ( CVector<uint8_t>, int, CHostAddress, qint64 ) ) );
+
 
     // CODE TAG: MAX_NUM_CHANNELS_TAG
     // make sure we have MAX_NUM_CHANNELS connections!!!
@@ -545,6 +606,40 @@ CServer::CServer ( const int      iNewNumChan,
     QObject::connect ( &vecChannels[17], SIGNAL ( ServerAutoSockBufSizeChange ( int ) ), this, SLOT ( OnServerAutoSockBufSizeChangeCh17 ( int ) ) );
     QObject::connect ( &vecChannels[18], SIGNAL ( ServerAutoSockBufSizeChange ( int ) ), this, SLOT ( OnServerAutoSockBufSizeChangeCh18 ( int ) ) );
     QObject::connect ( &vecChannels[19], SIGNAL ( ServerAutoSockBufSizeChange ( int ) ), this, SLOT ( OnServerAutoSockBufSizeChangeCh19 ( int ) ) );
+
+
+    // Additional sockets ------------------------------------------------------
+    // open additional sockets on the same port number, each with its own
+    // receive thread (SO_REUSEPORT is only supported on Linux), this must be
+    // done after all connections are established since the receive threads
+    // are started immediately
+#ifdef __linux__
+    if ( iNumSockets > 1 )
+    {
+        // we have to register some classes to the Qt signal/slot mechanism
+        // since we have thread crossings with the receive threads
+        qRegisterMetaType<CVector<uint8_t> > ( "CVector<uint8_t>" );
+        qRegisterMetaType<CHostAddress> ( "CHostAddress" );
+        qRegisterMetaType<CServerCoreInfo> ( "CServerCoreInfo" );
+
+        vecpReceiveThreadSockets.Init ( iNumSockets - 1, NULL );
+
+        for ( i = 0; i < iNumSockets - 1; i++ )
+        {
+            vecpReceiveThreadSockets[i] =
+                new CReceiveThreadSocket ( this, iPortNumber );
+        }
+    }
+#endif
+}
+
+CServer::~CServer()
+{
+    // stop the receive threads of the additional sockets
+    for ( int i = 0; i < vecpReceiveThreadSockets.Size(); i++ )
+    {
+        delete vecpReceiveThreadSockets[i];
+    }
 }
 
 void CServer::OnSendProtMessage ( int iChID, CVector<uint8_t> vecMessage )
@@ -600,6 +695,38 @@ void CServer::OnCLDisconnection ( CHostAddress InetAddr )
     }
 }
 
+void CServer::OnCLAudioDelayMeasReceived ( CHostAddress InetAddr,
+                                           int          iMs,
+                                           int )
+{
+    // only connected clients get an answer since the jitter buffer fill of
+    // their channel is returned together with the time stamp
+    const int iCurChanID = FindChannel ( InetAddr );
+
+    if ( ( iCurChanID != INVALID_CHANNEL_ID ) &&
+         vecChannels[iCurChanID].IsConnected() )
+    {
+        ConnLessProtocol.CreateCLAudioDelayMeasMes ( InetAddr,
+            iMs,
+            vecChannels[iCurChanID].GetSockBufNumFramesFilled() );
+    }
+}
+
+void CServer::OnUnknownAddrPacketReceived ( CVector<uint8_t> vecbyRecBuf,
+                                            int              iNumBytesRead,
+                                            CHostAddress     HostAdr,
+                                            qint64           iRecTimeNs )
+{
+    // a packet from an unknown address was received by one of the receive
+    // threads, we process it here in the main thread
+    if ( PutData ( vecbyRecBuf, iNumBytesRead, HostAdr, iRecTimeNs ) )
+    {
+        // this was an audio packet, start server (if the server is still
+        // running, the call to Start() will have no effect)
+        Start();
+    }
+}
+
 void CServer::Start()
 {
     // only start if not already running
@@ -632,6 +759,73 @@ void CServer::Stop()
     }
 }
 
+bool CServer::UpdateHotChanState()
+{
+/*
+    note: this function must be called inside the mutex region, it returns
+    true if a channel was disconnected since the last call
+*/
+    bool      bChannelIsNowDisconnected = false;
+    const int iChangedMask              = HotChanState.TakeChangedMask();
+
+    if ( iChangedMask == 0 )
+    {
+        // nothing has changed, this is the usual case
+        return false;
+    }
+
+    for ( int i = 0; i < iNumChannels; i++ )
+    {
+        if ( iChangedMask & ( 1 << i ) )
+        {
+            const bool bIsConnected        = vecChannels[i].IsConnected();
+            const int  iNewNetwFecNumBytes = vecChannels[i].GetNetwFecNumBytes();
+
+            if ( HotChanState.vbIsConnected[i] && !bIsConnected )
+            {
+                bChannelIsNowDisconnected = true;
+            }
+
+            // the bit rate of the redundant frames only changes with the
+            // network transport properties, therefore the forward error
+            // correction encoders are only updated here and not on each tick
+            if ( ( iNewNetwFecNumBytes > 0 ) &&
+                 ( iNewNetwFecNumBytes != HotChanState.viNetwFecNumBytes[i] ) )
+            {
+                const int iFecBitRate =
+                    CalcBitRateBitsPerSecFromCodedBytes ( iNewNetwFecNumBytes );
+
+                opus_custom_encoder_ctl ( OpusEncoderFecMono[i],
+                                          OPUS_SET_BITRATE ( iFecBitRate ) );
+
+                opus_custom_encoder_ctl ( OpusEncoderFecStereo[i],
+                                          OPUS_SET_BITRATE ( iFecBitRate ) );
+            }
+
+            HotChanState.vbIsConnected[i]          = bIsConnected;
+            HotChanState.veAudioCompressionType[i] = vecChannels[i].GetAudioCompressionType();
+            HotChanState.viNetwFrameSize[i]        = vecChannels[i].GetNetwFrameSize();
+            HotChanState.viNetwCodedFrameSize[i]   = vecChannels[i].GetNetwCodedFrameSize();
+            HotChanState.viNetwFecNumBytes[i]      = iNewNetwFecNumBytes;
+            HotChanState.viNumAudioChannels[i]     = vecChannels[i].GetNumAudioChannels();
+            HotChanState.vbLocalMonitoring[i]      = vecChannels[i].GetLocalMonitoring();
+        }
+    }
+
+    // update the list of the connected channels
+    HotChanState.iNumConnChan = 0;
+
+    for ( int i = 0; i < iNumChannels; i++ )
+    {
+        if ( HotChanState.vbIsConnected[i] )
+        {
+            HotChanState.viConnChanIDs[HotChanState.iNumConnChan++] = i;
+        }
+    }
+
+    return bChannelIsNowDisconnected;
+}
+
 void CServer::OnTimer()
 {
     int i, j;
@@ -641,26 +835,30 @@ void CServer::OnTimer()
     CVector<CVector<int16_t> > vecvecsData;
     CVector<int>               vecNumAudioChannels;
 
-    // Get data from all connected clients -------------------------------------
-    bool bChannelIsNowDisconnected = false;
+    // decoder output which is not used (a redundant frame which is not needed
+    // or a concealed frame which is replaced by a redundant frame)
+    CVector<int16_t>           vecsFecDecOut ( 2 * SYSTEM_FRAME_SIZE_SAMPLES );
 
+    // Get data from all connected clients -------------------------------------
     // Make put and get calls thread safe. Do not forget to unlock mutex
     // afterwards!
     Mutex.lock();
     {
+        // refresh the state of the channels which have changed since the last
+        // tick (the connection time-out wheel marks the disconnected channels)
+        const bool bChannelIsNowDisconnected = UpdateHotChanState();
+
         // first, get number and IDs of connected channels
-        vecChanID.Init ( 0 );
-        for ( i = 0; i < iNumChannels; i++ )
+        const int iNumCurConnChan = HotChanState.iNumConnChan;
+
+        vecChanID.Init ( iNumCurConnChan );
+        for ( i = 0; i < iNumCurConnChan; i++ )
         {
-            if ( vecChannels[i].IsConnected() )
-            {
-                // add ID and data
-                vecChanID.Add ( i );
-            }
+            vecChanID[i] = HotChanState.viConnChanIDs[i];
         }
 
-        // process connected channels
-        const int iNumCurConnChan = vecChanID.Size();
+        // consistent snapshot of the gains of all channels (no locking)
+        const CVector<double>& vecdGainMatrix = GainMatrix.AcquireSnapshot();
 
         // init temporary vectors
         vecvecdGains.Init        ( iNumCurConnChan );
@@ -674,7 +872,7 @@ void CServer::OnTimer()
 
             // get and store number of audio channels
             const int iCurNumAudChan =
-                vecChannels[iCurChanID].GetNumAudioChannels();
+                HotChanState.viNumAudioChannels[iCurChanID];
 
             vecNumAudioChannels[i] = iCurNumAudChan;
 
@@ -688,27 +886,31 @@ void CServer::OnTimer()
                 // The second index of "vecvecdGains" does not represent
                 // the channel ID! Therefore we have to use "vecChanID" to
                 // query the IDs of the currently connected channels
-                vecvecdGains[i][j] =
-                    vecChannels[iCurChanID].GetGain( vecChanID[j] );
+                vecvecdGains[i][j] = CChannelGainMatrix::GetGain (
+                    vecdGainMatrix, iCurChanID, vecChanID[j] );
             }
 
-            // get current number of CELT coded bytes
-            const int iCeltNumCodedBytes =
-                vecChannels[iCurChanID].GetNetwFrameSize();
+            // a client which monitors itself locally does not get its own
+            // signal in its mix (the mixer skips sources with zero gain)
+            if ( HotChanState.vbLocalMonitoring[iCurChanID] )
+            {
+                vecvecdGains[i][i] = 0;
+            }
 
             // init temporal data vector and clear input buffers
-            CVector<uint8_t> vecbyData ( iCeltNumCodedBytes );
+            CVector<uint8_t> vecbyData ( HotChanState.viNetwFrameSize[iCurChanID] );
+
+            // get data (with forward error correction the data additionally
+            // contains a redundant frame, if the number of coded bytes is
+            // zero, a lost frame was recovered by the redundant frame)
+            int iNumCodedBytes;
+            int iNumFecBytes;
 
-            // get data
             const EGetDataStat eGetStat =
-                vecChannels[iCurChanID].GetData ( vecbyData );
+                vecChannels[iCurChanID].GetData ( vecbyData, iNumCodedBytes, iNumFecBytes );
 
-            // if channel was just disconnected, set flag that connected
-            // client list is sent to all other clients
-            if ( eGetStat == GS_CHAN_NOW_DISCONNECTED )
-            {
-                bChannelIsNowDisconnected = true;
-            }
+            const EAudComprType eAudioCompressionType =
+                HotChanState.veAudioCompressionType[iCurChanID];
 
             // CELT decode received data stream
             if ( eGetStat == GS_BUFFER_OK )
@@ -717,40 +919,64 @@ void CServer::OnTimer()
                 {
                     // mono
 
-                    if ( vecChannels[iCurChanID].GetAudioCompressionType() == CT_CELT )
+                    if ( eAudioCompressionType == CT_CELT )
                     {
                         cc6_celt_decode ( CeltDecoderMono[iCurChanID],
                                           &vecbyData[0],
-                                          iCeltNumCodedBytes,
+                                          iNumCodedBytes,
                                           &vecvecsData[i][0] );
                     }
                     else
                     {
+                        // the regular decoder conceals the frame which is
+                        // replaced by the redundant frame so that its state
+                        // stays continuous in time
                         opus_custom_decode ( OpusDecoderMono[iCurChanID],
-                                             &vecbyData[0],
-                                             iCeltNumCodedBytes,
-                                             &vecvecsData[i][0],
+                                             iNumCodedBytes > 0 ? &vecbyData[0] : NULL,
+                                             iNumCodedBytes,
+                                             iNumCodedBytes > 0 ? &vecvecsData[i][0] : &vecsFecDecOut[0],
                                              SYSTEM_FRAME_SIZE_SAMPLES );
+
+                        // the redundant frames are always decoded by their
+                        // own decoder which has the state of the redundant
+                        // encoder
+                        if ( iNumFecBytes > 0 )
+                        {
+                            opus_custom_decode ( OpusDecoderFecMono[iCurChanID],
+                                                 &vecbyData[iNumCodedBytes],
+                                                 iNumFecBytes,
+                                                 iNumCodedBytes > 0 ? &vecsFecDecOut[0] : &vecvecsData[i][0],
+                                                 SYSTEM_FRAME_SIZE_SAMPLES );
+                        }
                     }
                 }
                 else
                 {
                     // stereo
 
-                    if ( vecChannels[iCurChanID].GetAudioCompressionType() == CT_CELT )
+                    if ( eAudioCompressionType == CT_CELT )
                     {
                         cc6_celt_decode ( CeltDecoderStereo[iCurChanID],
                                           &vecbyData[0],
-                                          iCeltNumCodedBytes,
+                                          iNumCodedBytes,
                                           &vecvecsData[i][0] );
                     }
                     else
                     {
                         opus_custom_decode ( OpusDecoderStereo[iCurChanID],
-                                             &vecbyData[0],
-                                             iCeltNumCodedBytes,
-                                             &vecvecsData[i][0],
+                                             iNumCodedBytes > 0 ? &vecbyData[0] : NULL,
+                                             iNumCodedBytes,
+                                             iNumCodedBytes > 0 ? &vecvecsData[i][0] : &vecsFecDecOut[0],
                                              SYSTEM_FRAME_SIZE_SAMPLES );
+
+                        if ( iNumFecBytes > 0 )
+                        {
+                            opus_custom_decode ( OpusDecoderFecStereo[iCurChanID],
+                                                 &vecbyData[iNumCodedBytes],
+                                                 iNumFecBytes,
+                                                 iNumCodedBytes > 0 ? &vecsFecDecOut[0] : &vecvecsData[i][0],
+                                                 SYSTEM_FRAME_SIZE_SAMPLES );
+                        }
                     }
                 }
             }
@@ -761,7 +987,7 @@ void CServer::OnTimer()
                 {
                     // mono
 
-                    if ( vecChannels[iCurChanID].GetAudioCompressionType() == CT_CELT )
+                    if ( eAudioCompressionType == CT_CELT )
                     {
                         cc6_celt_decode ( CeltDecoderMono[iCurChanID],
                                           NULL,
@@ -772,7 +998,7 @@ void CServer::OnTimer()
                     {
                         opus_custom_decode ( OpusDecoderMono[iCurChanID],
                                              NULL,
-                                             iCeltNumCodedBytes,
+                                             0,
                                              &vecvecsData[i][0],
                                              SYSTEM_FRAME_SIZE_SAMPLES );
                     }
@@ -781,7 +1007,7 @@ void CServer::OnTimer()
                 {
                     // stereo
 
-                    if ( vecChannels[iCurChanID].GetAudioCompressionType() == CT_CELT )
+                    if ( eAudioCompressionType == CT_CELT )
                     {
                         cc6_celt_decode ( CeltDecoderStereo[iCurChanID],
                                           NULL,
@@ -792,7 +1018,7 @@ void CServer::OnTimer()
                     {
                         opus_custom_decode ( OpusDecoderStereo[iCurChanID],
                                              NULL,
-                                             iCeltNumCodedBytes,
+                                             0,
                                              &vecvecsData[i][0],
                                              SYSTEM_FRAME_SIZE_SAMPLES );
                     }
@@ -810,6 +1036,9 @@ void CServer::OnTimer()
             }
         }
 
+        // the gains are copied, the snapshot is not used anymore
+        GainMatrix.ReleaseSnapshot();
+
         // a channel is now disconnected, take action on it
         if ( bChannelIsNowDisconnected )
         {
@@ -839,27 +1068,42 @@ void CServer::OnTimer()
                                                         vecvecdGains[i],
                                                         vecNumAudioChannels ) );
 
-            // get current number of CELT coded bytes
+            // get current number of CELT coded bytes, the network frame
+            // additionally contains the redundant frame in case of forward
+            // error correction
             const int iCeltNumCodedBytes =
-                vecChannels[iCurChanID].GetNetwFrameSize();
+                HotChanState.viNetwCodedFrameSize[iCurChanID];
 
-            // CELT encoding
-            CVector<unsigned char> vecCeltData ( iCeltNumCodedBytes );
+            const int iFecNumCodedBytes =
+                HotChanState.viNetwFecNumBytes[iCurChanID];
 
-            if ( vecChannels[iCurChanID].GetNumAudioChannels() == 1 )
-            {
-                // mono:
+            const int iNetwFrameSize =
+                HotChanState.viNetwFrameSize[iCurChanID];
 
-                if ( vecChannels[iCurChanID].GetAudioCompressionType() == CT_CELT )
-                {
-                    cc6_celt_encode ( CeltEncoderMono[iCurChanID],
-                                      &vecsSendData[0],
-                                      NULL,
-                                      &vecCeltData[0],
-                                      iCeltNumCodedBytes );
-                }
-                else
+            const EAudComprType eAudioCompressionType =
+                HotChanState.veAudioCompressionType[iCurChanID];
+
+            // CELT encoding, the coded data is directly written in the send
+            // buffer of the channel (no intermediate copy)
+            uint8_t* pbyCodedData =
+                vecChannels[iCurChanID].GetSendBufPointer ( iNetwFrameSize );
+
+            if ( pbyCodedData != NULL )
+            {
+                if ( HotChanState.viNumAudioChannels[iCurChanID] == 1 )
                 {
+                    // mono:
+
+                    if ( eAudioCompressionType == CT_CELT )
+                    {
+                        cc6_celt_encode ( CeltEncoderMono[iCurChanID],
+                                          &vecsSendData[0],
+                                          NULL,
+                                          pbyCodedData,
+                                          iCeltNumCodedBytes );
+                    }
+                    else
+                    {
 
 // TODO find a better place than this: the setting does not change all the time
 //      so for speed optimization it would be better to set it only if the network
@@ -867,45 +1111,69 @@ void CServer::OnTimer()
 opus_custom_encoder_ctl ( OpusEncoderMono[iCurChanID],
                           OPUS_SET_BITRATE ( CalcBitRateBitsPerSecFromCodedBytes ( iCeltNumCodedBytes ) ) );
 
-                    opus_custom_encode ( OpusEncoderMono[iCurChanID],
-                                         &vecsSendData[0],
-                                         SYSTEM_FRAME_SIZE_SAMPLES,
-                                         &vecCeltData[0],
-                                         iCeltNumCodedBytes );
-                }
-            }
-            else
-            {
-                // stereo:
-
-                if ( vecChannels[iCurChanID].GetAudioCompressionType() == CT_CELT )
-                {
-                    cc6_celt_encode ( CeltEncoderStereo[iCurChanID],
-                                      &vecsSendData[0],
-                                      NULL,
-                                      &vecCeltData[0],
-                                      iCeltNumCodedBytes );
+                        opus_custom_encode ( OpusEncoderMono[iCurChanID],
+                                             &vecsSendData[0],
+                                             SYSTEM_FRAME_SIZE_SAMPLES,
+                                             pbyCodedData,
+                                             iCeltNumCodedBytes );
+
+                        if ( iFecNumCodedBytes > 0 )
+                        {
+                            // redundant frame behind the coded frame
+                            opus_custom_encode ( OpusEncoderFecMono[iCurChanID],
+                                                 &vecsSendData[0],
+                                                 SYSTEM_FRAME_SIZE_SAMPLES,
+                                                 pbyCodedData + iCeltNumCodedBytes,
+                                                 iFecNumCodedBytes );
+                        }
+                    }
                 }
                 else
                 {
+                    // stereo:
+
+                    if ( eAudioCompressionType == CT_CELT )
+                    {
+                        cc6_celt_encode ( CeltEncoderStereo[iCurChanID],
+                                          &vecsSendData[0],
+                                          NULL,
+                                          pbyCodedData,
+                                          iCeltNumCodedBytes );
+                    }
+                    else
+                    {
 // TODO find a better place than this: the setting does not change all the time
 //      so for speed optimization it would be better to set it only if the network
 //      frame size is changed
 opus_custom_encoder_ctl ( OpusEncoderStereo[iCurChanID],
                           OPUS_SET_BITRATE ( CalcBitRateBitsPerSecFromCodedBytes ( iCeltNumCodedBytes ) ) );
 
-                    opus_custom_encode ( OpusEncoderStereo[iCurChanID],
-                                         &vecsSendData[0],
-                                         SYSTEM_FRAME_SIZE_SAMPLES,
-                                         &vecCeltData[0],
-                                         iCeltNumCodedBytes );
+                        opus_custom_encode ( OpusEncoderStereo[iCurChanID],
+                                             &vecsSendData[0],
+                                             SYSTEM_FRAME_SIZE_SAMPLES,
+                                             pbyCodedData,
+                                             iCeltNumCodedBytes );
+
+                        if ( iFecNumCodedBytes > 0 )
+                        {
+                            // redundant frame behind the coded frame
+                            opus_custom_encode ( OpusEncoderFecStereo[iCurChanID],
+                                                 &vecsSendData[0],
+                                                 SYSTEM_FRAME_SIZE_SAMPLES,
+                                                 pbyCodedData + iCeltNumCodedBytes,
+                                                 iFecNumCodedBytes );
+                        }
+                    }
                 }
-            }
 
-            // send separate mix to current clients
-            Socket.SendPacket (
-                vecChannels[iCurChanID].PrepSendPacket ( vecCeltData ),
-                vecChannels[iCurChanID].GetAddress() );
+                // send separate mix to current clients if the network packet
+                // is complete
+                if ( vecChannels[iCurChanID].PrepSendPacket ( iNetwFrameSize ) )
+                {
+                    Socket.SendPacket ( vecChannels[iCurChanID].GetSendPacket(),
+                                        vecChannels[iCurChanID].GetAddress() );
+                }
+            }
 
             // update socket buffer size
             vecChannels[iCurChanID].UpdateSocketBufferSize();
@@ -943,6 +1211,13 @@ CVector<int16_t> CServer::ProcessData ( const int                   iCurIndex,
         // Mono target channel -------------------------------------------------
         for ( j = 0; j < iNumClients; j++ )
         {
+            // a source with zero gain (e.g. the own signal of a client which
+            // monitors itself locally) does not contribute to the mix
+            if ( vecdGains[j] == static_cast<double> ( 0.0 ) )
+            {
+                continue;
+            }
+
             // if channel gain is 1, avoid multiplication for speed optimization
             if ( vecdGains[j] == static_cast<double> ( 1.0 ) )
             {
@@ -996,6 +1271,13 @@ CVector<int16_t> CServer::ProcessData ( const int                   iCurIndex,
         // Stereo target channel -----------------------------------------------
         for ( j = 0; j < iNumClients; j++ )
         {
+            // a source with zero gain (e.g. the own signal of a client which
+            // monitors itself locally) does not contribute to the mix
+            if ( vecdGains[j] == static_cast<double> ( 0.0 ) )
+            {
+                continue;
+            }
+
             // if channel gain is 1, avoid multiplication for speed optimization
             if ( vecdGains[j] == static_cast<double> ( 1.0 ) )
             {
@@ -1078,18 +1360,86 @@ CVector<CChannelInfo> CServer::CreateChannelList()
 
 void CServer::CreateAndSendChanListForAllConChannels()
 {
+    int i;
+
     // create channel list
     CVector<CChannelInfo> vecChanInfo ( CreateChannelList() );
 
+    // get the changes compared to the last published list
+    CVector<CChannelInfo> vecChangedChanInfo ( 0 );
+    CVector<int>          vecRemovedChanIDs ( 0 );
+    CVector<int>          vecPublishedIdx ( MAX_NUM_CHANNELS, -1 );
+
+    for ( i = 0; i < vecChanListPublished.Size(); i++ )
+    {
+        vecPublishedIdx[vecChanListPublished[i].iChanID] = i;
+    }
+
+    for ( i = 0; i < vecChanInfo.Size(); i++ )
+    {
+        const int iPubIdx = vecPublishedIdx[vecChanInfo[i].iChanID];
+
+        if ( ( iPubIdx < 0 ) ||
+             ( vecChanListPublished[iPubIdx] != vecChanInfo[i] ) ||
+             ( vecChanListPublished[iPubIdx].iIpAddr != vecChanInfo[i].iIpAddr ) )
+        {
+            vecChangedChanInfo.Add ( vecChanInfo[i] );
+        }
+
+        // mark the channel as still present
+        vecPublishedIdx[vecChanInfo[i].iChanID] = -1;
+    }
+
+    for ( i = 0; i < vecChanListPublished.Size(); i++ )
+    {
+        if ( vecPublishedIdx[vecChanListPublished[i].iChanID] >= 0 )
+        {
+            vecRemovedChanIDs.Add ( vecChanListPublished[i].iChanID );
+        }
+    }
+
+    const bool bListHasChanged =
+        ( vecChangedChanInfo.Size() > 0 ) || ( vecRemovedChanIDs.Size() > 0 );
+
+    const int iBaseVersion = iChanListVersion;
+
+    if ( bListHasChanged )
+    {
+        // new list version (the full list version is never used)
+        iChanListVersion = ( iChanListVersion + 1 ) % FULL_CONN_CLIENTS_LIST_VERSION;
+
+        vecChanListPublished.Init ( vecChanInfo.Size() );
+        vecChanListPublished = vecChanInfo;
+    }
+
     // now send connected channels list to all connected clients
-    for ( int i = 0; i < iNumChannels; i++ )
+    for ( i = 0; i < iNumChannels; i++ )
     {
         if ( vecChannels[i].IsConnected() )
         {
-            // send message
-// #### COMPATIBILITY OLD VERSION, TO BE REMOVED ####
-vecChannels[i].CreateConClientListNameMes ( vecChanInfo );
-            vecChannels[i].CreateConClientListMes ( vecChanInfo );
+            if ( vecChannels[i].IsPeerFeatureSupported ( PROT_FEATURE_CLIENT_LIST_DELTA ) &&
+                 ( vecChanListVersionSent[i] == iBaseVersion ) )
+            {
+                // the client has the previous list, only send the changes
+                if ( bListHasChanged )
+                {
+                    vecChannels[i].CreateConClientListDeltaMes ( iBaseVersion,
+                                                                 iChanListVersion,
+                                                                 vecChangedChanInfo,
+                                                                 vecRemovedChanIDs );
+
+                    vecChanListVersionSent[i] = iChanListVersion;
+                }
+            }
+            else
+            {
+                SendCompleteChanList ( i, vecChanInfo );
+            }
+        }
+        else
+        {
+            // a new client on this channel does not have any list
+            vecChanListVersionSent[i] = INVALID_CONN_CLIENTS_LIST_VERSION;
         }
     }
 
@@ -1106,9 +1456,33 @@ void CServer::CreateAndSendChanListForThisChan ( const int iCurChanID )
     CVector<CChannelInfo> vecChanInfo ( CreateChannelList() );
 
     // now send connected channels list to the channel with the ID "iCurChanID"
+    SendCompleteChanList ( iCurChanID, vecChanInfo );
+}
+
+void CServer::SendCompleteChanList ( const int                    iCurChanID,
+                                     const CVector<CChannelInfo>& vecChanInfo )
+{
+    if ( vecChannels[iCurChanID].IsPeerFeatureSupported ( PROT_FEATURE_CLIENT_LIST_DELTA ) )
+    {
+        // the complete list is sent as changes which are not based on a
+        // version, we have to use the published list since the following
+        // changes are based on it
+        vecChannels[iCurChanID].CreateConClientListDeltaMes ( FULL_CONN_CLIENTS_LIST_VERSION,
+                                                              iChanListVersion,
+                                                              vecChanListPublished,
+                                                              CVector<int> ( 0 ) );
+
+        vecChanListVersionSent[iCurChanID] = iChanListVersion;
+    }
+    else
+    {
+        // old clients only understand the complete list messages
 // #### COMPATIBILITY OLD VERSION, TO BE REMOVED ####
 vecChannels[iCurChanID].CreateConClientListNameMes ( vecChanInfo );
-    vecChannels[iCurChanID].CreateConClientListMes ( vecChanInfo );
+        vecChannels[iCurChanID].CreateConClientListMes ( vecChanInfo );
+
+        vecChanListVersionSent[iCurChanID] = INVALID_CONN_CLIENTS_LIST_VERSION;
+    }
 }
 
 void CServer::CreateAndSendChatTextForAllConChannels ( const int      iCurChanID,
@@ -1134,6 +1508,12 @@ void CServer::CreateAndSendChatTextForAllConChannels ( const int      iCurChanID
         QTime::currentTime().toString ( "hh:mm:ss AP" ) + ") <b>" + ChanName +
         "</b></font> " + strChatText;
 
+    // the message is identical for all clients, therefore it is serialized
+    // only once and per channel only the counter and the CRC are updated
+    CProtocol::CBroadcastMessage ChatTextMes;
+
+    CProtocol::PrepareChatTextBroadcastMes ( ChatTextMes, strActualMessageText );
+
 
     // Send chat text to all connected clients ---------------------------------
     for ( int i = 0; i < iNumChannels; i++ )
@@ -1141,7 +1521,7 @@ void CServer::CreateAndSendChatTextForAllConChannels ( const int      iCurChanID
         if ( vecChannels[i].IsConnected() )
         {
             // send message
-            vecChannels[i].CreateChatTextMes ( strActualMessageText );
+            vecChannels[i].CreateBroadcastMes ( ChatTextMes );
         }
     }
 }
@@ -1219,11 +1599,13 @@ int CServer::CheckAddr ( const CHostAddress& Addr )
 
 bool CServer::PutData ( const CVector<uint8_t>& vecbyRecBuf,
                         const int               iNumBytesRead,
-                        const CHostAddress&     HostAdr )
+                        const CHostAddress&     HostAdr,
+                        const int64_t           iRecTimeNs )
 {
     bool bChanOK                        = true; // init with ok, might be overwritten
     bool bNewChannelReserved            = false;
     bool bIsNotEvaluatedProtocolMessage = false;
+    bool bForwardToMainThread           = false;
 
     Mutex.lock();
     {
@@ -1233,11 +1615,20 @@ bool CServer::PutData ( const CVector<uint8_t>& vecbyRecBuf,
 
         if ( iCurChanID == INVALID_CHANNEL_ID )
         {
+            if ( QThread::currentThread() != thread() )
+            {
+                // we are called from the receive thread of an additional
+                // socket: the connection less messages and the set up of a
+                // new channel are not thread safe (e.g. the protocol timers)
+                // and must be processed in the main thread
+                bChanOK              = false;
+                bForwardToMainThread = true;
+            }
             // this is a new client, we then first check if this is a connection
             // less message before we create a new official channel
-            if ( ConnLessProtocol.ParseConnectionLessMessageWithFrame ( vecbyRecBuf,
-                                                                        iNumBytesRead,
-                                                                        HostAdr ) )
+            else if ( ConnLessProtocol.ParseConnectionLessMessageWithFrame ( vecbyRecBuf,
+                                                                             iNumBytesRead,
+                                                                             HostAdr ) )
             {
                 // a new client is calling, look for free channel
                 iCurChanID = GetFreeChan();
@@ -1253,14 +1644,7 @@ bool CServer::PutData ( const CVector<uint8_t>& vecbyRecBuf,
 
                     // reset the channel gains of current channel, at the same
                     // time reset gains of this channel ID for all other channels
-                    for ( int i = 0; i < iNumChannels; i++ )
-                    {
-                        vecChannels[iCurChanID].SetGain ( i, (double) 1.0 );
-
-                        // other channels (we do not distinguish the case if
-                        // i == iCurChanID for simplicity)
-                        vecChannels[i].SetGain ( iCurChanID, (double) 1.0 );
-                    }
+                    GainMatrix.ResetGains ( iCurChanID );
 
                     // set flag for new reserved channel
                     bNewChannelReserved = true;
@@ -1287,7 +1671,9 @@ bool CServer::PutData ( const CVector<uint8_t>& vecbyRecBuf,
         if ( bChanOK )
         {
             // put packet in socket buffer
-            switch ( vecChannels[iCurChanID].PutData ( vecbyRecBuf, iNumBytesRead ) )
+            switch ( vecChannels[iCurChanID].PutData ( vecbyRecBuf,
+                                                       iNumBytesRead,
+                                                       iRecTimeNs ) )
             {
             case PS_AUDIO_OK:
                 PostWinMessage ( MS_JIT_BUF_PUT, MUL_COL_LED_GREEN, iCurChanID );
@@ -1357,6 +1743,15 @@ CreateAndSendChanListForAllConChannels();
     }
     Mutex.unlock();
 
+    if ( bForwardToMainThread )
+    {
+        // the signal is queued since the server object lives in the main thread
+        emit UnknownAddrPacketReceived ( vecbyRecBuf,
+                                         iNumBytesRead,
+                                         HostAdr,
+                                         iRecTimeNs );
+    }
+
     // we do not want the server to be started on a protocol message but only on
     // an audio packet -> consider "bIsNotEvaluatedProtocolMessage", too
     return bChanOK && ( !bIsNotEvaluatedProtocolMessage );
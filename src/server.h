@@ -124,7 +124,10 @@ public:
               const QString& strCentralServer,
               const QString& strServerInfo,
               const QString& strNewWelcomeMessage,
-              const bool     bNCentServPingServerInList );
+              const bool     bNCentServPingServerInList,
+              const int      iNumSockets = 1 );
+
+    virtual ~CServer();
 
     void Start();
     void Stop();
@@ -132,7 +135,8 @@ public:
 
     bool PutData ( const CVector<uint8_t>& vecbyRecBuf,
                    const int               iNumBytesRead,
-                   const CHostAddress&     HostAdr );
+                   const CHostAddress&     HostAdr,
+                   const int64_t           iRecTimeNs );
 
     void GetConCliParam ( CVector<CHostAddress>& vecHostAddresses,
                           CVector<QString>&      vecsName,
@@ -200,9 +204,12 @@ protected:
     CVector<CChannelInfo> CreateChannelList();
     void CreateAndSendChanListForAllConChannels();
     void CreateAndSendChanListForThisChan ( const int iCurChanID );
+    void SendCompleteChanList ( const int                    iCurChanID,
+                                const CVector<CChannelInfo>& vecChanInfo );
     void CreateAndSendChatTextForAllConChannels ( const int      iCurChanID,
                                                   const QString& strChatText );
     void WriteHTMLChannelList();
+    bool UpdateHotChanState();
 
     CVector<int16_t> ProcessData ( const int                   iCurIndex,
                                    CVector<CVector<int16_t> >& vecvecsData,
@@ -215,9 +222,25 @@ protected:
     // copy constructor/operator
     CChannel            vecChannels[MAX_NUM_CHANNELS];
     int                 iNumChannels;
+
+    // gains of all channels, the mixer reads them without locking
+    CChannelGainMatrix  GainMatrix;
+
+    // per tick relevant state of all channels
+    CChannelHotState    HotChanState;
+
+    // connection time-out of all channels
+    CChannelTimeOutWheel TimeOutWheel;
+
     CProtocol           ConnLessProtocol;
     QMutex              Mutex;
 
+    // last published connected clients list and its version, the clients
+    // which support it only get the changes of the list
+    CVector<CChannelInfo> vecChanListPublished;
+    int                 iChanListVersion;
+    int                 vecChanListVersionSent[MAX_NUM_CHANNELS];
+
     // audio encoder/decoder
     cc6_CELTMode*       CeltModeMono[MAX_NUM_CHANNELS];
     cc6_CELTEncoder*    CeltEncoderMono[MAX_NUM_CHANNELS];
@@ -230,12 +253,19 @@ protected:
     OpusCustomDecoder*  OpusDecoderMono[MAX_NUM_CHANNELS];
     OpusCustomEncoder*  OpusEncoderStereo[MAX_NUM_CHANNELS];
     OpusCustomDecoder*  OpusDecoderStereo[MAX_NUM_CHANNELS];
+    OpusCustomEncoder*  OpusEncoderFecMono[MAX_NUM_CHANNELS];
+    OpusCustomDecoder*  OpusDecoderFecMono[MAX_NUM_CHANNELS];
+    OpusCustomEncoder*  OpusEncoderFecStereo[MAX_NUM_CHANNELS];
+    OpusCustomDecoder*  OpusDecoderFecStereo[MAX_NUM_CHANNELS];
 
     CVector<QString>    vstrChatColors;
 
     // actual working objects
     CSocket             Socket;
 
+    // additional sockets on the same port number with own receive threads
+    CVector<CReceiveThreadSocket*> vecpReceiveThreadSockets;
+
     // logging
     CServerLogging      Logging;
 
@@ -259,6 +289,11 @@ signals:
     void Started();
     void Stopped();
 
+    void UnknownAddrPacketReceived ( CVector<uint8_t> vecbyRecBuf,
+                                     int              iNumBytesRead,
+                                     CHostAddress     HostAdr,
+                                     qint64           iRecTimeNs );
+
 public slots:
     void OnTimer();
     void OnSendProtMessage ( int iChID, CVector<uint8_t> vecMessage );
@@ -292,8 +327,8 @@ public slots:
         }
     }
 
-    void OnCLReqServerList ( CHostAddress InetAddr )
-        { ServerListManager.CentralServerQueryServerList ( InetAddr ); }
+    void OnCLReqServerList ( CHostAddress InetAddr, bool bPartsSupported )
+        { ServerListManager.CentralServerQueryServerList ( InetAddr, bPartsSupported ); }
 
     void OnCLRegisterServerReceived ( CHostAddress    InetAddr,
                                       CServerCoreInfo ServerInfo )
@@ -307,6 +342,14 @@ public slots:
     }
 
     void OnCLDisconnection ( CHostAddress InetAddr );
+    void OnCLAudioDelayMeasReceived ( CHostAddress InetAddr,
+                                      int          iMs,
+                                      int          iJitBufFill );
+
+    void OnUnknownAddrPacketReceived ( CVector<uint8_t> vecbyRecBuf,
+                                       int              iNumBytesRead,
+                                       CHostAddress     HostAdr,
+                                       qint64           iRecTimeNs );
 
 
     // CODE TAG: MAX_NUM_CHANNELS_TAG
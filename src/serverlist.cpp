@@ -377,15 +377,24 @@ void CServerListManager::CentralServerUnregisterServer ( const CHostAddress& Ine
     }
 }
 
-void CServerListManager::CentralServerQueryServerList ( const CHostAddress& InetAddr )
+void CServerListManager::CentralServerQueryServerList ( const CHostAddress& InetAddr,
+                                                       const bool          bPartsSupported )
 {
     QMutexLocker locker ( &Mutex );
 
     if ( bIsCentralServer && bEnabled )
     {
-        const int iCurServerListSize = ServerList.size();
+        // old clients get the list in one message which must be limited
+        const int iCurServerListSize = bPartsSupported ?
+            ServerList.size() :
+            qMin ( ServerList.size(), MAX_NUM_SERVERS_IN_LEGACY_SERVER_LIST );
+
+        // the request is not authenticated, therefore the NAT hole punching
+        // (which causes a message to every listed server) is limited
+        const bool bPunchingAllowed =
+            CentralServerIsPunchingAllowed ( InetAddr.InetAddr );
 
-        // allocate memory for the entire list
+        // allocate memory for the list which is sent
         CVector<CServerInfo> vecServerInfo ( iCurServerListSize );
 
         // copy the list (we have to copy it since the message requires
@@ -418,9 +427,9 @@ void CServerListManager::CentralServerQueryServerList ( const CHostAddress& Inet
                             ServerList[iIdx].iLocalPortNumber;
                     }
                 }
-                else
+                else if ( bPunchingAllowed )
                 {
-                    // create "send empty message" for all registered servers
+                    // create "send empty message" for all sent servers
                     // (except of the very first list entry since this is this
                     // server (central server) per definition) and also it is
                     // not required to send this message, if the server is on
@@ -433,10 +442,53 @@ void CServerListManager::CentralServerQueryServerList ( const CHostAddress& Inet
         }
 
         // send the server list to the client
-        pConnLessProtocol->CreateCLServerListMes ( InetAddr, vecServerInfo );
+        if ( bPartsSupported )
+        {
+            // the list is split in parts which fit in one network packet
+            pConnLessProtocol->CreateCLServerListPartsMes ( InetAddr, vecServerInfo );
+        }
+        else
+        {
+            pConnLessProtocol->CreateCLServerListMes ( InetAddr, vecServerInfo );
+        }
     }
 }
 
+bool CServerListManager::CentralServerIsPunchingAllowed ( const QHostAddress& InetAddr )
+{
+/*
+    note: this function must be called inside the mutex region
+*/
+    // remove the addresses for which the punching interval has passed
+    QMutableHashIterator<QHostAddress, QTime> PunchIt ( PunchTimes );
+
+    while ( PunchIt.hasNext() )
+    {
+        PunchIt.next();
+
+        if ( PunchIt.value().elapsed() > SERVLIST_PUNCH_INTERVAL_MS )
+        {
+            PunchIt.remove();
+        }
+    }
+
+    // a client which requests the list again (e.g. since the list message
+    // was lost) gets no new punching within the interval and the number of
+    // addresses is limited since the source address of the request can be
+    // spoofed
+    if ( PunchTimes.contains ( InetAddr ) ||
+         ( PunchTimes.size() >= SERVLIST_MAX_NUM_PUNCH_ADDR ) )
+    {
+        return false;
+    }
+
+    QTime PunchTime;
+    PunchTime.start();
+    PunchTimes.insert ( InetAddr, PunchTime );
+
+    return true;
+}
+
 
 /* Slave server functionality *************************************************/
 void CServerListManager::OnTimerPingCentralServer()
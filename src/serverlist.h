@@ -63,6 +63,7 @@ private network.
 #include <QObject>
 #include <QLocale>
 #include <QList>
+#include <QHash>
 #include <QTimer>
 #include <QMutex>
 #include "global.h"
@@ -155,7 +156,8 @@ public:
 
     void CentralServerUnregisterServer ( const CHostAddress& InetAddr );
 
-    void CentralServerQueryServerList ( const CHostAddress& InetAddr );
+    void CentralServerQueryServerList ( const CHostAddress& InetAddr,
+                                        const bool          bPartsSupported );
 
     void SlaveServerUnregister() { SlaveServerRegisterServer ( false ); }
 
@@ -179,6 +181,7 @@ public:
 
 protected:
     void SlaveServerRegisterServer ( const bool bIsRegister );
+    bool CentralServerIsPunchingAllowed ( const QHostAddress& InetAddr );
 
     QTimer                  TimerPollList;
     QTimer                  TimerRegistering;
@@ -189,6 +192,9 @@ protected:
 
     QList<CServerListEntry> ServerList;
 
+    // requesting addresses for which the NAT hole punching was done recently
+    QHash<QHostAddress, QTime> PunchTimes;
+
     quint16                 iPortNumber;
     QString                 strCentralServerAddress;
     int                     iNumPredefinedServers;
@@ -116,6 +116,30 @@ void CSettings::Load()
             pClient->SetReverbOnLeftChan ( bValue );
         }
 
+        // local monitoring
+        if ( GetFlagIniSet ( IniXMLDocument, "client", "localmonitor", bValue ) )
+        {
+            pClient->SetLocalMonitoring ( bValue );
+        }
+
+        // local monitoring level
+        if ( GetNumericIniSet ( IniXMLDocument, "client", "localmonitorlevel",
+             0, AUD_LOCAL_MONITOR_MAX, iValue ) )
+        {
+            pClient->SetLocalMonitorLevel ( iValue );
+        }
+
+        // cached capabilities of the sound card device: make sure this setting
+        // is set BEFORE the sound card device is set, otherwise the sound card
+        // capabilities are probed on the device selection
+        if ( GetNumericIniSet ( IniXMLDocument, "client", "sndcrdcaps",
+             0, SND_CRD_CAPS_ALL, iValue ) )
+        {
+            pClient->SetSndCrdCaps (
+                GetIniSetting ( IniXMLDocument, "client", "sndcrdcapsdev" ),
+                iValue );
+        }
+
         // sound card selection
         // special case with this setting: the sound card initialization depends
         // on this setting call, therefore, if no setting file parameter could
@@ -225,6 +249,12 @@ void CSettings::Load()
             pClient->SetUseStereo ( bValue );
         }
 
+        // flag whether forward error correction of the audio stream is used
+        if ( GetFlagIniSet ( IniXMLDocument, "client", "audiofec", bValue ) )
+        {
+            pClient->SetUseAudioFec ( bValue );
+        }
+
         // central server address
         pClient->SetServerListCentralServerAddress (
             GetIniSetting ( IniXMLDocument, "client", "centralservaddr" ) );
@@ -367,6 +397,27 @@ void CSettings::Save()
         SetFlagIniSet ( IniXMLDocument, "client", "reverblchan",
             pClient->IsReverbOnLeftChan() );
 
+        // local monitoring
+        SetFlagIniSet ( IniXMLDocument, "client", "localmonitor",
+            pClient->GetLocalMonitoring() );
+
+        // local monitoring level
+        SetNumericIniSet ( IniXMLDocument, "client", "localmonitorlevel",
+            pClient->GetLocalMonitorLevel() );
+
+        // cached capabilities of the current sound card device
+        QString strSndCrdCapsDev;
+        int     iSndCrdCaps;
+
+        if ( pClient->GetSndCrdCaps ( strSndCrdCapsDev, iSndCrdCaps ) )
+        {
+            PutIniSetting ( IniXMLDocument, "client", "sndcrdcapsdev",
+                strSndCrdCapsDev );
+
+            SetNumericIniSet ( IniXMLDocument, "client", "sndcrdcaps",
+                iSndCrdCaps );
+        }
+
         // sound card selection
         SetNumericIniSet ( IniXMLDocument, "client", "auddevidx",
             pClient->GetSndCrdDev() );
@@ -419,6 +470,10 @@ void CSettings::Save()
         SetFlagIniSet ( IniXMLDocument, "client", "stereoaudio",
             pClient->GetUseStereo() );
 
+        // flag whether forward error correction of the audio stream is used
+        SetFlagIniSet ( IniXMLDocument, "client", "audiofec",
+            pClient->GetUseAudioFec() );
+
         // central server address
         PutIniSetting ( IniXMLDocument, "client", "centralservaddr",
             pClient->GetServerListCentralServerAddress() );
@@ -24,33 +24,75 @@
 
 #include "socket.h"
 #include "server.h"
+#ifdef __linux__
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+# include <string.h>
+# include <time.h>
+
+// SO_REUSEPORT is available since Linux 3.9 but older C library headers do
+// not define it
+# ifndef SO_REUSEPORT
+#  define SO_REUSEPORT 15
+# endif
+#endif
 
 
 /* Implementation *************************************************************/
+CSocket::~CSocket()
+{
+#ifdef __linux__
+    if ( iTimeStampSocketDesc >= 0 )
+    {
+        // the notifier must be deleted before the descriptor is closed
+        delete pTimeStampSocketNotifier;
+        ::close ( iTimeStampSocketDesc );
+    }
+#endif
+}
+
 void CSocket::Init ( const quint16 iPortNumber )
 {
     // allocate memory for network receive and send buffer in samples
     vecbyRecBuf.Init ( MAX_SIZE_BYTES_NETW_BUF );
 
+#ifdef __linux__
+    pTimeStampSocketNotifier = NULL;
+    iTimeStampSocketDesc     = -1;
+    bTimeStampSocketIsIPv6   = false;
+#endif
+
     // initialize the listening socket
     bool bSuccess;
 
     if ( bIsClient )
     {
-        // Per definition use the port number plus ten for the client to make
-        // it possible to run server and client on the same computer. If the
-        // port is not available, try "NUM_SOCKET_PORTS_TO_TRY" times with
-        // incremented port numbers
-        quint16 iClientPortIncrement = 10; // start value: port nubmer plus ten
-        bSuccess                     = false; // initialization for while loop
-        while ( !bSuccess &&
-                ( iClientPortIncrement <= NUM_SOCKET_PORTS_TO_TRY ) )
+        if ( iPortNumber == 0 )
         {
+            // port number zero: the operating system chooses a free port
+            // (used by the virtual clients of the load generator which need
+            // much more ports than we would try out below)
             bSuccess = SocketDevice.bind (
-                QHostAddress( QHostAddress::Any ),
-                iPortNumber + iClientPortIncrement );
+                QHostAddress( QHostAddress::Any ), 0 );
+        }
+        else
+        {
+            // Per definition use the port number plus ten for the client to
+            // make it possible to run server and client on the same computer.
+            // If the port is not available, try "NUM_SOCKET_PORTS_TO_TRY"
+            // times with incremented port numbers
+            quint16 iClientPortIncrement = 10; // start value: port nubmer plus ten
+            bSuccess                     = false; // initialization for while loop
+            while ( !bSuccess &&
+                    ( iClientPortIncrement <= NUM_SOCKET_PORTS_TO_TRY ) )
+            {
+                bSuccess = SocketDevice.bind (
+                    QHostAddress( QHostAddress::Any ),
+                    iPortNumber + iClientPortIncrement );
 
-            iClientPortIncrement++;
+                iClientPortIncrement++;
+            }
         }
     }
     else
@@ -58,8 +100,17 @@ void CSocket::Init ( const quint16 iPortNumber )
         // for the server, only try the given port number and do not try out
         // other port numbers to bind since it is imporatant that the server
         // gets the desired port number
-        bSuccess = SocketDevice.bind (
-            QHostAddress ( QHostAddress::Any ), iPortNumber );
+#ifdef __linux__
+        if ( bUseReusePort )
+        {
+            bSuccess = BindReusePort ( iPortNumber );
+        }
+        else
+#endif
+        {
+            bSuccess = SocketDevice.bind (
+                QHostAddress ( QHostAddress::Any ), iPortNumber );
+        }
     }
 
     if ( !bSuccess )
@@ -69,77 +120,307 @@ void CSocket::Init ( const quint16 iPortNumber )
             "the software is already running).", "Network Error" );
     }
 
-    // connect the "activated" signal
-#ifdef ENABLE_RECEIVE_SOCKET_IN_SEPARATE_THREAD
-    if ( bIsClient )
+#ifdef __linux__
+    // enable the kernel receive time stamps so that the packet inter-arrival
+    // time statistic is not influenced by the delay of our own event loop
+    const int iEnable = 1;
+
+    if ( setsockopt ( SocketDevice.socketDescriptor(), SOL_SOCKET,
+                      SO_TIMESTAMPNS, &iEnable, sizeof ( iEnable ) ) == 0 )
     {
-        // We have to use a blocked queued connection since in case we use a
-        // separate socket thread, the "readyRead" signal would occur and our
-        // "OnDataReceived" function would be run in another thread. This could
-        // lead to a situation that a new "readRead" occurs while the processing
-        // of the previous signal was not finished -> the error: "Multiple
-        // socket notifiers for same socket" may occur.
-        QObject::connect ( &SocketDevice, SIGNAL ( readyRead() ),
-            this, SLOT ( OnDataReceived() ), Qt::BlockingQueuedConnection );
+        iTimeStampSocketDesc = dup ( SocketDevice.socketDescriptor() );
     }
-    else
+
+    if ( iTimeStampSocketDesc >= 0 )
     {
-        // the server does not use a separate socket thread right now, in that
-        // case we must not use the blocking queued connection, otherwise we
-        // would get a dead lock
-        QObject::connect ( &SocketDevice, SIGNAL ( readyRead() ),
+        // depending on the Qt version the socket is either IPv4 or dual stack
+        // IPv6, the destination address for sending must be of the same type
+        sockaddr_storage LocalAddr;
+        socklen_t        iLocalAddrLen = sizeof ( LocalAddr );
+
+        if ( getsockname ( iTimeStampSocketDesc,
+                           reinterpret_cast<sockaddr*> ( &LocalAddr ),
+                           &iLocalAddrLen ) == 0 )
+        {
+            bTimeStampSocketIsIPv6 = ( LocalAddr.ss_family == AF_INET6 );
+        }
+
+        // we read all packets on the duplicate descriptor, therefore the
+        // "readyRead" signal of the socket device must not be connected
+        pTimeStampSocketNotifier = new QSocketNotifier ( iTimeStampSocketDesc,
+                                                         QSocketNotifier::Read,
+                                                         this );
+
+        QObject::connect ( pTimeStampSocketNotifier, SIGNAL ( activated ( int ) ),
             this, SLOT ( OnDataReceived() ) );
+
+        return;
     }
-#else
+#endif
+
+    // connect the "readyRead" signal (note that the socket device is a child
+    // of this object, i.e., if this object is moved to a separate receive
+    // thread, the signal and the slot are both in that thread and the received
+    // packets are processed directly without a thread transition)
     QObject::connect ( &SocketDevice, SIGNAL ( readyRead() ),
         this, SLOT ( OnDataReceived() ) );
-#endif
 }
 
 void CSocket::SendPacket ( const CVector<uint8_t>& vecbySendBuf,
                            const CHostAddress&     HostAddr )
 {
+#ifdef __linux__
+    if ( iTimeStampSocketDesc >= 0 )
+    {
+        // send on the descriptor directly, no locking required
+        SendPacketNative ( vecbySendBuf, HostAddr );
+        return;
+    }
+#endif
+
     QMutexLocker locker ( &Mutex );
 
     const int iVecSizeOut = vecbySendBuf.Size();
 
     if ( iVecSizeOut != 0 )
     {
-        // send packet through network (we have to convert the constant unsigned
-        // char vector in "const char*", for this we first convert the const
-        // uint8_t vector in a read/write uint8_t vector and then do the cast to
-        // const char*)
+        // send packet through network (we directly access the memory of the
+        // vector to avoid a copy of the data)
         SocketDevice.writeDatagram (
-            (const char*) &( (CVector<uint8_t>) vecbySendBuf )[0],
+            reinterpret_cast<const char*> ( &vecbySendBuf.front() ),
             iVecSizeOut,
             HostAddr.InetAddr,
             HostAddr.iPort );
     }
 }
 
-void CSocket::OnDataReceived()
+#ifdef __linux__
+void CSocket::SendPacketNative ( const CVector<uint8_t>& vecbySendBuf,
+                                 const CHostAddress&     HostAddr )
 {
-    while ( SocketDevice.hasPendingDatagrams() )
+    const int iVecSizeOut = vecbySendBuf.Size();
+
+    if ( iVecSizeOut == 0 )
     {
-        QHostAddress SenderAddress;
-        quint16      SenderPort;
+        return;
+    }
+
+    // the host addresses are always IPv4, for a dual stack socket we have to
+    // use the IPv4-mapped IPv6 address
+    const quint32    iIPv4Addr = HostAddr.InetAddr.toIPv4Address();
+    sockaddr_storage DestAddr;
+    socklen_t        iDestAddrLen;
 
-        // read block from network interface and query address of sender
-        const int iNumBytesRead =
-            SocketDevice.readDatagram ( (char*) &vecbyRecBuf[0],
-                                        MAX_SIZE_BYTES_NETW_BUF,
-                                        &SenderAddress,
-                                        &SenderPort );
+    memset ( &DestAddr, 0, sizeof ( DestAddr ) );
+
+    if ( bTimeStampSocketIsIPv6 )
+    {
+        sockaddr_in6* pDestAddr6 = reinterpret_cast<sockaddr_in6*> ( &DestAddr );
+
+        pDestAddr6->sin6_family           = AF_INET6;
+        pDestAddr6->sin6_port             = htons ( HostAddr.iPort );
+        pDestAddr6->sin6_addr.s6_addr[10] = 0xFF;
+        pDestAddr6->sin6_addr.s6_addr[11] = 0xFF;
+        pDestAddr6->sin6_addr.s6_addr[12] = static_cast<uint8_t> ( iIPv4Addr >> 24 );
+        pDestAddr6->sin6_addr.s6_addr[13] = static_cast<uint8_t> ( iIPv4Addr >> 16 );
+        pDestAddr6->sin6_addr.s6_addr[14] = static_cast<uint8_t> ( iIPv4Addr >> 8 );
+        pDestAddr6->sin6_addr.s6_addr[15] = static_cast<uint8_t> ( iIPv4Addr );
+
+        iDestAddrLen = sizeof ( sockaddr_in6 );
+    }
+    else
+    {
+        sockaddr_in* pDestAddr4 = reinterpret_cast<sockaddr_in*> ( &DestAddr );
+
+        pDestAddr4->sin_family      = AF_INET;
+        pDestAddr4->sin_port        = htons ( HostAddr.iPort );
+        pDestAddr4->sin_addr.s_addr = htonl ( iIPv4Addr );
+
+        iDestAddrLen = sizeof ( sockaddr_in );
+    }
+
+    // a datagram socket may be used by several threads at the same time
+    sendto ( iTimeStampSocketDesc,
+             &vecbySendBuf.front(),
+             iVecSizeOut,
+             0,
+             reinterpret_cast<sockaddr*> ( &DestAddr ),
+             iDestAddrLen );
+}
+
+bool CSocket::BindReusePort ( const quint16 iPortNumber )
+{
+    // QUdpSocket does not support SO_REUSEPORT and the option must be set
+    // before binding, therefore we create the socket ourself and hand it
+    // over to the socket device (note that all sockets which share the port
+    // must be created this way)
+    const int iSocketDesc = socket ( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+
+    if ( iSocketDesc < 0 )
+    {
+        return false;
+    }
+
+    const int   iEnable = 1;
+    sockaddr_in LocalAddr;
+
+    memset ( &LocalAddr, 0, sizeof ( LocalAddr ) );
+    LocalAddr.sin_family      = AF_INET;
+    LocalAddr.sin_addr.s_addr = htonl ( INADDR_ANY );
+    LocalAddr.sin_port        = htons ( iPortNumber );
+
+    if ( ( setsockopt ( iSocketDesc, SOL_SOCKET, SO_REUSEPORT,
+                        &iEnable, sizeof ( iEnable ) ) != 0 ) ||
+         ( ::bind ( iSocketDesc, reinterpret_cast<sockaddr*> ( &LocalAddr ),
+                    sizeof ( LocalAddr ) ) != 0 ) ||
+         !SocketDevice.setSocketDescriptor ( iSocketDesc,
+                                             QUdpSocket::BoundState ) )
+    {
+        ::close ( iSocketDesc );
+        return false;
+    }
+
+    return true;
+}
+#endif
+
+int64_t CSocket::GetCurTimeNs()
+{
+#ifdef __linux__
+    // use the same clock as the kernel receive time stamps
+    timespec CurTime;
+    clock_gettime ( CLOCK_REALTIME, &CurTime );
+
+    return static_cast<int64_t> ( CurTime.tv_sec ) * 1000000000 + CurTime.tv_nsec;
+#else
+    return static_cast<int64_t> ( QDateTime::currentMSecsSinceEpoch() ) * 1000000;
+#endif
+}
+
+bool CSocket::ReadDatagram ( int&          iNumBytesRead,
+                             CHostAddress& HostAddr,
+                             int64_t&      iRecTimeNs )
+{
+#ifdef __linux__
+    if ( iTimeStampSocketDesc >= 0 )
+    {
+        sockaddr_storage SenderAddr;
+        iovec            IoVec;
+        msghdr           MsgHdr;
+        char             vecchControl[CMSG_SPACE ( sizeof ( timespec ) )];
+
+        IoVec.iov_base = &vecbyRecBuf[0];
+        IoVec.iov_len  = MAX_SIZE_BYTES_NETW_BUF;
+
+        memset ( &MsgHdr, 0, sizeof ( MsgHdr ) );
+        MsgHdr.msg_name       = &SenderAddr;
+        MsgHdr.msg_namelen    = sizeof ( SenderAddr );
+        MsgHdr.msg_iov        = &IoVec;
+        MsgHdr.msg_iovlen     = 1;
+        MsgHdr.msg_control    = vecchControl;
+        MsgHdr.msg_controllen = sizeof ( vecchControl );
+
+        // read block from network interface without blocking, if no more
+        // packets are available, an error is returned
+        iNumBytesRead = recvmsg ( iTimeStampSocketDesc, &MsgHdr, MSG_DONTWAIT );
 
-        // check if an error occurred
         if ( iNumBytesRead < 0 )
         {
-            return;
+            return false;
         }
 
-        // convert address of client
-        const CHostAddress RecHostAddr ( SenderAddress, SenderPort );
+        // get the kernel receive time stamp, if for some reason no time stamp
+        // was delivered, use the current time instead
+        iRecTimeNs = 0;
 
+        for ( cmsghdr* pCMsg = CMSG_FIRSTHDR ( &MsgHdr );
+              pCMsg != NULL;
+              pCMsg = CMSG_NXTHDR ( &MsgHdr, pCMsg ) )
+        {
+            if ( ( pCMsg->cmsg_level == SOL_SOCKET ) &&
+                 ( pCMsg->cmsg_type == SCM_TIMESTAMPNS ) )
+            {
+                timespec RecTime;
+                memcpy ( &RecTime, CMSG_DATA ( pCMsg ), sizeof ( RecTime ) );
+
+                iRecTimeNs =
+                    static_cast<int64_t> ( RecTime.tv_sec ) * 1000000000 + RecTime.tv_nsec;
+            }
+        }
+
+        if ( iRecTimeNs == 0 )
+        {
+            iRecTimeNs = GetCurTimeNs();
+        }
+
+        // convert address of sender (depending on the Qt version the socket
+        // is either IPv4 or dual stack IPv6)
+        quint16 iSenderPort = 0;
+
+        if ( SenderAddr.ss_family == AF_INET6 )
+        {
+            iSenderPort = ntohs ( reinterpret_cast<sockaddr_in6*> ( &SenderAddr )->sin6_port );
+        }
+        else
+        {
+            iSenderPort = ntohs ( reinterpret_cast<sockaddr_in*> ( &SenderAddr )->sin_port );
+        }
+
+        HostAddr = CHostAddress (
+            QHostAddress ( reinterpret_cast<sockaddr*> ( &SenderAddr ) ),
+            iSenderPort );
+
+        return true;
+    }
+#endif
+
+    QHostAddress SenderAddress;
+    quint16      SenderPort;
+    bool         bHasPendingDatagram;
+
+    Mutex.lock();
+    {
+        bHasPendingDatagram = SocketDevice.hasPendingDatagrams();
+
+        if ( bHasPendingDatagram )
+        {
+            // read block from network interface and query address of sender
+            iNumBytesRead = SocketDevice.readDatagram ( (char*) &vecbyRecBuf[0],
+                                                        MAX_SIZE_BYTES_NETW_BUF,
+                                                        &SenderAddress,
+                                                        &SenderPort );
+        }
+    }
+    Mutex.unlock();
+
+    if ( !bHasPendingDatagram )
+    {
+        return false;
+    }
+
+    // check if an error occurred
+    if ( iNumBytesRead < 0 )
+    {
+        return false;
+    }
+
+    // no kernel time stamps available, use the time we process the packet
+    iRecTimeNs = GetCurTimeNs();
+
+    // convert address of client
+    HostAddr = CHostAddress ( SenderAddress, SenderPort );
+
+    return true;
+}
+
+void CSocket::OnDataReceived()
+{
+    int          iNumBytesRead;
+    CHostAddress RecHostAddr;
+    int64_t      iRecTimeNs;
+
+    while ( ReadDatagram ( iNumBytesRead, RecHostAddr, iRecTimeNs ) )
+    {
         if ( bIsClient )
         {
             // client:
@@ -150,7 +431,7 @@ void CSocket::OnDataReceived()
                  pChannel->IsEnabled() )
             {
                 // this network packet is valid, put it in the channel
-                switch ( pChannel->PutData ( vecbyRecBuf, iNumBytesRead ) )
+                switch ( pChannel->PutData ( vecbyRecBuf, iNumBytesRead, iRecTimeNs ) )
                 {
                 case PS_AUDIO_OK:
                     PostWinMessage ( MS_JIT_BUF_PUT, MUL_COL_LED_GREEN );
@@ -182,7 +463,10 @@ void CSocket::OnDataReceived()
         {
             // server:
 
-            if ( pServer->PutData ( vecbyRecBuf, iNumBytesRead, RecHostAddr ) )
+            if ( pServer->PutData ( vecbyRecBuf,
+                                    iNumBytesRead,
+                                    RecHostAddr,
+                                    iRecTimeNs ) )
             {
                 // this was an audio packet, start server
                 // tell the server object to wake up if it
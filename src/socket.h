@@ -47,6 +47,10 @@ class CServer; // forward declaration of CServer
 // number of ports we try to bind until we give up
 #define NUM_SOCKET_PORTS_TO_TRY         50
 
+// maximum number of server sockets which are bound to the same port number,
+// each additional socket gets its own receive thread (Linux only)
+#define MAX_NUM_SERVER_SOCKETS          8
+
 
 /* Classes ********************************************************************/
 /* Base socket class ---------------------------------------------------------*/
@@ -57,11 +61,16 @@ class CSocket : public QObject
 public:
     CSocket ( CChannel*     pNewChannel,
               const quint16 iPortNumber )
-        : pChannel( pNewChannel ), bIsClient ( true ) { Init ( iPortNumber ); }
+        : SocketDevice ( this ), pChannel( pNewChannel ), bIsClient ( true ),
+          bUseReusePort ( false ) { Init ( iPortNumber ); }
 
     CSocket ( CServer*      pNServP,
-              const quint16 iPortNumber )
-        : pServer ( pNServP ), bIsClient ( false ) { Init ( iPortNumber ); }
+              const quint16 iPortNumber,
+              const bool    bNUseReusePort = false )
+        : SocketDevice ( this ), pServer ( pNServP ), bIsClient ( false ),
+          bUseReusePort ( bNUseReusePort ) { Init ( iPortNumber ); }
+
+    virtual ~CSocket();
 
     void SendPacket ( const CVector<uint8_t>& vecbySendBuf,
                       const CHostAddress&     HostAddr );
@@ -69,9 +78,35 @@ public:
 protected:
     void Init ( const quint16 iPortNumber = LLCON_DEFAULT_PORT_NUMBER );
 
+    bool ReadDatagram ( int&          iNumBytesRead,
+                        CHostAddress& HostAddr,
+                        int64_t&      iRecTimeNs );
+
+    static int64_t GetCurTimeNs();
+
+#ifdef __linux__
+    bool BindReusePort ( const quint16 iPortNumber );
+    void SendPacketNative ( const CVector<uint8_t>& vecbySendBuf,
+                            const CHostAddress&     HostAddr );
+#endif
+
+    // the socket device belongs to the thread of this object but the packets
+    // are sent from other threads (GUI, audio processing, server timer),
+    // therefore all accesses to the socket device are protected by the mutex
     QUdpSocket       SocketDevice;
     QMutex           Mutex;
 
+#ifdef __linux__
+    // the receive time stamps are delivered as ancillary data which is not
+    // supported by QUdpSocket, therefore we read the packets with our own
+    // socket notifier on a duplicate of the socket descriptor (the packets
+    // are sent on this descriptor, too, so that the socket device is not
+    // used at all after the initialization)
+    QSocketNotifier* pTimeStampSocketNotifier;
+    int              iTimeStampSocketDesc;
+    bool             bTimeStampSocketIsIPv6;
+#endif
+
     CVector<uint8_t> vecbyRecBuf;
     CHostAddress     RecHostAddr;
 
@@ -79,6 +114,7 @@ protected:
     CServer*         pServer;  // for server
 
     bool             bIsClient;
+    bool             bUseReusePort;
 
 public slots:
     void OnDataReceived();
@@ -90,8 +126,43 @@ signals:
 };
 
 
-#ifdef ENABLE_RECEIVE_SOCKET_IN_SEPARATE_THREAD
-/* Socket which runs in a separate high priority thread ----------------------*/
+/* Server socket which runs in a separate receive thread ---------------------*/
+// Additional server socket which is bound to the same port number as the main
+// server socket by using SO_REUSEPORT. The kernel distributes the received
+// packets on all sockets by a hash of the client address, i.e., all packets of
+// a client are always received by the same socket.
+class CReceiveThreadSocket
+{
+public:
+    CReceiveThreadSocket ( CServer*      pNServP,
+                           const quint16 iPortNumber )
+    {
+        // the socket must be created before it is moved to the thread, the
+        // received packets are directly put in the server channels
+        pSocket = new CSocket ( pNServP, iPortNumber, true );
+        pSocket->moveToThread ( &ReceiveThread );
+        ReceiveThread.start ( QThread::TimeCriticalPriority );
+    }
+
+    virtual ~CReceiveThreadSocket()
+    {
+        ReceiveThread.exit();
+        ReceiveThread.wait();
+        delete pSocket;
+    }
+
+protected:
+    QThread  ReceiveThread;
+    CSocket* pSocket;
+};
+
+
+/* Client socket which runs in a separate high priority thread ---------------*/
+// The received network packets are directly put in the jitter buffer of the
+// channel in the receive thread, i.e., a high load of the GUI thread (e.g.
+// because of a table update) does not delay the incoming audio packets.
+// Protocol messages are handed over to the thread of the channel object by
+// the channel itself.
 class CHighPrioSocket : public QObject
 {
     Q_OBJECT
@@ -122,7 +193,10 @@ public:
 
     virtual ~CHighPrioSocket()
     {
+        // the socket must not be deleted before the thread has finished
         NetworkWorkerThread.exit();
+        NetworkWorkerThread.wait();
+        delete pSocket;
     }
 
     void SendPacket ( const CVector<uint8_t>& vecbySendBuf,
@@ -140,6 +214,5 @@ signals:
                                  int              iNumBytesRead,
                                  CHostAddress     RecHostAddr );
 };
-#endif
 
 #endif /* !defined ( SOCKET_HOIHGE76GEKJH98_3_4344_BB23945IUHF1912__INCLUDED_ ) */
@@ -28,7 +28,7 @@
 /* Implementation *************************************************************/
 CSoundBase::CSoundBase ( const QString& strNewSystemDriverTechniqueName,
                          const bool bNewIsCallbackAudioInterface,
-                         void (*fpNewProcessCallback) ( CVector<int16_t>& psData, void* pParg ),
+                         void (*fpNewProcessCallback) ( CVector<float>& vecfData, void* pParg ),
                          void* pParg ) :
     fpProcessCallback ( fpNewProcessCallback ),
     pProcessCallbackArg ( pParg ), bRun ( false ),
@@ -48,7 +48,7 @@ int CSoundBase::Init ( const int iNewPrefMonoBufferSize )
     // init audio sound card buffer
     if ( !bIsCallbackAudioInterface )
     {
-        vecsAudioSndCrdStereo.Init ( 2 * iNewPrefMonoBufferSize /* stereo */ );
+        vecfAudioSndCrdStereo.Init ( 2 * iNewPrefMonoBufferSize /* stereo */ );
     }
 
     return iNewPrefMonoBufferSize;
@@ -102,7 +102,7 @@ void CSoundBase::run()
     while ( bRun )
     {
         // get audio from sound card (blocking function)
-        if ( Read ( vecsAudioSndCrdStereo ) )
+        if ( Read ( vecfAudioSndCrdStereo ) )
         {
             PostWinMessage ( MS_SOUND_IN, MUL_COL_LED_RED );
         }
@@ -112,10 +112,10 @@ void CSoundBase::run()
         }
 
         // process audio data
-        (*fpProcessCallback) ( vecsAudioSndCrdStereo, pProcessCallbackArg );
+        (*fpProcessCallback) ( vecfAudioSndCrdStereo, pProcessCallbackArg );
 
         // play the new block
-        if ( Write ( vecsAudioSndCrdStereo ) )
+        if ( Write ( vecfAudioSndCrdStereo ) )
         {
             PostWinMessage ( MS_SOUND_OUT, MUL_COL_LED_RED );
         }
@@ -50,7 +50,7 @@ class CSoundBase : public QThread
 public:
     CSoundBase ( const QString& strNewSystemDriverTechniqueName,
         const bool bNewIsCallbackAudioInterface,
-        void (*fpNewProcessCallback) ( CVector<int16_t>& psData, void* pParg ),
+        void (*fpNewProcessCallback) ( CVector<float>& vecfData, void* pParg ),
         void* pParg );
 
     virtual int  Init ( const int iNewPrefMonoBufferSize );
@@ -92,20 +92,22 @@ protected:
     virtual void     UnloadCurrentDriver() {}
     QVector<QString> LoadAndInitializeFirstValidDriver();
 
-    // function pointer to callback function
-    void (*fpProcessCallback) ( CVector<int16_t>& psData, void* arg );
+    // function pointer to callback function (the audio data is interleaved
+    // stereo with a nominal range of -1 to 1 so that no conversion is needed
+    // for float based audio interfaces and the audio codecs)
+    void (*fpProcessCallback) ( CVector<float>& vecfData, void* arg );
     void* pProcessCallbackArg;
 
     // callback function call for derived classes
-    void ProcessCallback ( CVector<int16_t>& psData )
+    void ProcessCallback ( CVector<float>& vecfData )
     {
-        (*fpProcessCallback) ( psData, pProcessCallbackArg );
+        (*fpProcessCallback) ( vecfData, pProcessCallbackArg );
     }
 
     // these functions should be overwritten by derived class for
     // non callback based audio interfaces
-    virtual bool Read  ( CVector<int16_t>& ) { printf ( "no sound!" ); return false; }
-    virtual bool Write ( CVector<int16_t>& ) { printf ( "no sound!" ); return false; }
+    virtual bool Read  ( CVector<float>& ) { printf ( "no sound!" ); return false; }
+    virtual bool Write ( CVector<float>& ) { printf ( "no sound!" ); return false; }
 
     void run();
     bool bRun;
@@ -113,7 +115,7 @@ protected:
     bool             bIsCallbackAudioInterface;
     QString          strSystemDriverTechniqueName;
 
-    CVector<int16_t> vecsAudioSndCrdStereo;
+    CVector<float>   vecfAudioSndCrdStereo;
 
     long             lNumDevs;
     long             lCurDev;
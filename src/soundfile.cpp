@@ -0,0 +1,424 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2013
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+\******************************************************************************/
+
+
+#include "soundfile.h"
+#include <QtEndian>
+#include <string.h>
+
+
+/* Implementation *************************************************************/
+CSoundFile::CSoundFile ( void (*fpNewProcessCallback) ( CVector<float>& vecfData, void* arg ),
+                         void*          arg,
+                         const QString& strInFileName,
+                         const QString& strOutFileName ) :
+    CSoundBase ( "File", false, fpNewProcessCallback, arg ),
+    iInNumChannels ( 2 ),
+    bInFileFinished ( true ),
+    iInNumDataBytesLeft ( 0 ),
+    iNumOutDataBytes ( 0 ),
+    iMonoBufferSize ( 0 )
+{
+    if ( !strInFileName.isEmpty() )
+    {
+        OpenInFile ( strInFileName );
+    }
+
+    if ( !strOutFileName.isEmpty() )
+    {
+        OpenOutFile ( strOutFileName );
+    }
+}
+
+CSoundFile::~CSoundFile()
+{
+    // the thread must not access the files anymore
+    CSoundBase::Stop();
+
+    if ( OutFile.isOpen() )
+    {
+        UpdateOutFileHeader();
+        OutFile.close();
+    }
+}
+
+void CSoundFile::OpenInFile ( const QString& strInFileName )
+{
+    bool bSuccess;
+
+    if ( strInFileName == "-" )
+    {
+        bSuccess = InFile.open ( stdin, QIODevice::ReadOnly );
+    }
+    else
+    {
+        InFile.setFileName ( strInFileName );
+        bSuccess = InFile.open ( QIODevice::ReadOnly );
+    }
+
+    if ( !bSuccess )
+    {
+        throw CGenErr ( "Cannot open the audio input file " + strInFileName +
+            ".", "File Error" );
+    }
+
+    // parse the RIFF header, the chunks are read sequentially so that a WAV
+    // stream on stdin is supported, too (only the audio data of the data
+    // chunk is read, chunks behind it like "LIST" or "id3 " are ignored)
+    uchar vbyHeader[16];
+    bool  bFormatOk  = false;
+    bool  bDataFound = false;
+
+    if ( ( ReadInFile ( (char*) vbyHeader, 12 ) != 12 ) ||
+         memcmp ( vbyHeader, "RIFF", 4 ) || memcmp ( vbyHeader + 8, "WAVE", 4 ) )
+    {
+        throw CGenErr ( "The audio input file " + strInFileName +
+            " is not a WAV file.", "File Error" );
+    }
+
+    while ( !bDataFound && ( ReadInFile ( (char*) vbyHeader, 8 ) == 8 ) )
+    {
+        qint64 iChunkSize = qFromLittleEndian<quint32> ( vbyHeader + 4 );
+
+        if ( !memcmp ( vbyHeader, "data", 4 ) )
+        {
+            bDataFound = true;
+
+            // a streaming encoder which does not know the length in advance
+            // writes the maximum size which results in reading until the end
+            // of the stream
+            iInNumDataBytesLeft = iChunkSize;
+        }
+        else
+        {
+            if ( !memcmp ( vbyHeader, "fmt ", 4 ) && ( iChunkSize >= 16 ) )
+            {
+                if ( ReadInFile ( (char*) vbyHeader, 16 ) != 16 )
+                {
+                    break;
+                }
+
+                iChunkSize -= 16;
+
+                // we only support 16 bit PCM with the system sample rate
+                const int iFormat     = qFromLittleEndian<quint16> ( vbyHeader );
+                iInNumChannels        = qFromLittleEndian<quint16> ( vbyHeader + 2 );
+                const int iSampleRate = qFromLittleEndian<quint32> ( vbyHeader + 4 );
+                const int iNumBits    = qFromLittleEndian<quint16> ( vbyHeader + 14 );
+
+                bFormatOk = ( iFormat == 1 ) &&
+                            ( ( iInNumChannels == 1 ) || ( iInNumChannels == 2 ) ) &&
+                            ( iSampleRate == SYSTEM_SAMPLE_RATE_HZ ) &&
+                            ( iNumBits == 16 );
+            }
+
+            // skip the rest of the chunk (chunks are padded to an even size)
+            if ( SkipInFile ( iChunkSize + ( iChunkSize & 1 ) ) )
+            {
+                break;
+            }
+        }
+    }
+
+    if ( !bFormatOk || !bDataFound )
+    {
+        throw CGenErr ( "The audio input file " + strInFileName +
+            " must be a 16 bit PCM WAV file with a sample rate of " +
+            QString().setNum ( SYSTEM_SAMPLE_RATE_HZ ) + " Hz.", "File Error" );
+    }
+
+    bInFileFinished = false;
+}
+
+void CSoundFile::OpenOutFile ( const QString& strOutFileName )
+{
+    OutFile.setFileName ( strOutFileName );
+
+    if ( !OutFile.open ( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        throw CGenErr ( "Cannot open the audio output file " + strOutFileName +
+            ".", "File Error" );
+    }
+
+    // write the header with an empty data chunk, the sizes are updated when
+    // the audio interface is stopped
+    iNumOutDataBytes = 0;
+    UpdateOutFileHeader();
+}
+
+void CSoundFile::UpdateOutFileHeader()
+{
+    // 16 bit PCM, stereo, system sample rate
+    const int iNumBytesPerFrame = 2 * sizeof ( int16_t );
+    uchar     vbyHeader[44];
+
+    memcpy ( vbyHeader, "RIFF", 4 );
+    qToLittleEndian<quint32> ( 36 + iNumOutDataBytes, vbyHeader + 4 );
+    memcpy ( vbyHeader + 8, "WAVEfmt ", 8 );
+    qToLittleEndian<quint32> ( 16, vbyHeader + 16 );
+    qToLittleEndian<quint16> ( 1, vbyHeader + 20 );
+    qToLittleEndian<quint16> ( 2, vbyHeader + 22 );
+    qToLittleEndian<quint32> ( SYSTEM_SAMPLE_RATE_HZ, vbyHeader + 24 );
+    qToLittleEndian<quint32> ( SYSTEM_SAMPLE_RATE_HZ * iNumBytesPerFrame, vbyHeader + 28 );
+    qToLittleEndian<quint16> ( iNumBytesPerFrame, vbyHeader + 32 );
+    qToLittleEndian<quint16> ( 16, vbyHeader + 34 );
+    memcpy ( vbyHeader + 36, "data", 4 );
+    qToLittleEndian<quint32> ( iNumOutDataBytes, vbyHeader + 40 );
+
+    // write the header at the beginning of the file and continue writing
+    // the audio data at the end of the file
+    OutFile.seek ( 0 );
+    OutFile.write ( (const char*) vbyHeader, 44 );
+    OutFile.seek ( 44 + iNumOutDataBytes );
+    OutFile.flush();
+}
+
+qint64 CSoundFile::ReadInFile ( char* pData, const qint64 iNumBytes )
+{
+    // a pipe may deliver less data than requested, therefore we read until
+    // we have all data or the end of the file is reached
+    qint64 iNumBytesRead = 0;
+
+    while ( iNumBytesRead < iNumBytes )
+    {
+        const qint64 iCurNumBytes =
+            InFile.read ( pData + iNumBytesRead, iNumBytes - iNumBytesRead );
+
+        if ( iCurNumBytes <= 0 )
+        {
+            break;
+        }
+
+        iNumBytesRead += iCurNumBytes;
+    }
+
+    return iNumBytesRead;
+}
+
+bool CSoundFile::SkipInFile ( const qint64 iNumBytes )
+{
+    // a file is skipped by a single seek, a pipe does not support seeking
+    // and we have to read the data
+    if ( !InFile.isSequential() )
+    {
+        return !InFile.seek ( InFile.pos() + iNumBytes );
+    }
+
+    char   vbySkipBuf[1024];
+    qint64 iNumBytesLeft = iNumBytes;
+
+    while ( iNumBytesLeft > 0 )
+    {
+        const qint64 iCurNumBytes =
+            qMin ( iNumBytesLeft, static_cast<qint64> ( sizeof ( vbySkipBuf ) ) );
+
+        if ( ReadInFile ( vbySkipBuf, iCurNumBytes ) != iCurNumBytes )
+        {
+            return true; // error
+        }
+
+        iNumBytesLeft -= iCurNumBytes;
+    }
+
+    return false;
+}
+
+int CSoundFile::Init ( const int iNewPrefMonoBufferSize )
+{
+    // any buffer size is supported
+    iMonoBufferSize = iNewPrefMonoBufferSize;
+
+    vecsFileBuf.Init ( 2 * iMonoBufferSize /* stereo */ );
+
+    // calculate the block duration in ns
+    const uint64_t iNsDelay =
+        ( (uint64_t) iMonoBufferSize * 1000000000 ) /
+        (uint64_t) SYSTEM_SAMPLE_RATE_HZ;
+
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
+    // calculate delay in mach absolute time
+    struct mach_timebase_info timeBaseInfo;
+    mach_timebase_info ( &timeBaseInfo );
+
+    Delay = ( iNsDelay * (uint64_t) timeBaseInfo.denom ) /
+        (uint64_t) timeBaseInfo.numer;
+#elif defined ( _WIN32 )
+    iDelayNs = iNsDelay;
+#else
+    Delay = iNsDelay;
+#endif
+
+    return CSoundBase::Init ( iMonoBufferSize );
+}
+
+void CSoundFile::Start()
+{
+    // only start if not already running
+    if ( !bRun )
+    {
+        // set initial end time, the first block is available after one
+        // block duration (like for a sound card)
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
+        NextEnd = mach_absolute_time();
+#elif defined ( _WIN32 )
+        ElapsedTimer.start();
+        iNextEndNs = 0;
+#else
+        clock_gettime ( CLOCK_MONOTONIC, &NextEnd );
+#endif
+
+        CSoundBase::Start();
+    }
+}
+
+void CSoundFile::Stop()
+{
+    CSoundBase::Stop();
+
+    // the output file shall always be a valid WAV file when the audio
+    // interface is not running
+    if ( OutFile.isOpen() )
+    {
+        UpdateOutFileHeader();
+    }
+}
+
+void CSoundFile::WaitForNextBlock()
+{
+    // we use the "increment method" to make sure we do not introduce a timing
+    // drift, if we are late, the next block is processed immediately
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
+    NextEnd += Delay;
+
+    mach_wait_until ( NextEnd );
+#elif defined ( _WIN32 )
+    iNextEndNs += iDelayNs;
+
+    const qint64 iRemainingUs = ( iNextEndNs - ElapsedTimer.nsecsElapsed() ) / 1000;
+
+    if ( iRemainingUs > 0 )
+    {
+        QThread::usleep ( iRemainingUs );
+    }
+#else
+    NextEnd.tv_nsec += Delay;
+    if ( NextEnd.tv_nsec >= 1000000000L )
+    {
+        NextEnd.tv_sec++;
+        NextEnd.tv_nsec -= 1000000000L;
+    }
+
+    clock_nanosleep ( CLOCK_MONOTONIC,
+                      TIMER_ABSTIME,
+                      &NextEnd,
+                      NULL );
+#endif
+}
+
+bool CSoundFile::Read ( CVector<float>& vecfData )
+{
+    int i;
+
+    // wait until the block is "captured"
+    WaitForNextBlock();
+
+    if ( bInFileFinished )
+    {
+        vecfData.Reset ( 0 );
+        return false;
+    }
+
+    // read the samples of the block, at the end of the data chunk the rest
+    // of the block is filled with silence
+    const int iNumSamples = iMonoBufferSize * iInNumChannels;
+
+    const qint64 iNumBytesToRead = qMin (
+        static_cast<qint64> ( iNumSamples * sizeof ( int16_t ) ),
+        iInNumDataBytesLeft );
+
+    const qint64 iNumBytesRead =
+        ReadInFile ( (char*) &vecsFileBuf[0], iNumBytesToRead );
+
+    iInNumDataBytesLeft -= iNumBytesRead;
+
+    const int iNumSamplesRead =
+        static_cast<int> ( iNumBytesRead / sizeof ( int16_t ) );
+
+    for ( i = iNumSamplesRead; i < iNumSamples; i++ )
+    {
+        vecsFileBuf[i] = 0;
+    }
+
+    if ( iInNumChannels == 2 )
+    {
+        for ( i = 0; i < 2 * iMonoBufferSize; i++ )
+        {
+            vecfData[i] = static_cast<float> (
+                qFromLittleEndian<qint16> ( vecsFileBuf[i] ) ) / _MAXSHORT;
+        }
+    }
+    else
+    {
+        // use the mono signal for both channels
+        for ( i = 0; i < iMonoBufferSize; i++ )
+        {
+            vecfData[2 * i] = vecfData[2 * i + 1] = static_cast<float> (
+                qFromLittleEndian<qint16> ( vecsFileBuf[i] ) ) / _MAXSHORT;
+        }
+    }
+
+    if ( iNumSamplesRead < iNumSamples )
+    {
+        // from now on the input is silence
+        bInFileFinished = true;
+        emit InputFileFinished();
+    }
+
+    return false;
+}
+
+bool CSoundFile::Write ( CVector<float>& vecfData )
+{
+    if ( !OutFile.isOpen() )
+    {
+        return false;
+    }
+
+    for ( int i = 0; i < 2 * iMonoBufferSize; i++ )
+    {
+        vecsFileBuf[i] = qToLittleEndian<qint16> (
+            Double2Short ( vecfData[i] * _MAXSHORT ) );
+    }
+
+    const qint64 iNumBytes = 2 * iMonoBufferSize * sizeof ( int16_t );
+
+    if ( OutFile.write ( (const char*) &vecsFileBuf[0], iNumBytes ) != iNumBytes )
+    {
+        return true; // error
+    }
+
+    iNumOutDataBytes += iNumBytes;
+
+    return false;
+}
@@ -0,0 +1,107 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2013
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+\******************************************************************************/
+
+
+#if !defined ( SOUNDFILE_HOIHGE76GEKJH98_3_4344_BB23945IUHF1912__INCLUDED_ )
+#define SOUNDFILE_HOIHGE76GEKJH98_3_4344_BB23945IUHF1912__INCLUDED_
+
+#include <QFile>
+#include <QString>
+#include <QElapsedTimer>
+#include "global.h"
+#include "util.h"
+#include "soundbase.h"
+
+// using mach timers for Mac and nanosleep for Linux
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
+# include <mach/mach.h>
+# include <mach/mach_error.h>
+# include <mach/mach_time.h>
+#elif !defined ( _WIN32 )
+# include <time.h>
+#endif
+
+
+/* Classes ********************************************************************/
+// Audio interface which reads the audio input from a WAV file (or a WAV stream
+// on stdin) and writes the audio output to a WAV file instead of using a sound
+// card. The blocks are clocked by a timer with the nominal block duration so
+// that the client can be run without audio hardware (e.g. for automated
+// performance tests). Only 16 bit PCM with the system sample rate is supported.
+// If the input file name is empty, silence is used as the input signal and if
+// the output file name is empty, the output signal is discarded.
+class CSoundFile : public CSoundBase
+{
+    Q_OBJECT
+
+public:
+    CSoundFile ( void (*fpNewProcessCallback) ( CVector<float>& vecfData, void* arg ),
+                 void*          arg,
+                 const QString& strInFileName,
+                 const QString& strOutFileName );
+
+    virtual ~CSoundFile();
+
+    virtual int  Init ( const int iNewPrefMonoBufferSize );
+    virtual void Start();
+    virtual void Stop();
+
+protected:
+    virtual bool Read  ( CVector<float>& vecfData );
+    virtual bool Write ( CVector<float>& vecfData );
+
+    void   OpenInFile ( const QString& strInFileName );
+    void   OpenOutFile ( const QString& strOutFileName );
+    void   UpdateOutFileHeader();
+    qint64 ReadInFile ( char* pData, const qint64 iNumBytes );
+    bool   SkipInFile ( const qint64 iNumBytes );
+    void   WaitForNextBlock();
+
+    QFile            InFile;
+    QFile            OutFile;
+    int              iInNumChannels;
+    bool             bInFileFinished;
+    qint64           iInNumDataBytesLeft;
+    qint64           iNumOutDataBytes;
+
+    int              iMonoBufferSize;
+    CVector<int16_t> vecsFileBuf;
+
+#if defined ( __APPLE__ ) || defined ( __MACOSX )
+    uint64_t         Delay;
+    uint64_t         NextEnd;
+#elif defined ( _WIN32 )
+    QElapsedTimer    ElapsedTimer;
+    qint64           iDelayNs;
+    qint64           iNextEndNs;
+#else
+    long             Delay;
+    timespec         NextEnd;
+#endif
+
+signals:
+    void InputFileFinished();
+};
+
+#endif /* !defined ( SOUNDFILE_HOIHGE76GEKJH98_3_4344_BB23945IUHF1912__INCLUDED_ ) */
@@ -29,6 +29,9 @@
 #include <QTimer>
 #include <QDateTime>
 #include <QHostAddress>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QCoreApplication>
 #include "global.h"
 #include "socket.h"
 #include "protocol.h"
@@ -284,4 +287,307 @@ public slots:
     }
 };
 
+
+// Offline protocol parser test bench: The parser is called directly without
+// any network transfer, as a throughput benchmark for each message type and as
+// the entry point for coverage guided fuzzing (see PROTOCOL_FUZZER below).
+class CProtocolParserBench : public CProtocol
+{
+    Q_OBJECT
+
+public:
+    CProtocolParserBench() :
+        HostAddress ( QHostAddress ( QHostAddress::LocalHost ), LLCON_DEFAULT_PORT_NUMBER ),
+        bCapture    ( false )
+    {
+        // all generated messages are captured
+        QObject::connect ( this, SIGNAL ( MessReadyForSending ( CVector<uint8_t> ) ),
+            this, SLOT ( OnMessReadyForSending ( CVector<uint8_t> ) ) );
+
+        QObject::connect ( this, SIGNAL ( CLMessReadyForSending ( CHostAddress, CVector<uint8_t> ) ),
+            this, SLOT ( OnCLMessReadyForSending ( CHostAddress, CVector<uint8_t> ) ) );
+    }
+
+    void RunBenchmark ( QTextStream& tsConsole, const int iDurationPerMessMs = 200 )
+    {
+        GenerateMessages();
+
+        for ( int i = 0; i < vecvecbyMessages.Size(); i++ )
+        {
+            QElapsedTimer ElapsedTimer;
+            qint64        iNumParsed = 0;
+
+            ElapsedTimer.start();
+
+            do
+            {
+                for ( int j = 0; j < 1000; j++ )
+                {
+                    ParseFrame ( vecvecbyMessages[i] );
+                }
+
+                iNumParsed += 1000;
+            }
+            while ( ElapsedTimer.elapsed() < iDurationPerMessMs );
+
+            tsConsole << vecstrMessNames[i] << " (" <<
+                vecvecbyMessages[i].Size() << " bytes): " <<
+                static_cast<qint64> ( iNumParsed * 1000 / ElapsedTimer.elapsed() ) <<
+                " messages/s" << endl;
+        }
+
+        Reset();
+    }
+
+    void ParseData ( const uint8_t* pData, const int iNumBytes )
+    {
+/*
+    The first byte selects how the data are used:
+    - even: the data are a complete network packet (the fuzzer has to find
+            the correct CRC, as for a real network packet)
+    - odd:  the next two bytes are the message ID, the next byte is the
+            counter, the rest is the message body (no CRC check)
+*/
+        if ( iNumBytes < 1 )
+        {
+            return;
+        }
+
+        int              iRecCounter, iRecID;
+        CVector<uint8_t> vecbyMesBodyData;
+
+        if ( ( pData[0] & 1 ) == 0 )
+        {
+            CVector<uint8_t> vecbyData ( iNumBytes - 1 );
+
+            if ( iNumBytes > 1 )
+            {
+                memcpy ( &vecbyData[0], pData + 1, iNumBytes - 1 );
+            }
+
+            if ( ParseMessageFrame ( vecbyData,
+                                     vecbyData.Size(),
+                                     vecbyMesBodyData,
+                                     iRecCounter,
+                                     iRecID ) )
+            {
+                return; // not a protocol message
+            }
+        }
+        else
+        {
+            if ( iNumBytes < 4 )
+            {
+                return;
+            }
+
+            iRecID      = pData[1] | ( pData[2] << 8 );
+            iRecCounter = pData[3];
+
+            vecbyMesBodyData.Init ( iNumBytes - 4 );
+
+            if ( iNumBytes > 4 )
+            {
+                memcpy ( &vecbyMesBodyData[0], pData + 4, iNumBytes - 4 );
+            }
+        }
+
+        if ( IsConnectionLessMessageID ( iRecID ) )
+        {
+            ParseConnectionLessMessageBody ( vecbyMesBodyData, iRecID, HostAddress );
+        }
+        else
+        {
+            ParseMessageBody ( vecbyMesBodyData, iRecCounter, iRecID );
+        }
+
+        // each input starts with a new protocol state
+        Reset();
+    }
+
+protected:
+    void ParseFrame ( const CVector<uint8_t>& vecbyData )
+    {
+        int              iRecCounter, iRecID;
+        CVector<uint8_t> vecbyMesBodyData;
+
+        if ( !ParseMessageFrame ( vecbyData,
+                                  vecbyData.Size(),
+                                  vecbyMesBodyData,
+                                  iRecCounter,
+                                  iRecID ) )
+        {
+            if ( IsConnectionLessMessageID ( iRecID ) )
+            {
+                ParseConnectionLessMessageBody ( vecbyMesBodyData, iRecID, HostAddress );
+            }
+            else
+            {
+                // we evaluate the message directly since the same message is
+                // parsed again and again which would be detected as a
+                // re-transmission otherwise
+                EvaluateMessage ( vecbyMesBodyData, iRecCounter, iRecID );
+            }
+        }
+    }
+
+    void StartCapture ( const QString& strMessName )
+    {
+        // we do not wait for the acknowledgement of the protocol features
+        // message, every message is sent immediately
+        Reset();
+        bProtFeaturesSent = true;
+
+        strCurMessName = strMessName;
+        bCapture       = true;
+    }
+
+    void GenerateMessages()
+    {
+        const int              iNumChan    = 10;
+        const int              iNumServers = 50;
+        CVector<CChannelInfo>  vecChanInfo ( iNumChan );
+        CVector<CServerInfo>   vecServerInfo ( iNumServers );
+        CNetworkTransportProps NetTrProps;
+        CServerCoreInfo        ServerInfo;
+        CChannelCoreInfo       ChannelCoreInfo;
+
+        for ( int i = 0; i < iNumChan; i++ )
+        {
+            vecChanInfo[i] = CChannelInfo ( i,
+                                            0x7F000001,
+                                            QString ( "Musician %1" ).arg ( i ),
+                                            QLocale::Germany,
+                                            "Stuttgart",
+                                            i,
+                                            SL_PROFESSIONAL );
+        }
+
+        for ( int i = 0; i < iNumServers; i++ )
+        {
+            vecServerInfo[i] = CServerInfo ( HostAddress,
+                                             LLCON_DEFAULT_PORT_NUMBER,
+                                             QString ( "Server %1" ).arg ( i ),
+                                             "Jam session",
+                                             QLocale::Germany,
+                                             "Stuttgart",
+                                             DEFAULT_USED_NUM_CHANNELS,
+                                             false );
+        }
+
+        ChannelCoreInfo.strName = "Musician";
+        ChannelCoreInfo.strCity = "Stuttgart";
+        ServerInfo              = vecServerInfo[0];
+
+        vecvecbyMessages.Init ( 0 );
+        vecstrMessNames.Init ( 0 );
+
+        StartCapture ( "JITT_BUF_SIZE" );
+        CreateJitBufMes ( 10 );
+        StartCapture ( "REQ_JITT_BUF_SIZE" );
+        CreateReqJitBufMes();
+        StartCapture ( "CHANNEL_GAIN" );
+        CreateChanGainMes ( 1, 0.5 );
+        StartCapture ( "CONN_CLIENTS_LIST_NAME" );
+        CreateConClientListNameMes ( vecChanInfo );
+        StartCapture ( "CONN_CLIENTS_LIST" );
+        CreateConClientListMes ( vecChanInfo );
+        StartCapture ( "CONN_CLIENTS_LIST_DELTA" );
+        CreateConClientListDeltaMes ( FULL_CONN_CLIENTS_LIST_VERSION, 1, vecChanInfo, CVector<int> ( 0 ) );
+        StartCapture ( "REQ_CONN_CLIENTS_LIST" );
+        CreateReqConnClientsList();
+        StartCapture ( "CHANNEL_NAME" );
+        CreateChanNameMes ( "Musician" );
+        StartCapture ( "CHANNEL_INFOS" );
+        CreateChanInfoMes ( ChannelCoreInfo );
+        StartCapture ( "REQ_CHANNEL_INFOS" );
+        CreateReqChanInfoMes();
+        StartCapture ( "CHAT_TEXT" );
+        CreateChatTextMes ( "Hello, this is a chat message" );
+        StartCapture ( "NETW_TRANSPORT_PROPS" );
+        CreateNetwTranspPropsMes ( NetTrProps );
+        StartCapture ( "REQ_NETW_TRANSPORT_PROPS" );
+        CreateReqNetwTranspPropsMes();
+        StartCapture ( "OPUS_SUPPORTED" );
+        CreateOpusSupportedMes();
+        StartCapture ( "LOCAL_MONITORING" );
+        CreateLocalMonitoringMes ( true );
+        StartCapture ( "CLM_PING_MS" );
+        CreateCLPingMes ( HostAddress, 1000 );
+        StartCapture ( "CLM_PING_MS_WITHNUMCLIENTS" );
+        CreateCLPingWithNumClientsMes ( HostAddress, 1000, 5 );
+        StartCapture ( "CLM_SERVER_FULL" );
+        CreateCLServerFullMes ( HostAddress );
+        StartCapture ( "CLM_REGISTER_SERVER" );
+        CreateCLRegisterServerMes ( HostAddress, ServerInfo );
+        StartCapture ( "CLM_UNREGISTER_SERVER" );
+        CreateCLUnregisterServerMes ( HostAddress );
+        StartCapture ( "CLM_SERVER_LIST" );
+        CreateCLServerListMes ( HostAddress, vecServerInfo );
+        StartCapture ( "CLM_SERVER_LIST_PART" );
+        CreateCLServerListPartsMes ( HostAddress, vecServerInfo );
+        StartCapture ( "CLM_REQ_SERVER_LIST" );
+        CreateCLReqServerListMes ( HostAddress );
+        StartCapture ( "CLM_SEND_EMPTY_MESSAGE" );
+        CreateCLSendEmptyMesMes ( HostAddress, HostAddress );
+        StartCapture ( "CLM_EMPTY_MESSAGE" );
+        CreateCLEmptyMes ( HostAddress );
+        StartCapture ( "CLM_DISCONNECTION" );
+        CreateCLDisconnection ( HostAddress );
+        StartCapture ( "CLM_AUDIO_DELAY_MEAS" );
+        CreateCLAudioDelayMeasMes ( HostAddress, 1000, 3 );
+
+        bCapture = false;
+        Reset();
+    }
+
+    void AddMessage ( const CVector<uint8_t>& vecMessage )
+    {
+        if ( bCapture )
+        {
+            const int iIdx = vecvecbyMessages.Size();
+
+            vecvecbyMessages.Enlarge ( 1 );
+            vecvecbyMessages[iIdx].Init ( vecMessage.Size() );
+            vecvecbyMessages[iIdx] = vecMessage;
+
+            vecstrMessNames.Add ( strCurMessName );
+        }
+    }
+
+    CHostAddress               HostAddress;
+    bool                       bCapture;
+    QString                    strCurMessName;
+    CVector<CVector<uint8_t> > vecvecbyMessages;
+    CVector<QString>           vecstrMessNames;
+
+public slots:
+    void OnMessReadyForSending ( CVector<uint8_t> vecMessage )
+        { AddMessage ( vecMessage ); }
+
+    void OnCLMessReadyForSending ( CHostAddress, CVector<uint8_t> vecMessage )
+        { AddMessage ( vecMessage ); }
+};
+
+#ifdef PROTOCOL_FUZZER
+// entry points for libFuzzer (AFL can use the same entry points with its
+// libFuzzer driver), the "main" function of the application is not compiled
+extern "C" int LLVMFuzzerInitialize ( int* argc, char*** argv )
+{
+    // the protocol uses timers which require an application object
+    new QCoreApplication ( *argc, *argv );
+
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput ( const uint8_t* pData, size_t iSize )
+{
+    static CProtocolParserBench ProtocolParserBench;
+
+    ProtocolParserBench.ParseData ( pData, static_cast<int> ( iSize ) );
+
+    return 0;
+}
+#endif
+
 #endif /* !defined ( TESTBENCH_HOIHJH8_3_43445KJIUHF1912__INCLUDED_ ) */
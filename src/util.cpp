@@ -27,10 +27,10 @@
 
 /* Implementation *************************************************************/
 // Input level meter implementation --------------------------------------------
-void CStereoSignalLevelMeter::Update ( CVector<short>& vecsAudio )
+void CStereoSignalLevelMeter::Update ( CVector<float>& vecfAudio )
 {
     // get the stereo vector size
-    const int iStereoVecSize = vecsAudio.Size();
+    const int iStereoVecSize = vecfAudio.Size();
 
     // Get maximum of current block
     //
@@ -43,29 +43,30 @@ void CStereoSignalLevelMeter::Update ( CVector<short>& vecsAudio )
     // special cases but for the average music signals the following code
     // should give good results.
     //
-    short sMaxL = 0;
-    short sMaxR = 0;
+    float fMaxL = 0;
+    float fMaxR = 0;
     for ( int i = 0; i < iStereoVecSize; i += 6 ) // 2 * 3 = 6 -> stereo
     {
         // left channel
-        if ( sMaxL < vecsAudio[i] )
+        if ( fMaxL < vecfAudio[i] )
         {
-            sMaxL = vecsAudio[i];
+            fMaxL = vecfAudio[i];
         }
 
         // right channel
-        if ( sMaxR < vecsAudio[i + 1] )
+        if ( fMaxR < vecfAudio[i + 1] )
         {
-            sMaxR = vecsAudio[i + 1];
+            fMaxR = vecfAudio[i + 1];
         }
     }
 
-    dCurLevelL = UpdateCurLevel ( dCurLevelL, sMaxL );
-    dCurLevelR = UpdateCurLevel ( dCurLevelR, sMaxR );
+    // the levels are in the 16 bit range (the audio samples are normalized)
+    dCurLevelL = UpdateCurLevel ( dCurLevelL, fMaxL * _MAXSHORT );
+    dCurLevelR = UpdateCurLevel ( dCurLevelR, fMaxR * _MAXSHORT );
 }
 
-double CStereoSignalLevelMeter::UpdateCurLevel ( double       dCurLevel,
-                                                 const short& sMax )
+double CStereoSignalLevelMeter::UpdateCurLevel ( double      dCurLevel,
+                                                 const float fMax )
 {
     // decrease max with time
     if ( dCurLevel >= METER_FLY_BACK )
@@ -79,9 +80,9 @@ double CStereoSignalLevelMeter::UpdateCurLevel ( double       dCurLevel,
     }
 
     // update current level -> only use maximum
-    if ( static_cast<double> ( sMax ) > dCurLevel )
+    if ( static_cast<double> ( fMax ) > dCurLevel )
     {
-        return static_cast<double> ( sMax );
+        return static_cast<double> ( fMax );
     }
     else
     {
@@ -106,49 +107,133 @@ double CStereoSignalLevelMeter::CalcLogResult ( const double& dLinearLevel )
 
 
 // CRC -------------------------------------------------------------------------
+// look-up table for the polynomial 0x1021, entry n is the shift register content
+// after shifting in the 8 bits of n (MSB first) in an all-zero register
+const uint16_t CCRC::pCRCTable[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
 void CCRC::Reset()
 {
     // init state shift-register with ones. Set all registers to "1" with
     // bit-wise not operation
-    iStateShiftReg = ~uint32_t ( 0 );
+    iStateShiftReg = static_cast<uint16_t> ( ~0 );
 }
 
-void CCRC::AddByte ( const uint8_t byNewInput )
+void CCRC::AddBytes ( const uint8_t* pbyNewInput,
+                      const size_t   iNumBytes )
 {
-    for ( int i = 0; i < 8; i++ )
+    for ( size_t i = 0; i < iNumBytes; i++ )
     {
-        // shift bits in shift-register for transistion
-        iStateShiftReg <<= 1;
+        AddByte ( pbyNewInput[i] );
+    }
+}
 
-        // take bit, which was shifted out of the register-size and place it
-        // at the beginning (LSB)
-        // (If condition is not satisfied, implicitely a "0" is added)
-        if ( ( iStateShiftReg & iBitOutMask) > 0 )
-        {
-            iStateShiftReg |= 1;
-        }
+uint32_t CCRC::GetCRC()
+{
+    // return inverted shift-register (1's complement)
+    iStateShiftReg = static_cast<uint16_t> ( ~iStateShiftReg );
+
+    return iStateShiftReg;
+}
+
+void CCRC::GetZeroBytesOperator ( const size_t iNumBytes,
+                                  uint16_t*    pOperator )
+{
+/*
+    The operator is a 16x16 matrix over GF(2) stored as 16 columns, column i
+    is the result for the start state with only bit i set. The operator for
+    n bytes is the n-th power of the operator for one zero byte which is
+    calculated by repeated squaring (as it is done in zlib crc32_combine).
+*/
+    uint16_t pPower[16];
+    uint16_t pTemp[16];
+    size_t   iRemaining = iNumBytes;
+
+    for ( int i = 0; i < 16; i++ )
+    {
+        const uint16_t iState = static_cast<uint16_t> ( 1 << i );
+
+        // identity for the result
+        pOperator[i] = iState;
 
-        // add new data bit to the LSB
-        if ( ( byNewInput & ( 1 << ( 8 - i - 1 ) ) ) > 0 )
+        // adding one zero byte
+        pPower[i] = static_cast<uint16_t> ( ( iState << 8 ) ^
+            pCRCTable[iState >> 8] );
+    }
+
+    while ( iRemaining > 0 )
+    {
+        if ( iRemaining & 1 )
         {
-            iStateShiftReg ^= 1;
+            for ( int i = 0; i < 16; i++ )
+            {
+                pTemp[i] = ApplyOperator ( pPower, pOperator[i] );
+            }
+
+            memcpy ( pOperator, pTemp, sizeof ( pTemp ) );
         }
 
-        // add mask to shift-register if first bit is true
-        if ( iStateShiftReg & 1 )
+        iRemaining >>= 1;
+
+        if ( iRemaining > 0 )
         {
-            iStateShiftReg ^= iPoly;
+            // square the operator
+            for ( int i = 0; i < 16; i++ )
+            {
+                pTemp[i] = ApplyOperator ( pPower, pPower[i] );
+            }
+
+            memcpy ( pPower, pTemp, sizeof ( pTemp ) );
         }
     }
 }
 
-uint32_t CCRC::GetCRC()
+uint16_t CCRC::ApplyOperator ( const uint16_t* pOperator,
+                               const uint16_t  iState )
 {
-    // return inverted shift-register (1's complement)
-    iStateShiftReg = ~iStateShiftReg;
+    uint16_t iResult = 0;
+
+    for ( int i = 0; i < 16; i++ )
+    {
+        if ( iState & ( 1 << i ) )
+        {
+            iResult ^= pOperator[i];
+        }
+    }
 
-    // remove bit which where shifted out of the shift-register frame
-    return iStateShiftReg & ( iBitOutMask - 1 );
+    return iResult;
 }
 
 
@@ -206,7 +291,7 @@ void CAudioReverb::Init ( const int iSampleRate, const double rT60 )
     }
 
     setT60 ( rT60, iSampleRate );
-    allpassCoefficient_ = (double) 0.7;
+    allpassCoefficient_ = (float) 0.7;
     Clear();
 }
 
@@ -242,13 +327,13 @@ bool CAudioReverb::isPrime ( const int number )
 void CAudioReverb::Clear()
 {
     // reset and clear all internal state
-    allpassDelays_[0].Reset ( 0 );
-    allpassDelays_[1].Reset ( 0 );
-    allpassDelays_[2].Reset ( 0 );
-    combDelays_[0].Reset    ( 0 );
-    combDelays_[1].Reset    ( 0 );
-    combDelays_[2].Reset    ( 0 );
-    combDelays_[3].Reset    ( 0 );
+    allpassDelays_[0].Clear();
+    allpassDelays_[1].Clear();
+    allpassDelays_[2].Clear();
+    combDelays_[0].Clear();
+    combDelays_[1].Clear();
+    combDelays_[2].Clear();
+    combDelays_[3].Clear();
 }
 
 void CAudioReverb::setT60 ( const double rT60,
@@ -257,45 +342,141 @@ void CAudioReverb::setT60 ( const double rT60,
     // set the reverberation T60 decay time
     for ( int i = 0; i < 4; i++ )
     {
-        combCoefficient_[i] = pow ( (double) 10.0, (double) ( -3.0 *
-            combDelays_[i].Size() / ( rT60 * iSampleRate ) ) );
+        combCoefficient_[i] = (float) pow ( (double) 10.0, (double) ( -3.0 *
+            combDelays_[i].Length() / ( rT60 * iSampleRate ) ) );
     }
 }
 
-double CAudioReverb::ProcessSample ( const double input )
+void CAudioReverb::Process ( const float* pfIn,
+                             float*       pfOut,
+                             const int    iNumFrames,
+                             const float  fGainLeft,
+                             const float  fGainRight )
 {
-    // compute one output sample
-    double temp, temp0, temp1, temp2;
-
-    temp = allpassDelays_[0].Get();
-    temp0 = allpassCoefficient_ * temp;
-    temp0 += input;
-    allpassDelays_[0].Add ( (int) temp0 );
-    temp0 = - ( allpassCoefficient_ * temp0 ) + temp;
-
-    temp = allpassDelays_[1].Get();
-    temp1 = allpassCoefficient_ * temp;
-    temp1 += temp0;
-    allpassDelays_[1].Add ( (int) temp1 );
-    temp1 = - ( allpassCoefficient_ * temp1 ) + temp;
-
-    temp = allpassDelays_[2].Get();
-    temp2 = allpassCoefficient_ * temp;
-    temp2 += temp1;
-    allpassDelays_[2].Add ( (int) temp2 );
-    temp2 = - ( allpassCoefficient_ * temp2 ) + temp;
-
-    const double temp3 = temp2 + ( combCoefficient_[0] * combDelays_[0].Get() );
-    const double temp4 = temp2 + ( combCoefficient_[1] * combDelays_[1].Get() );
-    const double temp5 = temp2 + ( combCoefficient_[2] * combDelays_[2].Get() );
-    const double temp6 = temp2 + ( combCoefficient_[3] * combDelays_[3].Get() );
-
-    combDelays_[0].Add ( (int) temp3 );
-    combDelays_[1].Add ( (int) temp4 );
-    combDelays_[2].Add ( (int) temp5 );
-    combDelays_[3].Add ( (int) temp6 );
-
-    return ( temp3 + temp4 + temp5 + temp6 ) * (double) 0.5;
+    // a tiny offset keeps the recursive filters out of the denormal number
+    // range if the input is silent (denormals are very slow on some CPUs)
+    const float fAntiDenormal = (float) 1e-18;
+    const float vfGain[2]     = { fGainLeft, fGainRight };
+    int         c;
+
+    // a channel with zero gain is not processed at all (e.g. for mono only
+    // the selected channel has a reverberation), its output is the input
+    const int iFirstChan = ( fGainLeft != 0 ) ? 0 : 1;
+    const int iLastChan  = ( fGainRight != 0 ) ? 1 : 0;
+
+    for ( int i = 0; i < iNumFrames; i++ )
+    {
+        float* pfAp0 = allpassDelays_[0].Cur();
+        float* pfAp1 = allpassDelays_[1].Cur();
+        float* pfAp2 = allpassDelays_[2].Cur();
+        float* pfCb0 = combDelays_[0].Cur();
+        float* pfCb1 = combDelays_[1].Cur();
+        float* pfCb2 = combDelays_[2].Cur();
+        float* pfCb3 = combDelays_[3].Cur();
+
+        float vfTemp[2] = { 0, 0 };
+
+        // compute one stereo output sample, both channels are independent
+        for ( c = iFirstChan; c <= iLastChan; c++ )
+        {
+            // three series allpass units
+            float fTemp = pfAp0[c];
+            float fIn   = allpassCoefficient_ * fTemp + pfIn[2 * i + c] + fAntiDenormal;
+            pfAp0[c]    = fIn;
+            fIn         = fTemp - allpassCoefficient_ * fIn;
+
+            fTemp    = pfAp1[c];
+            float fY = allpassCoefficient_ * fTemp + fIn;
+            pfAp1[c] = fY;
+            fIn      = fTemp - allpassCoefficient_ * fY;
+
+            fTemp    = pfAp2[c];
+            fY       = allpassCoefficient_ * fTemp + fIn;
+            pfAp2[c] = fY;
+            fIn      = fTemp - allpassCoefficient_ * fY;
+
+            // four parallel comb filters
+            const float fTemp3 = fIn + combCoefficient_[0] * pfCb0[c];
+            const float fTemp4 = fIn + combCoefficient_[1] * pfCb1[c];
+            const float fTemp5 = fIn + combCoefficient_[2] * pfCb2[c];
+            const float fTemp6 = fIn + combCoefficient_[3] * pfCb3[c];
+
+            pfCb0[c] = fTemp3;
+            pfCb1[c] = fTemp4;
+            pfCb2[c] = fTemp5;
+            pfCb3[c] = fTemp6;
+
+            vfTemp[c] = ( fTemp3 + fTemp4 + fTemp5 + fTemp6 ) * (float) 0.5;
+        }
+
+        for ( c = 0; c < 2; c++ )
+        {
+            pfOut[2 * i + c] = pfIn[2 * i + c] + vfGain[c] * vfTemp[c];
+        }
+
+        allpassDelays_[0].Advance();
+        allpassDelays_[1].Advance();
+        allpassDelays_[2].Advance();
+        combDelays_[0].Advance();
+        combDelays_[1].Advance();
+        combDelays_[2].Advance();
+        combDelays_[3].Advance();
+    }
+}
+
+
+/******************************************************************************\
+* Audio Processing Load Meter                                                  *
+\******************************************************************************/
+void CAudioLoadMeter::Init ( const int iBlockSizeSamples )
+{
+    iBlockDurationUs = static_cast<int> ( static_cast<int64_t> (
+        iBlockSizeSamples ) * 1000000 / SYSTEM_SAMPLE_RATE_HZ );
+
+    iProcTimeSumUs.fetchAndStoreOrdered ( 0 );
+    iProcTimeMaxUs.fetchAndStoreOrdered ( 0 );
+    iNumBlocks.fetchAndStoreOrdered ( 0 );
+    iNumOverruns.fetchAndStoreOrdered ( 0 );
+}
+
+void CAudioLoadMeter::StopBlock()
+{
+    const int iProcTimeUs =
+        static_cast<int> ( ElapsedTimer.nsecsElapsed() / 1000 );
+
+    iProcTimeSumUs.fetchAndAddOrdered ( iProcTimeUs );
+    iNumBlocks.ref();
+
+    // the peak value might be reset by the reader at the same time
+    int iCurMaxUs = AtomicLoadAcquire ( iProcTimeMaxUs );
+
+    while ( ( iProcTimeUs > iCurMaxUs ) &&
+            !iProcTimeMaxUs.testAndSetOrdered ( iCurMaxUs, iProcTimeUs ) )
+    {
+        iCurMaxUs = AtomicLoadAcquire ( iProcTimeMaxUs );
+    }
+}
+
+void CAudioLoadMeter::GetAndResetLoad ( int& iAverageLoad,
+                                        int& iPeakLoad )
+{
+    const int iCurNumBlocks = iNumBlocks.fetchAndStoreOrdered ( 0 );
+    const int iCurSumUs     = iProcTimeSumUs.fetchAndStoreOrdered ( 0 );
+    const int iCurMaxUs     = iProcTimeMaxUs.fetchAndStoreOrdered ( 0 );
+
+    if ( iCurNumBlocks > 0 )
+    {
+        iAverageLoad = static_cast<int> ( static_cast<int64_t> ( iCurSumUs ) *
+            100 / ( static_cast<int64_t> ( iCurNumBlocks ) * iBlockDurationUs ) );
+
+        iPeakLoad = static_cast<int> ( static_cast<int64_t> ( iCurMaxUs ) *
+            100 / iBlockDurationUs );
+    }
+    else
+    {
+        iAverageLoad = -1;
+        iPeakLoad    = -1;
+    }
 }
 
 
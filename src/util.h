@@ -36,6 +36,9 @@
 #include <QDesktopServices>
 #include <QUrl>
 #include <QLocale>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QElapsedTimer>
 #include <vector>
 #include "global.h"
 using namespace std; // because of the library: "vector"
@@ -83,6 +86,46 @@ inline int CalcBitRateBitsPerSecFromCodedBytes ( const int iCeltNumCodedBytes )
         SYSTEM_FRAME_SIZE_SAMPLES;
 }
 
+// atomic loads and stores (Qt 4 has no plain atomic load and store, there a
+// read-modify-write operation with the same memory ordering is used)
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+inline int AtomicLoadRelaxed ( const QAtomicInt& iValue )
+    { return const_cast<QAtomicInt&> ( iValue ).fetchAndAddRelaxed ( 0 ); }
+
+inline int AtomicLoadAcquire ( const QAtomicInt& iValue )
+    { return const_cast<QAtomicInt&> ( iValue ).fetchAndAddAcquire ( 0 ); }
+
+inline void AtomicStoreRelease ( QAtomicInt& iValue, const int iNewValue )
+    { iValue.fetchAndStoreRelease ( iNewValue ); }
+
+template<class T> inline T* AtomicLoadRelaxed ( const QAtomicPointer<T>& pValue )
+    { return const_cast<QAtomicPointer<T>&> ( pValue ).fetchAndAddRelaxed ( 0 ); }
+
+template<class T> inline T* AtomicLoadAcquire ( const QAtomicPointer<T>& pValue )
+    { return const_cast<QAtomicPointer<T>&> ( pValue ).fetchAndAddAcquire ( 0 ); }
+
+template<class T> inline void AtomicStoreRelease ( QAtomicPointer<T>& pValue, T* pNewValue )
+    { pValue.fetchAndStoreRelease ( pNewValue ); }
+#else
+inline int AtomicLoadRelaxed ( const QAtomicInt& iValue )
+    { return iValue.load(); }
+
+inline int AtomicLoadAcquire ( const QAtomicInt& iValue )
+    { return iValue.loadAcquire(); }
+
+inline void AtomicStoreRelease ( QAtomicInt& iValue, const int iNewValue )
+    { iValue.storeRelease ( iNewValue ); }
+
+template<class T> inline T* AtomicLoadRelaxed ( const QAtomicPointer<T>& pValue )
+    { return pValue.load(); }
+
+template<class T> inline T* AtomicLoadAcquire ( const QAtomicPointer<T>& pValue )
+    { return pValue.loadAcquire(); }
+
+template<class T> inline void AtomicStoreRelease ( QAtomicPointer<T>& pValue, T* pNewValue )
+    { pValue.storeRelease ( pNewValue ); }
+#endif
+
 
 
 /******************************************************************************\
@@ -465,7 +508,6 @@ enum EGetDataStat
 {
     GS_BUFFER_OK,
     GS_BUFFER_UNDERRUN,
-    GS_CHAN_NOW_DISCONNECTED,
     GS_CHAN_NOT_CONNECTED
 };
 
@@ -496,15 +538,15 @@ class CStereoSignalLevelMeter
 public:
     CStereoSignalLevelMeter() { Reset(); }
 
-    void   Update ( CVector<short>& vecsAudio );
+    void   Update ( CVector<float>& vecfAudio );
     double MicLevelLeft()  { return CalcLogResult ( dCurLevelL ); }
     double MicLevelRight() { return CalcLogResult ( dCurLevelR ); }
     void   Reset()         { dCurLevelL = 0.0; dCurLevelR = 0.0; }
 
 protected:
     double CalcLogResult  ( const double& dLinearLevel );
-    double UpdateCurLevel ( double       dCurLevel,
-                            const short& sMax );
+    double UpdateCurLevel ( double      dCurLevel,
+                            const float fMax );
 
     double dCurLevelL;
     double dCurLevelR;
@@ -871,42 +913,151 @@ public:
 
 
 // Audio reverbration ----------------------------------------------------------
+// The reverberation processes blocks of interleaved stereo samples. Each delay
+// line is a contiguous circular buffer of interleaved stereo samples so that
+// both channels are computed together (two lanes which can be vectorized by
+// the compiler).
 class CAudioReverb
 {
 public:
     CAudioReverb() {}
     
-    void   Init ( const int iSampleRate, const double rT60 = (double) 5.0 );
-    void   Clear();
-    double ProcessSample ( const double input );
+    void Init ( const int iSampleRate, const double rT60 = (double) 5.0 );
+    void Clear();
+
+    // the reverberation signal is added to the input signal with the gain of
+    // the respective channel (in and out may point to the same buffer), a
+    // channel with zero gain is not processed
+    void Process ( const float* pfIn,
+                   float*       pfOut,
+                   const int    iNumFrames,
+                   const float  fGainLeft,
+                   const float  fGainRight );
 
 protected:
+    class CDelayLine
+    {
+    public:
+        CDelayLine() : pfCur ( NULL ), pfEnd ( NULL ) {}
+
+        void Init ( const int iNewLength )
+        {
+            vecfBuf.Init ( 2 * iNewLength /* stereo */ );
+            Clear();
+        }
+
+        void Clear()
+        {
+            vecfBuf.Reset ( 0 );
+            pfCur = &vecfBuf[0];
+            pfEnd = pfCur + vecfBuf.Size();
+        }
+
+        int Length() const { return vecfBuf.Size() / 2; }
+
+        // the current stereo sample is the oldest one, it is overwritten by
+        // the newest sample before advancing
+        float* Cur() { return pfCur; }
+        void Advance()
+        {
+            pfCur += 2;
+
+            if ( pfCur == pfEnd )
+            {
+                pfCur = &vecfBuf[0];
+            }
+        }
+
+    protected:
+        CVector<float> vecfBuf;
+        float*         pfCur;
+        float*         pfEnd;
+    };
+
     void setT60 ( const double rT60, const int iSampleRate );
     bool isPrime ( const int number );
 
-    CFIFO<int>  allpassDelays_[3];
-    CFIFO<int>  combDelays_[4];
-    double      allpassCoefficient_;
-    double      combCoefficient_[4];
+    CDelayLine allpassDelays_[3];
+    CDelayLine combDelays_[4];
+    float      allpassCoefficient_;
+    float      combCoefficient_[4];
+};
+
+
+// Audio processing load meter -------------------------------------------------
+// The processing time of each audio block is measured relative to the block
+// duration, i.e., the time which is available for processing the block. An
+// overrun is a sound card block for which no processed audio was available in
+// time. The values are written by the audio threads and read by the GUI
+// thread, therefore atomic variables are used.
+class CAudioLoadMeter
+{
+public:
+    CAudioLoadMeter() : iBlockDurationUs ( 1 ), iProcTimeSumUs ( 0 ),
+        iProcTimeMaxUs ( 0 ), iNumBlocks ( 0 ), iNumOverruns ( 0 ) {}
+
+    void Init ( const int iBlockSizeSamples );
+
+    // must be called in the audio processing thread before and after the
+    // processing of a block
+    void StartBlock() { ElapsedTimer.start(); }
+    void StopBlock();
+
+    // may be called in the audio callback (wait-free)
+    void AddOverrun() { iNumOverruns.ref(); }
+
+    // average and peak load in percent since the last call (-1 if no block
+    // was processed in the meantime)
+    void GetAndResetLoad ( int& iAverageLoad, int& iPeakLoad );
+    int GetNumOverruns() const { return iNumOverruns.loadAcquire(); }
+
+protected:
+    QElapsedTimer ElapsedTimer;
+    int           iBlockDurationUs;
+    QAtomicInt    iProcTimeSumUs;
+    QAtomicInt    iProcTimeMaxUs;
+    QAtomicInt    iNumBlocks;
+    QAtomicInt    iNumOverruns;
 };
 
 
 // CRC -------------------------------------------------------------------------
+// CRC-16 with the generator polynomial x^16 + x^12 + x^5 + 1, the shift
+// register is initialized with ones and the result is inverted. The byte-wise
+// processing is done with a look-up table.
 class CCRC
 {
 public:
-    CCRC() : iPoly ( ( 1 << 5 ) | ( 1 << 12 ) ), iBitOutMask ( 1 << 16 )
-        { Reset(); }
+    CCRC() { Reset(); }
 
     void Reset();
-    void AddByte ( const uint8_t byNewInput );
+    void AddByte ( const uint8_t byNewInput )
+    {
+        iStateShiftReg = static_cast<uint16_t> ( ( iStateShiftReg << 8 ) ^
+            pCRCTable[( iStateShiftReg >> 8 ) ^ byNewInput] );
+    }
+
+    void AddBytes ( const uint8_t* pbyNewInput, const size_t iNumBytes );
     bool CheckCRC ( const uint32_t iCRC ) { return iCRC == GetCRC(); }
     uint32_t GetCRC();
 
+    // The shift register is linear: the state after adding n bytes is the
+    // state after adding n zero bytes (a linear operator applied on the start
+    // state) XOR the state after adding the same bytes on a zero start state.
+    // With this, a CRC of a fixed message body can be combined with different
+    // headers without processing the body again.
+    uint16_t GetState() const { return iStateShiftReg; }
+    void SetState ( const uint16_t iNewState ) { iStateShiftReg = iNewState; }
+
+    static void GetZeroBytesOperator ( const size_t iNumBytes,
+                                       uint16_t*    pOperator );
+
+    static uint16_t ApplyOperator ( const uint16_t* pOperator,
+                                    const uint16_t  iState );
+
 protected:
-    uint32_t iPoly;
-    uint32_t iBitOutMask;
-    uint32_t iStateShiftReg;
+    static const uint16_t pCRCTable[256];
+    uint16_t              iStateShiftReg;
 };
 
 
@@ -1038,4 +1189,55 @@ protected:
     bool            bPreviousState;
 };
 
+
+// Cycle time variance measurement ---------------------------------------------
+// The time stamps are given in nanoseconds. For the network packets we use the
+// kernel receive time stamps (if available) so that the measurement is not
+// influenced by the delay of our own event loop.
+class CCycleTimeVariance
+{
+public:
+    CCycleTimeVariance() : iLastTimeStampNs ( 0 ) {}
+
+    void Init ( const int iHistoryLength )
+    {
+        // the "no data result" is zero which means no variance
+        DeviationMovAvBuf.Init ( iHistoryLength, 0.0 );
+        iLastTimeStampNs = 0;
+    }
+
+    void Reset()
+    {
+        DeviationMovAvBuf.Reset();
+        iLastTimeStampNs = 0;
+    }
+
+    void Update ( const int64_t iTimeStampNs,
+                  const double  dNominalCycleTimeMs )
+    {
+        // we need a previous time stamp to calculate the cycle time, time
+        // stamps which go backwards (e.g. system time was changed) are ignored
+        if ( ( iLastTimeStampNs != 0 ) && ( iTimeStampNs >= iLastTimeStampNs ) )
+        {
+            const double dDeviationMs =
+                static_cast<double> ( iTimeStampNs - iLastTimeStampNs ) / 1000000 -
+                dNominalCycleTimeMs;
+
+            DeviationMovAvBuf.Add ( dDeviationMs * dDeviationMs );
+        }
+
+        iLastTimeStampNs = iTimeStampNs;
+    }
+
+    // root mean square deviation of the cycle time from the nominal cycle
+    // time (this is not the standard deviation since a constant offset of
+    // the mean cycle time is included)
+    double GetRmsJitterMs() { return sqrt ( DeviationMovAvBuf.GetAverage() ); }
+    double InitializationState() { return DeviationMovAvBuf.InitializationState(); }
+
+protected:
+    CMovingAv<double> DeviationMovAvBuf;
+    int64_t           iLastTimeStampNs;
+};
+
 #endif /* !defined ( UTIL_HOIH934256GEKJH98_3_43445KJIUHF1912__INCLUDED_ ) */
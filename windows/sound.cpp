@@ -335,8 +335,9 @@ int CSound::Init ( const int iNewPrefMonoBufferSize )
         // set the sample rate
         ASIOSetSampleRate ( SYSTEM_SAMPLE_RATE_HZ );
 
-        // create memory for intermediate audio buffer
+        // create memory for intermediate audio buffers
         vecsTmpAudioSndCrdStereo.Init ( iASIOBufferSizeStereo );
+        vecfTmpAudioSndCrdStereo.Init ( iASIOBufferSizeStereo );
 
         // create and activate ASIO buffers (buffer size in samples),
         // dispose old buffers (if any)
@@ -397,7 +398,7 @@ void CSound::Stop()
     }
 }
 
-CSound::CSound ( void (*fpNewCallback) ( CVector<int16_t>& psData, void* arg ), void* arg ) :
+CSound::CSound ( void (*fpNewCallback) ( CVector<float>& vecfData, void* arg ), void* arg ) :
     CSoundBase              ( "ASIO", true, fpNewCallback, arg ),
     vSelectedInputChannels  ( NUM_IN_OUT_CHANNELS ),
     vSelectedOutputChannels ( NUM_IN_OUT_CHANNELS ),
@@ -703,8 +704,21 @@ void CSound::bufferSwitch ( long index, ASIOBool )
             }
         }
 
-        // call processing callback function
-        pSound->ProcessCallback ( pSound->vecsTmpAudioSndCrdStereo );
+        // call processing callback function (the ASIO sample formats are
+        // converted to 16 bit above, the processing uses float samples)
+        for ( iCurSample = 0; iCurSample < pSound->iASIOBufferSizeStereo; iCurSample++ )
+        {
+            pSound->vecfTmpAudioSndCrdStereo[iCurSample] = static_cast<float> (
+                pSound->vecsTmpAudioSndCrdStereo[iCurSample] ) / _MAXSHORT;
+        }
+
+        pSound->ProcessCallback ( pSound->vecfTmpAudioSndCrdStereo );
+
+        for ( iCurSample = 0; iCurSample < pSound->iASIOBufferSizeStereo; iCurSample++ )
+        {
+            pSound->vecsTmpAudioSndCrdStereo[iCurSample] = Double2Short (
+                pSound->vecfTmpAudioSndCrdStereo[iCurSample] * _MAXSHORT );
+        }
 
         // PLAYBACK ------------------------------------------------------------
         for ( int i = NUM_IN_OUT_CHANNELS; i < 2 * NUM_IN_OUT_CHANNELS; i++ )
@@ -48,7 +48,7 @@
 class CSound : public CSoundBase
 {
 public:
-    CSound ( void (*fpNewCallback) ( CVector<int16_t>& psData, void* arg ), void* arg );
+    CSound ( void (*fpNewCallback) ( CVector<float>& vecfData, void* arg ), void* arg );
     virtual ~CSound() { UnloadCurrentDriver(); }
 
     virtual int  Init ( const int iNewPrefMonoBufferSize );
@@ -89,6 +89,7 @@ protected:
     CVector<int>     vSelectedOutputChannels;
 
     CVector<int16_t> vecsTmpAudioSndCrdStereo;
+    CVector<float>   vecfTmpAudioSndCrdStereo;
 
     QMutex           ASIOMutex;
 